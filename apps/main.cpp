@@ -3,33 +3,253 @@
 #include <boost/program_options/options_description.hpp>
 #include <boost/program_options/positional_options.hpp>
 #include <boost/program_options/variables_map.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "BNFParser.h"
 #include "CodeGenerator.h"
 #include "Entities.h"
+#include "GrammarAnalyzer.h"
+#include "GrammarOptimizer.h"
 #include "LexerGenerator.h"
 #include "ParserGenerator.h"
 #include "TableBuilder.h"
 
+namespace {
+/**
+ * @brief A grammar to generate a parser for, and where to.
+ */
+struct Job {
+    std::string input;
+    std::string folder;
+    std::string ns;
+};
+
+/**
+ * @brief The parser options shared by all grammars.
+ */
+struct ParserOptions {
+    bool json_tree;
+    size_t indent;
+    bool parallel_lexer;
+    bool utf8;
+    bool optimize;
+    bool left_recursion;
+};
+
+/**
+ * @brief A grammar along with its analysis and tables, kept in watch mode for
+ * the next build to start from. The objects refer to each other, hence the
+ * pointers.
+ */
+struct Build {
+    std::unique_ptr<Grammar> grammar;
+    std::unique_ptr<GrammarAnalyzer> analyzer;
+    std::unique_ptr<ParserTables> tables;
+};
+
+/**
+ * @brief Generates the parser of one grammar.
+ * @details Nothing is printed: the messages go to `log`, so that grammars
+ * generated on several threads report in whole blocks.
+ * @param build If given, the previous build of the grammar: only what the
+ * edit since it affects is recomputed, the folder is overwritten, and the
+ * build is replaced with this one on success.
+ * @return The exit status of `gen` for this grammar.
+ */
+int Generate(
+    const Job &job, const ParserOptions &opts, std::ostream &log,
+    Build *build = nullptr
+) {
+    auto in = std::make_unique<std::ifstream>(job.input);
+    if (!in->is_open()) {
+        log << "Could not open " << job.input << std::endl;
+        return 1;
+    }
+    GrammarParser gp(std::move(in));
+    try {
+        gp.Parse();
+    } catch (const GrammarParserError &e) {
+        log << "GrammarParserError" << e.what() << std::endl;
+        return 2;
+    }
+    for (const std::string &warning : gp.GetWarnings()) {
+        log << warning << std::endl;
+    }
+
+    // every phase borrows the results of the previous ones or takes them
+    // over, so nothing is copied on the way from the grammar to the code
+    auto g = std::make_unique<Grammar>(gp.Take());
+    if (opts.optimize) {
+        OptimizerOptions options;
+        options.left_recursion = opts.left_recursion;
+        GrammarOptimizer optimizer(std::move(*g), options);
+        try {
+            optimizer.Optimize();
+        } catch (const GrammarOptimizerError &e) {
+            log << "GrammarOptimizerError: " << e.what() << std::endl;
+            return 7;
+        }
+        for (const std::string &change : optimizer.GetReport()) {
+            log << change << std::endl;
+        }
+        *g = optimizer.Take();
+    }
+
+    bool incremental = build != nullptr && build->tables != nullptr;
+    auto ga = incremental
+                  ? std::make_unique<GrammarAnalyzer>(*g, *build->analyzer)
+                  : std::make_unique<GrammarAnalyzer>(*g);
+    auto tables =
+        incremental
+            ? std::make_unique<ParserTables>(*g, *ga, *build->tables)
+            : std::make_unique<ParserTables>(*g, *ga);
+    try {
+        tables->Generate();
+    } catch (const std::exception &e) {
+        log << "TableGeneratorError: " << e.what() << std::endl;
+        return 3;
+    }
+
+    if (build == nullptr) {
+        // only the next build in watch mode starts from the automaton
+        tables->ReleaseAutomaton();
+    }
+    const ActionTable &at = tables->GetActionTable();
+    const GotoTable &gt = tables->GetGotoTable();
+    const FollowSets &fs = ga->GetFollow();
+
+    try {
+        CodeGenerator codegen(
+            job.folder, at, gt, fs, *g, opts.json_tree, opts.indent,
+            opts.parallel_lexer, opts.utf8, job.ns, build != nullptr
+        );
+        codegen.Generate();
+    } catch (const CodeGeneratorError &e) {
+        log << "CodeGeneratorError: " << e.what() << std::endl;
+        return 4;
+    } catch (const LexerGeneratorError &e) {
+        log << "LexerGeneratorError: " << e.what() << std::endl;
+        return 5;
+    } catch (const ParserGeneratorError &e) {
+        log << "ParserGeneratorError: " << e.what() << std::endl;
+        return 6;
+    } catch (const std::exception &e) {
+        log << "Unknown error: " << e.what() << std::endl;
+        return -1;
+    }
+    if (build != nullptr) {
+        // the previous build is released only now, the new one referred to it
+        build->tables = std::move(tables);
+        build->analyzer = std::move(ga);
+        build->grammar = std::move(g);
+    }
+    return 0;
+}
+
+/**
+ * @brief Regenerates the parser of a grammar each time its file changes,
+ * starting every build from the previous successful one. Never returns.
+ */
+[[noreturn]] void Watch(const Job &job, const ParserOptions &opts) {
+    constexpr auto kPollInterval = std::chrono::milliseconds(200);
+    Build build;
+    std::optional<std::filesystem::file_time_type> last_write;
+    while (true) {
+        std::error_code error;
+        auto write_time = std::filesystem::last_write_time(job.input, error);
+        if (error || write_time == last_write) {
+            std::this_thread::sleep_for(kPollInterval);
+            continue;
+        }
+        last_write = write_time;
+        auto start = std::chrono::steady_clock::now();
+        if (Generate(job, opts, std::cerr, &build) == 0) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start
+            );
+            std::cout << "Generated " << job.folder << " in " << elapsed.count()
+                      << " ms" << std::endl;
+        }
+    }
+}
+
+/**
+ * @brief The folder of a grammar generated along with others: a subfolder of
+ * `--generate-to` named after the grammar file.
+ */
+std::string DefaultFolder(const std::string &generate_to, const std::string &input) {
+    return (std::filesystem::path(generate_to) / std::filesystem::path(input).stem())
+        .string();
+}
+
+/**
+ * @brief Reads a manifest: one grammar per line, as `<input> [<folder>
+ * [<namespace>]]`. Blank lines and lines starting with `#` are skipped.
+ * @return false if the manifest cannot be opened.
+ */
+bool ReadManifest(
+    const std::string &filename, const std::string &generate_to,
+    const std::string &ns, std::vector<Job> &jobs
+) {
+    std::ifstream in(filename);
+    if (!in.is_open()) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        Job job;
+        if (!(fields >> job.input) || job.input.starts_with('#')) {
+            continue;
+        }
+        if (!(fields >> job.folder)) {
+            job.folder = DefaultFolder(generate_to, job.input);
+        }
+        if (!(fields >> job.ns)) {
+            job.ns = ns;
+        }
+        jobs.push_back(job);
+    }
+    return true;
+}
+}  // namespace
+
 int main(int argc, char **argv) {
     namespace po = boost::program_options;
 
     po::options_description desc("Parser generator options");
     desc.add_options()
         ("help", "produce help message")
-        ("input", po::value<std::string>(), "input grammar file")
-        ("generate-to", po::value<std::string>()->default_value("."), "relative path to a folder a parser will be generated to");
+        ("input", po::value<std::vector<std::string>>(), "input grammar files")
+        ("generate-to", po::value<std::string>()->default_value("."), "relative path to a folder a parser will be generated to; with several grammars, each one goes to a subfolder named after its file")
+        ("manifest", po::value<std::string>(), "file listing grammars to generate, one `<input> [<folder> [<namespace>]]` per line")
+        ("jobs,j", po::value<size_t>()->default_value(std::max(std::thread::hardware_concurrency(), 1u)), "number of grammars generated at once")
+        ("watch", "regenerate the parser each time the grammar file changes, recomputing only what the edit affects");
 
     po::options_description parser_opts("Parser options");
     parser_opts.add_options()
         ("json-tree", "include support for generating a parse tree to a JSON file (adds `nlohmann/json` dependency)")
-        ("indent", po::value<size_t>()->default_value(4), "amount of spaces per indent in a JSON generated by the parser");
+        ("indent", po::value<size_t>()->default_value(4), "amount of spaces per indent in a JSON generated by the parser")
+        ("parallel-lexer", "include functions that lex large inputs on several threads (`LexParallel`, `LexPackedParallel`)")
+        ("utf8", "make the lexer reject input that is not valid UTF-8 (adds `FindInvalidUtf8`)")
+        ("optimize", "simplify the grammar before building the tables: remove unreachable and unproductive non-terminals, merge identical ones and inline those used once (changes the shape of the parse tree)")
+        ("left-recursion", "with --optimize, also rewrite right-recursive non-terminals into left-recursive lists")
+        ("namespace", po::value<std::string>()->default_value("p"), "namespace of the generated lexer and parser, e.g. `grammars::json`");
 
     po::positional_options_description positional_opts;
-    positional_opts.add("input", 1);
+    positional_opts.add("input", -1);
 
     po::options_description all_opts;
     all_opts.add(desc).add(parser_opts);
@@ -44,58 +264,97 @@ int main(int argc, char **argv) {
     po::notify(vm);
 
     if (argc < 2 || vm.count("help")) {
-        std::cout << "Usage: " << argv[0] << " [options] <input>" << std::endl;
+        std::cout << "Usage: " << argv[0] << " [options] <input>..." << std::endl;
         std::cout << desc << std::endl;
         std::cout << parser_opts << std::endl;
         return 0;
     }
-    if (!vm.contains("input")) {
+
+    std::string generate_to = vm["generate-to"].as<std::string>();
+    std::string ns = vm["namespace"].as<std::string>();
+    std::vector<std::string> inputs;
+    if (vm.contains("input")) {
+        inputs = vm["input"].as<std::vector<std::string>>();
+    }
+    std::vector<Job> jobs;
+    if (inputs.size() == 1 && !vm.contains("manifest")) {
+        jobs.push_back(Job{inputs[0], generate_to, ns});
+    } else {
+        for (const std::string &input : inputs) {
+            jobs.push_back(Job{input, DefaultFolder(generate_to, input), ns});
+        }
+    }
+    if (vm.contains("manifest")) {
+        std::string manifest = vm["manifest"].as<std::string>();
+        if (!ReadManifest(manifest, generate_to, ns, jobs)) {
+            std::cerr << "Could not open manifest " << manifest << std::endl;
+            return 1;
+        }
+    }
+    if (jobs.empty()) {
         std::cerr << "No input file specified" << std::endl;
         return 1;
     }
 
-    std::string filename = vm["input"].as<std::string>();
-    GrammarParser gp(std::make_unique<std::ifstream>(filename));
-    try {
-        gp.Parse();
-    } catch (const GrammarParserError &e) {
-        std::cerr << "GrammarParserError" << e.what() << std::endl;
-        return 2;
+    ParserOptions opts{
+        vm.count("json-tree") > 0, vm["indent"].as<size_t>(),
+        vm.count("parallel-lexer") > 0, vm.count("utf8") > 0,
+        vm.count("optimize") > 0, vm.count("left-recursion") > 0
+    };
+    if (vm.count("watch")) {
+        if (jobs.size() != 1) {
+            std::cerr << "--watch takes a single grammar" << std::endl;
+            return 1;
+        }
+        Watch(jobs[0], opts);
     }
-
-    Grammar g = gp.Get();
-
-    GrammarAnalyzer ga(g);
-    ParserTables tables(g, ga);
-    try {
-        tables.Generate();
-    } catch (const std::exception &e) {
-        std::cerr << "TableGeneratorError: " << e.what() << std::endl;
-        return 3;
+    if (jobs.size() == 1) {
+        return Generate(jobs[0], opts, std::cerr);
     }
 
-    ActionTable at = tables.GetActionTable();
-    GotoTable gt = tables.GetGotoTable();
-    FollowSets fs = ga.GetFollow();
+    // the grammars are independent, so they are generated by a pool of
+    // workers taking the next one in turn; each reports once it is done
+    std::vector<int> statuses(jobs.size());
+    std::atomic<size_t> next = 0;
+    std::mutex report;
+    auto worker = [&]() {
+        for (size_t i = next++; i < jobs.size(); i = next++) {
+            std::ostringstream log;
+            statuses[i] = Generate(jobs[i], opts, log);
+            std::string messages = log.str();
+            if (messages.empty()) {
+                continue;
+            }
+            std::ostringstream block;
+            std::istringstream lines(messages);
+            std::string line;
+            while (std::getline(lines, line)) {
+                block << jobs[i].input << ": " << line << '\n';
+            }
+            std::lock_guard<std::mutex> lock(report);
+            std::cerr << block.str() << std::flush;
+        }
+    };
+    std::vector<std::thread> pool;
+    size_t workers = std::min(std::max<size_t>(vm["jobs"].as<size_t>(), 1), jobs.size());
+    for (size_t i = 1; i < workers; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread &thread : pool) {
+        thread.join();
+    }
 
-    try {
-        CodeGenerator codegen(
-            vm["generate-to"].as<std::string>(), at, gt, fs, g,
-            vm.count("json-tree"), vm["indent"].as<size_t>()
-        );
-        codegen.Generate();
-    } catch (const CodeGeneratorError &e) {
-        std::cerr << "CodeGeneratorError: " << e.what() << std::endl;
-        return 4;
-    } catch (const LexerGeneratorError &e) {
-        std::cerr << "LexerGeneratorError: " << e.what() << std::endl;
-        return 5;
-    } catch (const ParserGeneratorError &e) {
-        std::cerr << "ParserGeneratorError: " << e.what() << std::endl;
-        return 6;
-    } catch (const std::exception &e) {
-        std::cerr << "Unknown error: " << e.what() << std::endl;
-        return -1;
+    // the status of the first grammar that failed, so that scripts still see
+    // what went wrong
+    size_t failed = std::count_if(statuses.begin(), statuses.end(), [](int s) {
+        return s != 0;
+    });
+    if (failed == 0) {
+        return 0;
     }
-    return 0;
+    std::cerr << failed << " of " << jobs.size() << " grammars failed" << std::endl;
+    return *std::find_if(statuses.begin(), statuses.end(), [](int s) {
+        return s != 0;
+    });
 }
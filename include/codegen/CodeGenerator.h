@@ -39,6 +39,8 @@ class CodeGenerator {
 public:
     /**
      * @brief Constructs a CodeGenerator object with the specified parameters.
+     * @details The tables, the sets and the grammar are borrowed rather than
+     * copied, so they must outlive the generator.
      * @param folder The folder to generate the code to.
      * @param at The action table to use for the generated code
      * @param gt The goto table to use for the generated code.
@@ -48,11 +50,23 @@ public:
      * the generated parser.
      * @param json_indents The number of indents to use for the JSON parse tree
      * (if it is generated).
+     * @param add_parallel_lexer Whether to add functions that lex a buffer on
+     * several threads to the generated lexer.
+     * @param validate_utf8 Whether the generated lexer rejects input that is
+     * not valid UTF-8.
+     * @param ns The namespace to put the generated code into, e.g. `p` or
+     * `grammars::json`. Grammars generated into different namespaces can be
+     * linked into one program.
+     * @param overwrite Whether the folder may already exist, the files in it
+     * being replaced.
+     * @throws CodeGeneratorError if `ns` is not a valid namespace name, or if
+     * the folder cannot be created.
      */
     CodeGenerator(
-        const std::string &folder, ActionTable &at, GotoTable &gt,
-        FollowSets &fs, const Grammar &g, bool add_json_generator,
-        size_t json_indents
+        const std::string &folder, const ActionTable &at, const GotoTable &gt,
+        const FollowSets &fs, const Grammar &g, bool add_json_generator,
+        size_t json_indents, bool add_parallel_lexer, bool validate_utf8,
+        const std::string &ns, bool overwrite = false
     );
 
     /**
@@ -65,10 +79,13 @@ public:
 
 private:
     std::string folder_;
-    Grammar g_;
-    ActionTable &at_;
-    GotoTable &gt_;
-    FollowSets &fs_;
+    const Grammar &g_;
+    const ActionTable &at_;
+    const GotoTable &gt_;
+    const FollowSets &fs_;
     bool add_json_generator_;
     size_t json_indents_;
+    bool add_parallel_lexer_;
+    bool validate_utf8_;
+    std::string namespace_;
 };
\ No newline at end of file
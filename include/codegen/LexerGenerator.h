@@ -6,9 +6,16 @@
  */
 #pragma once
 
+#include <cstdint>
+#include <ostream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "Entities.h"
+#include "LexerDFA.h"
+#include "Regex.h"
+#include "SymbolTable.h"
 
 /**
  * @class LexerGeneratorError
@@ -43,19 +50,169 @@ public:
      * @brief Constructs a LexerGenerator object.
      * @param folder A folder that the lexer is generated to.
      * @param g The grammar to generated the lexer for.
+     * @param symbols The ids of the symbols of the grammar.
+     * @param add_parallel_driver Whether to add functions that lex a buffer on
+     * several threads.
+     * @param validate_utf8 Whether the lexer rejects input that is not valid
+     * UTF-8.
+     * @param ns The namespace to put the generated code into.
      */
-    LexerGenerator(const std::string &folder, const Grammar &g);
+    LexerGenerator(
+        const std::string &folder, const Grammar &g,
+        const SymbolTable &symbols, bool add_parallel_driver,
+        bool validate_utf8, const std::string &ns
+    );
 
     /**
      * @brief Generates the lexer.
-     * @throws LexerGeneratorError if an error occurs during the generation of
-     * the lexer.
-     * @note The lexer is generated using `flex` utility that often comes
-     * preinstalled with UNIX-based systems.
+     * @details The terminal definitions and the IGNORE rules are compiled into
+     * a minimal DFA (see `LexerDFA`), which is written out as a table-driven
+     * scanner with longest-match semantics. On equal match lengths quote
+     * terminals win over regex terminals and those win over ignored input.
+     * States that loop on a few ranges of bytes (or on all bytes but a few
+     * ranges) consume runs of such bytes with SSE2 or AVX2, picked at run
+     * time, and fall back to a scalar loop on other targets.
+     *
+     * When the transition table would outgrow `kMaxKeywordTableSize`, quote
+     * terminals that a regex terminal matches as a whole (keywords matched as
+     * identifiers) are left out of the DFA. They are lexed as that terminal
+     * and recognized by a lookup in a perfect hash table (see `KeywordTable`),
+     * which keeps the table small for grammars with many keywords.
+     *
+     * If requested, functions that lex a buffer on several threads are added:
+     * every thread lexes a chunk of the buffer from the byte after a newline,
+     * and the chunks are joined where the scan of the preceding input meets a
+     * token of the chunk, relexing only the input before that token.
+     *
+     * If requested, the lexer checks that its input is valid UTF-8 before
+     * scanning it, with the lookup algorithm of Keiser and Lemire on AVX2 and
+     * an ASCII fast path on SSE2, and throws `LexerError` with the position of
+     * the first malformed sequence otherwise. Regexes may match Unicode
+     * characters either way (see `RegexParser`).
+     *
+     * An edited buffer is lexed incrementally by `Relex`: the scan is resumed
+     * after the last token that no scan reaching the edit started before, as
+     * checked by running the DFA from all of its states over the bytes up to
+     * the edit, and stops where it starts a token that the previous scan
+     * started at too.
+     *
+     * The scanner is a `Lexer` class that keeps all of its state, so any
+     * number of them may run concurrently; together with the tables and the
+     * token types it is put into the namespace passed to the constructor.
+     * @throws LexerGeneratorError if a regex of the grammar is malformed.
      */
     void Generate();
 
 private:
+    /**
+     * @brief The largest number of byte ranges a fast path of the scanner
+     * checks.
+     */
+    static constexpr size_t kMaxRunRanges = 3;
+    /**
+     * @brief The size in bytes of the transition table up to which keywords
+     * stay in the DFA, about the size of an L1 data cache.
+     */
+    static constexpr size_t kMaxKeywordTableSize = 32 * 1024;
+
+    /**
+     * @struct Scanner
+     * @brief What the generated scanner is made of, computed once from the
+     * grammar and written out by the `Emit*` methods.
+     */
+    struct Scanner {
+        LexerDFA dfa;
+        /**
+         * @brief Indexed by rule of the DFA: the id of the terminal it lexes,
+         * or -1 for ignored input.
+         */
+        std::vector<int64_t> actions;
+        /**
+         * @brief The keywords left out of the DFA, if any, with the ids of
+         * their terminals and of the terminals they are lexed as.
+         */
+        std::vector<std::string> keywords;
+        std::vector<int64_t> keyword_kinds;
+        std::vector<int64_t> keyword_lexed_as;
+        /**
+         * @brief The sets of bytes the fast paths consume, as initializers of
+         * the generated `ByteRanges`.
+         */
+        std::vector<std::string> run_sets;
+        /**
+         * @brief Indexed by state: the index of its set in `run_sets`, or
+         * `SIZE_MAX` if the state has no fast path.
+         */
+        std::vector<size_t> state_runs;
+    };
+
+    /**
+     * @brief Builds the DFA of the rules of the grammar, leaving keywords out
+     * of it if it gets too large, and finds the states with a fast path.
+     * @throws LexerGeneratorError if a regex of the grammar is malformed.
+     */
+    Scanner BuildScanner() const;
+
+    /**
+     * @brief Emits the byte classes, the transitions and the accepting
+     * states of the DFA.
+     */
+    static void EmitTables(std::ostream &out, const Scanner &scanner);
+    /**
+     * @brief Emits the scalar, SSE2 and AVX2 functions that consume runs of
+     * bytes a state loops on, and the sets of those bytes.
+     */
+    static void EmitRunScanners(std::ostream &out, const Scanner &scanner);
+    /**
+     * @brief Emits the perfect hash table of the keywords left out of the DFA
+     * and `Reclassify`, which looks lexemes up in it.
+     */
+    void EmitKeywordTable(std::ostream &out, const Scanner &scanner) const;
+    /**
+     * @brief Emits the scalar, SSE2 and AVX2 UTF-8 validators.
+     */
+    static void EmitUtf8Validator(std::ostream &out);
+    /**
+     * @brief Emits the `Lexer` class and the `Lex` and `LexPacked` functions.
+     */
+    void EmitLexer(std::ostream &out, const Scanner &scanner) const;
+    /**
+     * @brief Emits `Relex`, which lexes an edited buffer incrementally.
+     */
+    void EmitRelex(std::ostream &out) const;
+    /**
+     * @brief Emits `LexParallel` and `LexPackedParallel`.
+     */
+    void EmitParallelDriver(std::ostream &out) const;
+    /**
+     * @brief Emits `LexerError` and `MappedFile`.
+     */
+    static void EmitMappedFile(std::ostream &out);
+    /**
+     * @brief Emits `LexerFwd.hpp`, the declarations of the token types, of the
+     * lexer and of the functions above.
+     */
+    void EmitHeader(std::ostream &out) const;
+
+    /**
+     * @brief Splits a set of bytes into maximal ranges.
+     * @param bytes The set of bytes.
+     * @return Inclusive ranges of bytes in increasing order.
+     */
+    static std::vector<std::pair<size_t, size_t>> ToRanges(
+        const CharSet &bytes
+    );
+    /**
+     * @brief Computes the size of the transition table of a DFA as generated.
+     * @param dfa The DFA.
+     * @return The size in bytes.
+     */
+    static size_t GetTableSize(const LexerDFA &dfa);
+
     std::string folder_;
     const Grammar &g_;
+    const SymbolTable &symbols_;
+    bool add_parallel_driver_;
+    bool validate_utf8_;
+    std::string namespace_;
 };
\ No newline at end of file
@@ -7,7 +7,11 @@
  */
 #pragma once
 
+#include <cstdint>
+#include <ostream>
+
 #include "Entities.h"
+#include "SymbolTable.h"
 
 /**
  * @class ParserGeneratorError
@@ -42,6 +46,7 @@ public:
      * @brief Constructs a ParserGenerator object with the specified grammar.
      * @param folder The folder to generate the parser to.
      * @param g The grammar to generate the parser for.
+     * @param symbols The ids of the symbols of the grammar.
      * @param at The action table to use for the generated parser.
      * @param gt The goto table to use for the generated parser.
      * @param fs The FOLLOW sets to use for the generated parser.
@@ -49,26 +54,67 @@ public:
      * the generated parser.
      * @param json_indents The number of indents to use for the JSON parse tree
      * (if it is generated).
+     * @param ns The namespace to put the generated code into.
      */
     ParserGenerator(
-        const std::string &folder, const Grammar &g, const ActionTable &at,
-        const GotoTable &gt, const FollowSets &fs, bool add_json_generator,
-        size_t json_indents
+        const std::string &folder, const Grammar &g,
+        const SymbolTable &symbols, const ActionTable &at, const GotoTable &gt,
+        const FollowSets &fs, bool add_json_generator, size_t json_indents,
+        const std::string &ns
     );
 
     /**
      * @brief Generates the parser.
+     * @details The parser is written to `Parser.hpp` and its tables to
+     * `ParserTables.cpp`: the header only declares them, so translation units
+     * including it do not compile the tables again. The header holds only the
+     * tables and their types as a `ParserTables` struct, the parser and the
+     * parse tree are aliases of the templates in `include/runtime` instantiated
+     * with it.
      * @throws ParserGeneratorError if an error occurs during the generation of
      * the parser. Check note for the ParserGeneratorError class for more.
      */
     void Generate();
 
 private:
+    /**
+     * @brief Emits a two-dimensional constant integer array as a static
+     * member of the generated tables class.
+     * @param declaration The stream to write the declaration of the member
+     * to.
+     * @param definition The stream to write the definition of the member to.
+     * @param declarator The name and the dimensions of the array.
+     * @param rows The rows of the array.
+     * @param type The element type. If empty, the smallest unsigned type that
+     * holds every value is used.
+     */
+    static void EmitTable(
+        std::ostream &declaration, std::ostream &definition,
+        const std::string &declarator,
+        const std::vector<std::vector<uint64_t>> &rows,
+        const std::string &type = ""
+    );
+    /**
+     * @brief Emits a one-dimensional constant integer array as a static
+     * member of the generated tables class.
+     * @param declaration The stream to write the declaration of the member
+     * to.
+     * @param definition The stream to write the definition of the member to.
+     * @param declarator The name and the dimension of the array.
+     * @param values The elements of the array.
+     */
+    static void EmitTable(
+        std::ostream &declaration, std::ostream &definition,
+        const std::string &declarator, const std::vector<uint64_t> &values
+    );
+
     std::string folder_;
     const Grammar &g_;
+    const SymbolTable &symbols_;
     const ActionTable &at_;
     const GotoTable &gt_;
     const FollowSets &fs_;
     bool add_json_generator_;
     size_t json_indents_;
+    std::string namespace_;
 };
\ No newline at end of file
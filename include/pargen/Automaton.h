@@ -9,8 +9,11 @@
 
 #include <boost/bimap.hpp>
 #include <cstddef>
+#include <map>
 #include <optional>
 #include <set>
+#include <utility>
+#include <vector>
 
 #include "Entities.h"
 #include "GrammarAnalyzer.h"
@@ -83,9 +86,25 @@ public:
     /**
      * @brief Constructs an Automaton object from Grammar and GrammarAnalyzer.
      * @param g The grammar.
-     * @param ga The grammar analyzer.
+     * @param ga The grammar analyzer. It is borrowed rather than copied, so it
+     * must outlive the automaton.
      */
     Automaton(const Grammar &g, const GrammarAnalyzer &ga);
+    /**
+     * @brief Constructs an Automaton object for an edited grammar, reusing the
+     * closures of the previous automaton that the edit cannot affect.
+     * @details A closure is reused if none of its items expands a
+     * non-terminal whose productions changed or takes lookaheads from a FIRST
+     * set that changed, so only the states reached through changed rules are
+     * computed again. The states are the same as those built from scratch.
+     * @param g The edited grammar.
+     * @param ga The grammar analyzer of the edited grammar.
+     * @param previous The automaton of the grammar before the edit. Its
+     * grammar and analyzer must still be alive.
+     */
+    Automaton(
+        const Grammar &g, const GrammarAnalyzer &ga, const Automaton &previous
+    );
 
     /**
      * @brief Based on whether the current closure has already been computed,
@@ -119,6 +138,31 @@ public:
      */
     std::optional<Token> NextToken(const Item &item) const;
 
+    /**
+     * @brief Returns the state the automaton goes to from a state on a token.
+     * @param state The number of the state to go from.
+     * @param next The next token.
+     * @return The number of the next state, `std::nullopt` if there is no
+     * transition on the token.
+     */
+    std::optional<size_t> GetTransition(size_t state, const Token &next) const;
+
+    /**
+     * @brief Returns how many closures were taken over from the previous
+     * automaton.
+     * @return The number of closures, 0 if the automaton was built from
+     * scratch.
+     */
+    size_t GetReusedClosureCount() const;
+
+    /**
+     * @brief Frees the states, the transitions and the closure cache, which
+     * are only needed to build tables and later automata.
+     * @details An automaton built incrementally from a released one computes
+     * everything from scratch.
+     */
+    void Release();
+
 private:
     /**
      * @brief Helper function to determine whether the dot is at the end of the
@@ -136,17 +180,37 @@ private:
      * @return The closure of the given set of items.
      */
     std::set<Item> InternalClosure(const std::set<Item> &items) const;
+    /**
+     * @brief The transitions out of a state, as the tokens and the kernels of
+     * the states they lead to, in the order they are taken.
+     */
+    using Successors = std::vector<std::pair<Token, State>>;
+
     /**
      * @brief Computes the canonical collection (all possible states of the
      * automaton) for the grammar.
+     * @param known The transitions of the states known from a previous
+     * automaton; the others are computed with `Goto` on every token.
+     */
+    void BuildCanonicalCollection(
+        const std::map<State, Successors> &known = {}
+    );
+    /**
+     * @brief Fills the closure cache with the closures of the previous
+     * automaton that are still valid, renumbering their rules.
+     * @param previous The automaton of the grammar before the edit.
+     * @return The transitions of the previous states. They only depend on the
+     * items of a state, so they hold for any state that is still built.
      */
-    void BuildCanonicalCollection();
+    std::map<State, Successors> ReusePrevious(const Automaton &previous);
 
     const Grammar &g_;
-    GrammarAnalyzer ga_;
+    const GrammarAnalyzer &ga_;
 
     std::unordered_map<ItemSetKey, std::set<Item>, ItemSetKeyHash>
         closure_cache_;
+    size_t reused_closures_ = 0;
 
     StateMap states_;
+    std::vector<std::vector<std::pair<Token, size_t>>> transitions_;
 };
\ No newline at end of file
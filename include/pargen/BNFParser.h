@@ -12,6 +12,10 @@
 #include <istream>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "Entities.h"
 
@@ -47,6 +51,16 @@ private:
  * @details This class provides a mechanism for parsing a user-specified grammar
  * in BNF. It reads the grammar from an input stream and stores the parsed
  * grammar in a Grammar object.
+ *
+ * The stream is read into a buffer at once and scanned by position, and
+ * symbols are looked up in hash tables, so parsing takes time linear in the
+ * size of the grammar.
+ *
+ * Productions may also use the EBNF operators `*`, `+` and `?` and grouping
+ * parentheses. They are desugared into helper non-terminals named after the
+ * rule they occur in (`<value.list1>`, `<value.opt2>`, ...): repetitions
+ * become left-recursive rules, which the parser reduces in constant stack
+ * depth and flattens into a single node, see `Grammar::lists_`.
  */
 class GrammarParser {
 public:
@@ -71,6 +85,21 @@ public:
      */
     const Grammar &Get() const;
 
+    /**
+     * @brief Moves the parsed grammar out of the parser, for the next phase to
+     * own without copying it.
+     * @return The parsed grammar. The parser is left without one.
+     */
+    Grammar Take();
+
+    /**
+     * @brief Returns the warnings issued while parsing, each with its line.
+     * @details The warnings are kept rather than printed, so that grammars may
+     * be parsed on several threads and the caller decides where they go.
+     * @return Const reference to the warnings.
+     */
+    const std::vector<std::string> &GetWarnings() const;
+
 private:
     /**
      * @brief Helper function for throwing an error with line number.
@@ -79,32 +108,28 @@ private:
      */
     void ThrowError(const std::string &msg);
     /**
-     * @brief Helper function for reading a character from stream.
-     * @return The character read from the stream (or EOF if `in_` is peeking at
-     * EOF).
+     * @brief Helper function for reading a character from the buffer.
+     * @return The character read (or EOF at the end of the buffer).
      */
     int GetChar();
     /**
-     * @brief Helper function for reading a character from stream.
+     * @brief Helper function for reading a character from the buffer.
      * @param expected The character that is expected to be read.
-     * @return The character read from the stream (or EOF if `in_` is peeking at
-     * EOF).
+     * @return The character read (or EOF at the end of the buffer).
      * @throws GrammarParserError if the character read is not equal to
      * `expected`.
      */
     int GetChar(int expected);
     /**
-     * @brief Helper function for peeking a character from stream.
-     * @return The character that `in_` is peeking at (or EOF if `in_` is
-     * peeking at EOF).
+     * @brief Helper function for peeking a character from the buffer.
+     * @return The next character (or EOF at the end of the buffer).
      */
     int Peek() const;
     /**
-     * @brief Helper function for comparing a character that `in_` is peeking at
-     * against a desired character.
+     * @brief Helper function for comparing the next character against a
+     * desired character.
      * @param c The character to compare against.
-     * @return true if the character that `in_` is peeking at is equal to `c`,
-     * false otherwise.
+     * @return true if the next character is equal to `c`, false otherwise.
      */
     bool PeekAt(int c) const;
     /**
@@ -126,6 +151,27 @@ private:
      * @todo Change return type to `Production`
      */
     Production ParseProduction();
+    /**
+     * @brief Parses a parenthesized group of alternatives.
+     * @return The alternatives.
+     * @throws GrammarParserError if the group is unterminated or has an empty
+     * alternative.
+     */
+    std::vector<Production> ParseGroup();
+    /**
+     * @brief Parses an EBNF operator, if there is one.
+     * @return `*`, `+`, `?`, or 0 if there is no operator.
+     */
+    int ParseOperator();
+    /**
+     * @brief Replaces an EBNF construct with a helper non-terminal of the
+     * current rule.
+     * @param op The operator applied to the construct, 0 for a plain group.
+     * @param alternatives The alternatives of the construct.
+     * @return The helper non-terminal; its rules are added after the line.
+     * @throws GrammarParserError if an empty alternative is repeated.
+     */
+    NonTerminal Desugar(int op, const std::vector<Production> &alternatives);
     /**
      * @brief Parses a token from the input stream.
      * @return The parsed token.
@@ -142,19 +188,31 @@ private:
     Terminal ParseQuoteTerminal();
     /**
      * @brief Parses a qualifier from the input stream.
-     * @return The parsed qualifier.
+     * @return The parsed qualifier, pointing into the buffer.
+     */
+    std::string_view ParseName();
+    /**
+     * @brief Reads the rest of the line, not including the line break.
+     * @return The rest of the line, pointing into the buffer.
      */
-    std::string ParseName();
+    std::string_view ParseRestOfLine();
     /**
      * @brief Parses a regex for the characters to be ignored by the lexer
      * produced in future.
      */
     void ParseIgnore();
+    /**
+     * @brief Adds a symbol to the grammar, keeping track of the names of the
+     * terminals.
+     * @param token The symbol to add.
+     */
+    void AddToken(const Token &token);
 
     /**
      * @brief Verifies the grammar.
      * @details Currently, this function checks for undefined references to
-     * non-terminals.
+     * non-terminals. The defined ones are collected into a hash set first, so
+     * every reference is checked in constant time.
      */
     void Verify();
 
@@ -167,6 +225,54 @@ private:
     void Augment();
 
     std::unique_ptr<std::istream> in_;
+    /**
+     * @brief The whole input, read by `Parse`.
+     */
+    std::string buffer_;
+    /**
+     * @brief The position of the next character of `buffer_` to read.
+     */
+    size_t pos_ = 0;
     size_t line_ = 0;
     Grammar g_;
+    std::vector<std::string> warnings_;
+    /**
+     * @brief Compares symbols the way `Grammar::tokens_` orders them, so that
+     * the regex of a terminal tells it apart from a reference to it.
+     */
+    struct SameToken {
+        bool operator()(const Token &a, const Token &b) const {
+            return !(a < b) && !(b < a);
+        }
+    };
+
+    /**
+     * @brief The symbols added to the grammar so far.
+     */
+    std::unordered_set<Token, std::hash<Token>, SameToken> added_;
+    /**
+     * @brief The names of the terminals added to the grammar so far, which
+     * references to regex terminals are checked against.
+     */
+    std::unordered_set<std::string> terminal_names_;
+
+    /**
+     * @brief The left-hand side of the rule being parsed, which helper
+     * non-terminals are named after.
+     */
+    NonTerminal lhs_;
+    /**
+     * @brief The rules of the helper non-terminals of the current line, added
+     * after its own so that the first rule still gives the start symbol.
+     */
+    std::vector<Rule> helpers_;
+    /**
+     * @brief The number of helper non-terminals of each rule so far.
+     */
+    std::unordered_map<std::string, size_t> helper_counts_;
+    /**
+     * @brief The number of groups being parsed, in which `)` ends a
+     * production.
+     */
+    size_t group_depth_ = 0;
 };
\ No newline at end of file
@@ -0,0 +1,112 @@
+/**
+ * @file CodePointSet.h
+ * @brief Provides a class for sets of Unicode code points and their UTF-8
+ * encodings.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @class CodePointSet
+ * @brief A set of Unicode scalar values, kept as sorted disjoint ranges.
+ * @details The lexer works on bytes, so a set is matched by the UTF-8
+ * encodings of its members: `ToUtf8Sequences` splits it into sequences of
+ * byte ranges that a DFA over bytes can follow. Surrogates are not scalar
+ * values and are never members.
+ */
+class CodePointSet {
+public:
+    /**
+     * @brief The largest code point.
+     */
+    static constexpr char32_t kMaxCodePoint = 0x10FFFF;
+
+    /**
+     * @brief Alias for an inclusive range of code points.
+     */
+    using Range = std::pair<char32_t, char32_t>;
+    /**
+     * @brief Alias for the encodings of a range of code points of the same
+     * length: the k-th byte of every one of them is in the k-th range.
+     */
+    using ByteSequence = std::vector<std::pair<uint8_t, uint8_t>>;
+
+    /**
+     * @brief Constructs an empty CodePointSet object.
+     */
+    CodePointSet() = default;
+
+    /**
+     * @brief Returns the set of the code points of a Unicode general category.
+     * @param name The name of the category (`L`, `Lu`, `Ll`, `M`, `N`, `Nd`,
+     * `P`, `S`, `Z`), or `Any` or `ASCII`.
+     * @return The set, or `std::nullopt` if the name is unknown.
+     */
+    static std::optional<CodePointSet> FromProperty(const std::string &name);
+
+    /**
+     * @brief Adds an inclusive range of code points.
+     * @param lo The first code point.
+     * @param hi The last code point.
+     */
+    void Add(char32_t lo, char32_t hi);
+    /**
+     * @brief Adds all the code points of another set.
+     * @param other The other set.
+     */
+    void Add(const CodePointSet &other);
+    /**
+     * @brief Replaces the set with its complement among the scalar values.
+     */
+    void Negate();
+
+    /**
+     * @brief Checks whether a code point is in the set.
+     * @param c The code point.
+     * @return Whether `c` is in the set.
+     */
+    bool Contains(char32_t c) const;
+    /**
+     * @brief Returns the sorted disjoint ranges of the set.
+     */
+    const std::vector<Range> &GetRanges() const;
+
+    /**
+     * @brief Splits the UTF-8 encodings of the set into sequences of byte
+     * ranges.
+     * @return Sequences whose languages are disjoint and together are exactly
+     * the encodings of the members.
+     */
+    std::vector<ByteSequence> ToUtf8Sequences() const;
+
+    /**
+     * @brief Encodes a code point in UTF-8.
+     * @param c The code point, at most `kMaxCodePoint`.
+     * @return The 1 to 4 bytes of the encoding.
+     */
+    static std::string EncodeUtf8(char32_t c);
+    /**
+     * @brief Decodes the UTF-8 encoded character at a position of a string.
+     * @param s The string.
+     * @param pos The position; advanced past the character on success.
+     * @return The code point, or `std::nullopt` if the bytes at `pos` are not
+     * a valid encoding.
+     */
+    static std::optional<char32_t> DecodeUtf8(const std::string &s, size_t &pos);
+
+private:
+    /**
+     * @brief Removes the surrogates and merges overlapping and adjacent
+     * ranges.
+     */
+    void Normalize();
+
+    std::vector<Range> ranges_;
+};
@@ -11,6 +11,7 @@
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <variant>
 #include <vector>
 
@@ -162,6 +163,14 @@ struct Grammar {
      * generated in the future.
      */
     std::vector<std::string> ignored_;
+    /**
+     * @brief Stores the helper non-terminals of EBNF repetitions.
+     * @details Their rules are left-recursive, `R -> R ...` or a base case,
+     * and the parser appends the symbols of a recursive one to the node of
+     * `R` instead of nesting it, so a repetition is a single node of the parse
+     * tree.
+     */
+    std::unordered_set<NonTerminal> lists_;
 
     /**
      * @brief Quality of life function for accessing a certain rule.
@@ -7,7 +7,10 @@
  */
 #pragma once
 
+#include <cstddef>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "Entities.h"
@@ -15,6 +18,10 @@
 /**
  * @class GrammarAnalyzer
  * @brief A class for computing FIRST and FOLLOW sets for a given grammar.
+ * @details The sets are computed per strongly connected component of the
+ * dependencies between non-terminals, in such an order that the sets a
+ * component depends on are final by the time it is reached. This is what
+ * allows an edited grammar to recompute only the components the edit affects.
  */
 class GrammarAnalyzer {
 public:
@@ -23,6 +30,17 @@ public:
      * @param g The grammar to construct GrammarAnalyzer from and analyze.
      */
     explicit GrammarAnalyzer(const Grammar &g);
+    /**
+     * @brief Constructs a GrammarAnalyzer object for an edited grammar,
+     * reusing the sets of the previous analysis that the edit cannot affect.
+     * @details A component is recomputed only if the productions of one of its
+     * non-terminals changed or a set it depends on did; otherwise its sets are
+     * copied. The sets are the same as those computed from scratch.
+     * @param g The edited grammar.
+     * @param previous The analysis of the grammar before the edit. Its grammar
+     * must still be alive.
+     */
+    GrammarAnalyzer(const Grammar &g, const GrammarAnalyzer &previous);
 
     /**
      * @brief Using precomputed FIRST sets, computes the FIRST set for a
@@ -44,18 +62,45 @@ public:
     const FollowSets &GetFollow() const;
 
 private:
+    /**
+     * @brief Numbers the non-terminals of the grammar.
+     */
+    void IndexNonTerminals();
+
     /**
      * @brief Computes the FIRST sets for the grammar.
+     * @param previous The previous analysis to reuse sets from, if any.
+     * @param changed The non-terminals whose productions changed since it.
+     * @return Whether the FIRST set of each non-terminal differs from the
+     * previous one.
+     */
+    std::vector<bool> ComputeFirst(
+        const GrammarAnalyzer *previous,
+        const std::unordered_set<NonTerminal> &changed
+    );
+    /**
+     * @brief Adds what a rule contributes to the FIRST set of its LHS.
+     * @return Whether the set grew.
      */
-    void ComputeFirst();
+    bool AddFirst(const Rule &rule);
 
     /**
      * @brief Computes the FOLLOW sets for the grammar.
+     * @param previous The previous analysis to reuse sets from, if any.
+     * @param changed The non-terminals whose productions changed since it.
+     * @param first_changed What `ComputeFirst` returned.
      */
-    void ComputeFollow();
+    void ComputeFollow(
+        const GrammarAnalyzer *previous,
+        const std::unordered_set<NonTerminal> &changed,
+        const std::vector<bool> &first_changed
+    );
 
     const Grammar &g_;
 
+    std::vector<NonTerminal> nonterminals_;
+    std::unordered_map<NonTerminal, size_t> ids_;
+
     FirstSets first_;
     FollowSets follow_;
 };
\ No newline at end of file
@@ -0,0 +1,236 @@
+/**
+ * @file GrammarEngine.h
+ * @brief Provides a class for lexing and parsing with a grammar loaded at run
+ * time, without generating code.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "BatchParser.h"
+#include "Entities.h"
+#include "LRParser.h"
+#include "LineIndex.h"
+#include "ParseTree.h"
+#include "SymbolTable.h"
+#include "TokenStream.h"
+
+/**
+ * @class GrammarEngineError
+ * @brief An exception class for reporting errors in a grammar loaded by
+ * `GrammarEngine` or in the input lexed with it.
+ */
+class GrammarEngineError : public std::exception {
+public:
+    /**
+     * @brief Constructs a GrammarEngineError object with the specified error.
+     * @param msg The error message.
+     */
+    explicit GrammarEngineError(const std::string &msg);
+    /**
+     * @brief Returns the error message.
+     * @return The error message.
+     */
+    const char *what() const noexcept override;
+
+private:
+    std::string msg_;
+};
+
+/**
+ * @class GrammarEngine
+ * @brief Builds the lexer DFA and the parser tables of a grammar in memory and
+ * interprets them.
+ * @details The grammar goes through the same `GrammarParser`,
+ * `GrammarAnalyzer`, `ParserTables` and `LexerDFA` as in `gen`, so the tokens
+ * and trees are the same as those of the generated parser, symbol kinds
+ * included. Parsing is done by the same `pargen::LRParser`, reading the tables
+ * from flat arrays instead of static ones.
+ *
+ * The engine is immutable once built and may be shared by any number of
+ * threads; parsers and lexers refer to its tables, so it must outlive them.
+ */
+class GrammarEngine {
+public:
+    struct Terminal {
+        uint32_t kind = 0;
+        /**
+         * @brief The lexeme, pointing into the input buffer.
+         */
+        std::string_view repr = {};
+    };
+
+    struct NonTerminal {
+        uint32_t kind = 0;
+    };
+
+    /**
+     * @struct TableView
+     * @brief A two-dimensional table stored row by row in one array.
+     */
+    template <class T>
+    struct TableView {
+        const T *data = nullptr;
+        size_t width = 0;
+
+        const T *operator[](size_t row) const {
+            return data + row * width;
+        }
+    };
+
+    class Lexer;
+
+    /**
+     * @struct Tables
+     * @brief The tables in the form `pargen::LRParser` takes. The members are
+     * named like the static arrays of generated tables.
+     */
+    struct Tables {
+        using Terminal = GrammarEngine::Terminal;
+        using NonTerminal = GrammarEngine::NonTerminal;
+        using TokenStream = pargen::TokenStream<Terminal>;
+        using LineIndex = pargen::LineIndex;
+
+        TableView<uint32_t> kActions;
+        TableView<uint32_t> kGoto;
+        const uint32_t *kRuleLhs = nullptr;
+        const uint32_t *kRuleLength = nullptr;
+        const uint32_t *kRuleFlatten = nullptr;
+        TableView<uint64_t> kFollow;
+        const GrammarEngine *engine = nullptr;
+
+        /**
+         * @brief Creates a lexer of the engine, for `pargen::BatchParser`.
+         */
+        Lexer CreateLexer(std::string_view source) const;
+    };
+
+    using TokenStream = Tables::TokenStream;
+    using Parser = pargen::LRParser<Tables>;
+    using BatchParser = pargen::BatchParser<Tables>;
+    using BatchResult = pargen::BatchResult<Tables>;
+    using ParseTree = pargen::ParseTree<Tables>;
+    using ParseTreeNode = pargen::ParseTreeNode<Tables>;
+
+    /**
+     * @class Lexer
+     * @brief Lexes a buffer on demand with the DFA of the engine, like the
+     * generated lexer: the longest match wins, a byte no rule matches is an
+     * error.
+     */
+    class Lexer {
+    public:
+        Lexer(const GrammarEngine &engine, std::string_view source);
+
+        /**
+         * @brief Lexes the next token.
+         * @param token Receives the token.
+         * @return false at the end of input.
+         * @throws GrammarEngineError if no rule matches the input, with the
+         * position of the byte.
+         */
+        bool Next(Terminal &token);
+
+        std::string_view GetSource() const;
+
+    private:
+        const GrammarEngine &engine_;
+        std::string_view source_;
+        size_t pos_ = 0;
+    };
+
+    /**
+     * @brief Constructs a GrammarEngine object for a grammar.
+     * @param grammar The grammar in the BNF `gen` takes.
+     * @throws GrammarEngineError if the grammar is malformed or ambiguous, or a
+     * regex in it is.
+     */
+    explicit GrammarEngine(const std::string &grammar);
+
+    GrammarEngine(const GrammarEngine &) = delete;
+    GrammarEngine &operator=(const GrammarEngine &) = delete;
+
+    /**
+     * @brief Lexes a whole buffer.
+     * @param source The buffer; the tokens point into it.
+     * @return The tokens.
+     * @throws GrammarEngineError if no rule matches some of the input.
+     */
+    std::vector<Terminal> Lex(std::string_view source) const;
+    /**
+     * @brief Same as above, keeping the buffer for error positions.
+     */
+    TokenStream LexStream(std::string_view source) const;
+
+    /**
+     * @brief Returns the tables of the engine, e.g. for a `BatchParser`. They
+     * refer to the engine, which must outlive them.
+     */
+    Tables GetTables() const;
+    /**
+     * @brief Creates a parser reading the tables of the engine.
+     * @return The parser.
+     */
+    Parser CreateParser() const;
+
+    /**
+     * @brief Returns the name of a terminal: the lexeme of a quote terminal,
+     * the name of a regex one.
+     */
+    const std::string &GetTerminalName(uint32_t kind) const;
+    /**
+     * @brief Returns whether a terminal is a quote terminal.
+     */
+    bool IsQuoteTerminal(uint32_t kind) const;
+    /**
+     * @brief Returns the name of a non-terminal.
+     */
+    const std::string &GetNonTerminalName(uint32_t kind) const;
+    /**
+     * @brief Returns the warnings issued while parsing the grammar, each with
+     * its line, see `GrammarParser::GetWarnings`.
+     */
+    const std::vector<std::string> &GetWarnings() const;
+
+private:
+    /**
+     * @brief Marks an accepting state of ignored input.
+     */
+    static constexpr int32_t kSkip = -1;
+    /**
+     * @brief Marks a state that is not accepting.
+     */
+    static constexpr int32_t kNoMatch = -2;
+
+    /**
+     * @brief Builds the DFA of the lexer.
+     * @throws RegexError if a regex is malformed.
+     */
+    void BuildLexer(const Grammar &g, const SymbolTable &symbols);
+
+    std::vector<std::string> warnings_;
+    std::vector<std::string> terminal_names_;
+    std::vector<bool> terminal_quotes_;
+    std::vector<std::string> nonterminal_names_;
+
+    std::array<uint32_t, 256> byte_classes_{};
+    size_t class_count_ = 0;
+    uint32_t start_ = 0;
+    std::vector<uint32_t> transitions_;
+    std::vector<int32_t> accept_;
+
+    size_t follow_words_ = 0;
+    std::vector<uint32_t> actions_;
+    std::vector<uint32_t> gotos_;
+    std::vector<uint32_t> rule_lhs_;
+    std::vector<uint32_t> rule_length_;
+    std::vector<uint32_t> rule_flatten_;
+    std::vector<uint64_t> follow_;
+};
@@ -0,0 +1,173 @@
+/**
+ * @file GrammarOptimizer.h
+ * @brief Provides a class for simplifying a grammar before its automaton is
+ * built.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "Entities.h"
+
+/**
+ * @class GrammarOptimizerError
+ * @brief An exception class for reporting grammars that cannot be optimized.
+ */
+class GrammarOptimizerError : public std::exception {
+public:
+    /**
+     * @brief Constructs a GrammarOptimizerError object with the specified
+     * error.
+     * @param msg The error message.
+     */
+    explicit GrammarOptimizerError(const std::string &msg);
+    /**
+     * @brief Returns the error message.
+     * @return The error message.
+     */
+    const char *what() const noexcept override;
+
+private:
+    std::string msg_;
+};
+
+/**
+ * @struct OptimizerOptions
+ * @brief Selects the transformations `GrammarOptimizer` applies.
+ */
+struct OptimizerOptions {
+    /**
+     * @brief Remove non-terminals that derive no string of terminals or cannot
+     * be reached from the start symbol, along with the rules using them.
+     */
+    bool remove_useless = true;
+    /**
+     * @brief Merge non-terminals whose productions are the same, up to
+     * references to themselves.
+     */
+    bool merge_identical = true;
+    /**
+     * @brief Substitute the production of a non-terminal with a single rule
+     * into the only place it is used.
+     */
+    bool inline_single_use = true;
+    /**
+     * @brief Rewrite directly right-recursive non-terminals, `A -> x A | y`,
+     * into repetitions, `A -> P y` with `P -> P x | EPSILON`, which the parser
+     * reduces in constant stack depth and flattens like the EBNF ones. A
+     * rewrite that would make the grammar conflict is not made. Checking that
+     * builds the parser tables once per candidate, so this is off by default.
+     */
+    bool left_recursion = false;
+};
+
+/**
+ * @class GrammarOptimizer
+ * @brief Simplifies an augmented grammar, so that the automaton and the tables
+ * built from it are smaller and the parser makes fewer reductions.
+ * @details The grammar accepts the same language afterwards, but the parse
+ * trees change: inlined and merged non-terminals disappear from them or are
+ * renamed, hence the optimizer is opt-in. The start symbol and the augmented
+ * rule are kept. Terminals are never removed, even unused ones, as they still
+ * take part in lexing.
+ */
+class GrammarOptimizer {
+public:
+    /**
+     * @brief Constructs a GrammarOptimizer object.
+     * @param g The augmented grammar, as produced by `GrammarParser`. The
+     * optimizer works on it in place, so it may be moved in.
+     * @param options The transformations to apply.
+     */
+    explicit GrammarOptimizer(Grammar g, OptimizerOptions options = {});
+
+    /**
+     * @brief Applies the transformations until none of them changes anything.
+     * @throws GrammarOptimizerError if the start symbol derives no string of
+     * terminals, so that removing the useless symbols leaves nothing.
+     */
+    void Optimize();
+
+    /**
+     * @brief Returns the optimized grammar.
+     * @return Const reference to the optimized grammar.
+     */
+    const Grammar &Get() const;
+    /**
+     * @brief Moves the optimized grammar out of the optimizer.
+     * @return The optimized grammar. The optimizer is left without one.
+     */
+    Grammar Take();
+
+    /**
+     * @brief Returns what was changed, one line per transformation applied.
+     * @return Const reference to the report.
+     */
+    const std::vector<std::string> &GetReport() const;
+
+private:
+    /**
+     * @brief Removes the non-terminals that derive no string of terminals and
+     * the rules using them.
+     * @return Whether anything was removed.
+     * @throws GrammarOptimizerError if the start symbol is among them.
+     */
+    bool RemoveUnproductive();
+    /**
+     * @brief Removes the rules of the non-terminals that cannot be reached
+     * from the start symbol.
+     * @return Whether anything was removed.
+     */
+    bool RemoveUnreachable();
+    /**
+     * @brief Replaces every non-terminal with the first one defined before it
+     * that has the same productions.
+     * @return Whether anything was merged.
+     */
+    bool MergeIdentical();
+    /**
+     * @brief Inlines the non-terminals that have a single rule and are used
+     * once.
+     * @return Whether anything was inlined.
+     */
+    bool InlineSingleUse();
+    /**
+     * @brief Rewrites directly right-recursive non-terminals into
+     * left-recursive repetitions, unless that introduces conflicts.
+     * @return Whether anything was rewritten.
+     */
+    bool RewriteRightRecursion();
+    /**
+     * @brief Returns whether the LR(1) tables of the grammar can be built
+     * without conflicts.
+     */
+    bool IsConflictFree() const;
+
+    /**
+     * @brief Replaces a non-terminal with another one in every production and
+     * removes its rules.
+     */
+    void Replace(const NonTerminal &from, const NonTerminal &to);
+    /**
+     * @brief Removes the rules repeating an earlier rule, which replacing
+     * symbols may produce.
+     */
+    void RemoveDuplicates();
+    /**
+     * @brief Forgets a non-terminal that has no rules anymore.
+     */
+    void Erase(const NonTerminal &nt);
+
+    Grammar g_;
+    OptimizerOptions options_;
+    std::vector<std::string> report_;
+    /**
+     * @brief The right-recursive non-terminals whose rewrite conflicts, so
+     * that later passes do not try them again.
+     */
+    std::unordered_set<NonTerminal> conflicting_;
+};
@@ -6,6 +6,12 @@
  */
 #pragma once
 
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
 #include "Entities.h"
 
 /**
@@ -37,4 +43,59 @@ bool IsNonTerminal(const Token &token);
  * @param token The token to get the qualified name for.
  * @return The qualified name of the token.
  */
-std::string QualName(Token token);
\ No newline at end of file
+std::string QualName(Token token);
+
+/**
+ * @brief Returns a key identifying a rule by its contents rather than by its
+ * number: the qualified names of its LHS and of its production.
+ * @param rule The rule to get the key for.
+ * @return The key of the rule.
+ */
+std::vector<std::string> RuleKey(const Rule &rule);
+
+/**
+ * @brief Finds the non-terminals whose productions differ between two versions
+ * of a grammar.
+ * @details Productions are compared by contents, so reordering them or moving
+ * them around in the file changes nothing. A non-terminal defined in only one
+ * of the versions is changed.
+ * @param before The grammar before an edit.
+ * @param after The grammar after the edit.
+ * @return The changed non-terminals.
+ */
+std::unordered_set<NonTerminal> ChangedNonTerminals(
+    const Grammar &before, const Grammar &after
+);
+
+/**
+ * @brief Escapes a string so it can be embedded into a C++ string literal.
+ * @param s The string to escape.
+ * @return The escaped string (without surrounding quotes).
+ */
+std::string EscapeString(const std::string &s);
+
+/**
+ * @brief Checks whether a string is a C++ namespace name, possibly nested.
+ * @param s The string to check, e.g. `grammars::json`.
+ * @return True if every `::`-separated part is a non-empty identifier.
+ */
+bool IsNamespaceName(const std::string &s);
+
+/**
+ * @brief Returns the smallest unsigned integer type that holds a value.
+ * @param max_value The largest value the type must hold.
+ * @return The name of the type, e.g. `uint16_t`.
+ */
+std::string FitIntegerType(uint64_t max_value);
+
+/**
+ * @brief Writes integers as the comma-separated body of a C++ array
+ * initializer, 16 per line.
+ * @details Values that do not fit into `int32_t` are written in hexadecimal.
+ * @param out The stream to write to.
+ * @param values The values to write.
+ * @param indent The indentation of every line but the first.
+ */
+void WriteIntegers(
+    std::ostream &out, const std::vector<uint64_t> &values, size_t indent
+);
@@ -0,0 +1,89 @@
+/**
+ * @file KeywordTable.h
+ * @brief Provides a class for building a perfect hash table of keywords.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class KeywordTable
+ * @brief A perfect hash table of a fixed set of words, built with the hash and
+ * displace method.
+ * @details A word is hashed once; the high half of the hash picks a bucket and
+ * the low half, mixed with the displacement of the bucket, picks a slot. The
+ * displacements are chosen so that no two words share a slot, so a lookup is a
+ * single hash, a single probe and a single comparison. The generated lexer
+ * repeats `Hash` and `Slot`, so the two have to stay in sync with it.
+ */
+class KeywordTable {
+public:
+    /**
+     * @brief Marks a slot that holds no word.
+     */
+    static constexpr int kEmptySlot = -1;
+
+    /**
+     * @brief Constructs a KeywordTable object for the specified words.
+     * @param words The words to store. Their hashes must be distinct, which
+     * also means the words must be.
+     */
+    explicit KeywordTable(const std::vector<std::string> &words);
+
+    /**
+     * @brief Hashes a word 8 bytes at a time.
+     * @param word The word.
+     * @return The hash.
+     */
+    static uint64_t Hash(std::string_view word);
+    /**
+     * @brief Computes the slot of a hash.
+     * @param hash The hash of a word.
+     * @param displacement The displacement of the bucket of the word.
+     * @param slot_count The number of slots, a power of two.
+     * @return The slot.
+     */
+    static size_t Slot(uint64_t hash, uint32_t displacement, size_t slot_count);
+
+    /**
+     * @brief Returns the number of buckets.
+     */
+    size_t GetBucketCount() const;
+    /**
+     * @brief Returns the number of slots, a power of two.
+     */
+    size_t GetSlotCount() const;
+    /**
+     * @brief Returns the displacements of the buckets.
+     */
+    const std::vector<uint32_t> &GetDisplacements() const;
+    /**
+     * @brief Returns the contents of the slots.
+     * @return For every slot the index of the word in it, or `kEmptySlot`.
+     */
+    const std::vector<int> &GetSlots() const;
+
+    /**
+     * @brief Looks a word up.
+     * @param word The word to look up.
+     * @return The index of the word, or `kEmptySlot` if it is not stored.
+     */
+    int Find(std::string_view word) const;
+
+private:
+    /**
+     * @brief Tries to place all the words into `slot_count` slots.
+     * @param slot_count The number of slots.
+     * @return Whether every bucket got a displacement.
+     */
+    bool Build(size_t slot_count);
+
+    std::vector<std::string> words_;
+    std::vector<uint32_t> displacements_;
+    std::vector<int> slots_;
+};
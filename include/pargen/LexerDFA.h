@@ -0,0 +1,129 @@
+/**
+ * @file LexerDFA.h
+ * @brief Provides a class for compiling the lexical rules of a grammar into a
+ * minimal DFA.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "Regex.h"
+
+/**
+ * @struct LexerRule
+ * @brief Represents a single rule of a lexer.
+ */
+struct LexerRule {
+    /**
+     * @brief Stores the pattern the rule matches.
+     */
+    std::string pattern_;
+    /**
+     * @brief Stores whether the pattern is a literal string (the contents of a
+     * quote terminal) rather than a regular expression.
+     */
+    bool literal_ = false;
+};
+
+/**
+ * @class LexerDFA
+ * @brief Compiles lexer rules into a minimal DFA over byte equivalence
+ * classes.
+ * @details The rules are compiled to a single NFA, which is then turned into a
+ * DFA by subset construction and minimized. Bytes that no state tells apart
+ * share an equivalence class, so the transition table has a column per class
+ * rather than per byte. State 0 is the dead state: it is not accepting and
+ * every transition from it leads back to it. If several rules match the same
+ * input, the one that comes first wins.
+ */
+class LexerDFA {
+public:
+    /**
+     * @brief The index of the dead state.
+     */
+    static constexpr size_t kDeadState = 0;
+
+    /**
+     * @brief Constructs a LexerDFA object for the specified rules.
+     * @param rules The rules ordered by decreasing priority.
+     * @throws RegexError if a pattern of a rule is malformed.
+     */
+    explicit LexerDFA(const std::vector<LexerRule> &rules);
+
+    /**
+     * @brief Returns the start state.
+     */
+    size_t GetStart() const;
+    /**
+     * @brief Returns the number of states, including the dead state.
+     */
+    size_t GetStateCount() const;
+    /**
+     * @brief Returns the number of byte equivalence classes.
+     */
+    size_t GetClassCount() const;
+    /**
+     * @brief Returns the equivalence class of a byte.
+     * @param c The byte.
+     * @return The index of the class.
+     */
+    size_t GetClass(unsigned char c) const;
+    /**
+     * @brief Returns the target of a transition.
+     * @param state The source state.
+     * @param cls The equivalence class of the byte read.
+     * @return The target state.
+     */
+    size_t GetTransition(size_t state, size_t cls) const;
+    /**
+     * @brief Returns the rule accepted in a state.
+     * @param state The state.
+     * @return The index of the rule, or -1 if the state is not accepting.
+     */
+    int GetAccept(size_t state) const;
+    /**
+     * @brief Returns the bytes that keep the DFA in a state.
+     * @details Runs of such bytes (whitespace, string bodies, digits) can be
+     * consumed in bulk, as neither the state nor the accepted rule changes
+     * while reading them.
+     * @param state The state.
+     * @return The set of bytes on which the state loops to itself.
+     */
+    CharSet GetLoopBytes(size_t state) const;
+
+    /**
+     * @brief Finds the longest prefix of the input matched by a rule.
+     * @param input The input to match.
+     * @return The length of the match and the index of the matched rule, or
+     * {0, -1} if no rule matches a non-empty prefix.
+     */
+    std::pair<size_t, int> Match(std::string_view input) const;
+
+private:
+    /**
+     * @brief Builds the DFA from an NFA by subset construction.
+     * @param nfa The NFA.
+     * @param start The start state of the NFA.
+     */
+    void Determinize(const NFA &nfa, size_t start);
+    /**
+     * @brief Merges equivalent states using partition refinement.
+     */
+    void Minimize();
+    /**
+     * @brief Merges byte classes that every state treats the same way.
+     */
+    void MergeClasses();
+
+    std::array<size_t, 256> classes_{};
+    size_t class_count_ = 0;
+    size_t start_ = 0;
+    std::vector<std::vector<size_t>> transitions_;
+    std::vector<int> accept_;
+};
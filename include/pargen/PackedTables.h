@@ -0,0 +1,66 @@
+/**
+ * @file PackedTables.h
+ * @brief Provides the parser tables of a grammar as dense integer arrays, the
+ * form the parser runtime reads.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Entities.h"
+#include "SymbolTable.h"
+
+/**
+ * @struct PackedTables
+ * @brief The action, goto, rule and FOLLOW tables indexed by the ids of a
+ * `SymbolTable`, in the layout of `pargen::LRParser`.
+ * @details Shared by the code generator, which writes the arrays out, and the
+ * runtime engine, which parses with them directly.
+ */
+struct PackedTables {
+    /**
+     * @brief Packs the tables of a grammar.
+     * @param g The augmented grammar.
+     * @param symbols The numbering of the symbols of the grammar.
+     * @param at The action table.
+     * @param gt The goto table.
+     * @param fs The FOLLOW sets.
+     */
+    PackedTables(
+        const Grammar &g, const SymbolTable &symbols, const ActionTable &at,
+        const GotoTable &gt, const FollowSets &fs
+    );
+
+    /**
+     * @brief Indexed by state and terminal id. An action is packed as
+     * `value << 2 | type` in the numbering of `pargen::ActionType`, so 0 is an
+     * error.
+     */
+    std::vector<std::vector<uint64_t>> actions_;
+    /**
+     * @brief Indexed by state and non-terminal id. 0 means there is no
+     * transition, as none of them leads back to the initial state.
+     */
+    std::vector<std::vector<uint64_t>> gotos_;
+    /**
+     * @brief The non-terminal id of the left-hand side of each rule.
+     */
+    std::vector<uint64_t> rule_lhs_;
+    /**
+     * @brief The number of symbols of each rule, epsilon not counted.
+     */
+    std::vector<uint64_t> rule_length_;
+    /**
+     * @brief 1 for each rule that appends to the node of its first symbol, a
+     * recursive rule of an EBNF repetition, see `Grammar::lists_`.
+     */
+    std::vector<uint64_t> rule_flatten_;
+    /**
+     * @brief The FOLLOW set of each non-terminal as a bitset of terminal ids,
+     * in 64-bit words.
+     */
+    std::vector<std::vector<uint64_t>> follow_;
+};
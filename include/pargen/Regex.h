@@ -0,0 +1,192 @@
+/**
+ * @file Regex.h
+ * @brief Provides a parser for the regular expressions of terminal
+ * definitions and the NFA they are compiled to.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <bitset>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "CodePointSet.h"
+
+/**
+ * @class RegexError
+ * @brief An exception class for reporting malformed or unsupported regular
+ * expressions.
+ */
+class RegexError : public std::exception {
+public:
+    /**
+     * @brief Constructs a RegexError object with the specified error.
+     * @param msg The error message.
+     * @param pattern The regular expression the error was encountered in.
+     */
+    RegexError(const std::string &msg, const std::string &pattern);
+
+    /**
+     * @brief Returns the error message.
+     * @return The error message.
+     */
+    const char *what() const noexcept override;
+
+private:
+    std::string msg_;
+};
+
+/**
+ * @brief Alias for a set of bytes.
+ */
+using CharSet = std::bitset<256>;
+
+/**
+ * @struct NFA
+ * @brief A Thompson NFA over bytes.
+ * @details Every state has any number of epsilon transitions and at most one
+ * transition on a set of bytes.
+ */
+struct NFA {
+    /**
+     * @struct State
+     * @brief Represents a single state of the NFA.
+     */
+    struct State {
+        /**
+         * @brief Stores the targets of the epsilon transitions.
+         */
+        std::vector<size_t> epsilon_;
+        /**
+         * @brief Stores the bytes of the transition to `next_`; the state has
+         * no such transition if none are set.
+         */
+        CharSet chars_;
+        /**
+         * @brief Stores the target of the transition on `chars_`.
+         */
+        size_t next_ = 0;
+        /**
+         * @brief Stores the index of the rule accepted in this state, or -1 if
+         * the state is not accepting.
+         */
+        int accept_ = -1;
+    };
+
+    /**
+     * @brief Stores the states of the NFA.
+     */
+    std::vector<State> states_;
+
+    /**
+     * @brief Adds a new state to the NFA.
+     * @return The index of the added state.
+     */
+    size_t AddState();
+};
+
+/**
+ * @class RegexParser
+ * @brief Compiles a regular expression into a fragment of an NFA.
+ * @details Supports the subset of `flex` syntax that makes sense for terminal
+ * definitions: literal characters and escapes (`\\n`, `\\x41`, `\\101`, ...),
+ * the shorthands `\\s`, `\\d`, `\\w` and their negations, `.`, bracket
+ * expressions with ranges, negation and `[:alpha:]`-like classes, quoted
+ * strings, grouping, alternation and the `*`, `+`, `?`, `{n}`, `{n,}` and
+ * `{n,m}` operators. As in `flex`, unquoted whitespace ends the pattern.
+ *
+ * Patterns are matched against UTF-8 input byte by byte, but a non-ASCII
+ * character, a code point `\\u{hex}` and the Unicode general categories
+ * `\\p{L}`, `\\p{Nd}`, ... (negated by `\\P{...}`) stand for the UTF-8
+ * encodings of their code points. A bracket expression with any of them is a
+ * set of code points, in which byte escapes like `\\xe9` denote the code
+ * points U+0000 to U+00FF and `^` complements among all the code points.
+ */
+class RegexParser {
+public:
+    /**
+     * @brief Constructs a RegexParser object for a pattern.
+     * @param pattern The pattern to compile.
+     * @param literal Whether the pattern is a literal string (the contents of a
+     * quote terminal), in which only escapes are interpreted.
+     */
+    explicit RegexParser(const std::string &pattern, bool literal = false);
+
+    /**
+     * @brief Compiles the pattern into `nfa`.
+     * @param nfa The NFA to add the states of the pattern to.
+     * @param rule The rule index to mark the accepting state with.
+     * @return The start state of the compiled pattern.
+     * @throws RegexError if the pattern is malformed or uses an unsupported
+     * construct.
+     */
+    size_t CompileTo(NFA &nfa, int rule);
+
+    /**
+     * @brief Returns the only string a literal pattern matches.
+     * @return The string with the escapes interpreted, or `std::nullopt` if
+     * the pattern is not literal or an escape in it stands for several
+     * characters (like `\\d`).
+     * @throws RegexError if an escape is malformed.
+     */
+    std::optional<std::string> GetLiteralString();
+
+private:
+    /**
+     * @brief A part of the NFA with a single entry and a single exit state.
+     */
+    struct Fragment {
+        size_t start;
+        size_t end;
+    };
+
+    Fragment ParseAlternation();
+    Fragment ParseConcatenation();
+    Fragment ParseRepetition();
+    /**
+     * @brief Applies the repetition operator at the current position.
+     * @param f The fragment compiled from the text in [begin, current
+     * position).
+     * @param begin Where the text of the repeated expression starts.
+     */
+    Fragment ApplyOperator(Fragment f, size_t begin);
+    /**
+     * @brief Compiles the expression in [begin, end) once more, which bounded
+     * repetitions use to get states for every copy.
+     */
+    Fragment CompileAgain(size_t begin, size_t end);
+    Fragment ParseAtom();
+    Fragment ParseQuoted(char terminator);
+    Fragment ParseBracket();
+    CharSet ParseEscape();
+    /**
+     * @brief Checks whether the escape after a consumed backslash is `\\u`,
+     * `\\p` or `\\P`.
+     */
+    bool AtUnicodeEscape() const;
+    CodePointSet ParseUnicodeEscape();
+    size_t ParseNumber();
+
+    Fragment Chars(const CharSet &chars);
+    /**
+     * @brief Matches the UTF-8 encoding of any code point of a set.
+     */
+    Fragment CodePoints(const CodePointSet &set);
+    Fragment Empty();
+    Fragment Concatenate(Fragment a, Fragment b);
+    Fragment Star(Fragment f);
+    Fragment Plus(Fragment f);
+    Fragment Optional(Fragment f);
+
+    bool AtEnd() const;
+    char Peek() const;
+    char Get();
+    void ThrowError(const std::string &msg) const;
+
+    std::string pattern_;
+    bool literal_;
+    size_t pos_ = 0;
+    NFA *nfa_ = nullptr;
+};
@@ -0,0 +1,73 @@
+/**
+ * @file SymbolTable.h
+ * @brief Provides a class for assigning dense integer ids to the symbols of a
+ * grammar.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Entities.h"
+
+/**
+ * @class SymbolTable
+ * @brief Numbers the terminals and non-terminals of a grammar.
+ * @details The ids are what the generated lexer and parser use instead of
+ * names, so every generator has to use the same numbering. Terminal 0 is
+ * always the end of input marker and non-terminal 0 is always the start
+ * symbol of the augmented grammar. Epsilon is not a symbol and has no id.
+ */
+class SymbolTable {
+public:
+    /**
+     * @brief Constructs a SymbolTable object for an augmented grammar.
+     * @param g The grammar to number the symbols of.
+     */
+    explicit SymbolTable(const Grammar &g);
+
+    /**
+     * @brief Returns the id of a terminal.
+     * @param t The terminal to get the id of.
+     * @return The id of the terminal.
+     * @throws std::out_of_range if the terminal is not a part of the grammar.
+     */
+    size_t GetTerminalId(const Terminal &t) const;
+    /**
+     * @brief Returns the id of a terminal by its qualified name.
+     * @param qual_name The qualified name of the terminal (see `QualName`).
+     * @return The id of the terminal.
+     * @throws std::out_of_range if the terminal is not a part of the grammar.
+     */
+    size_t GetTerminalId(const std::string &qual_name) const;
+    /**
+     * @brief Returns the id of a non-terminal.
+     * @param nt The non-terminal to get the id of.
+     * @return The id of the non-terminal.
+     * @throws std::out_of_range if the non-terminal is not a part of the
+     * grammar.
+     */
+    size_t GetNonTerminalId(const NonTerminal &nt) const;
+
+    /**
+     * @brief Returns all terminals of the grammar ordered by their ids.
+     * @return Const reference to the terminals.
+     */
+    const std::vector<Terminal> &GetTerminals() const;
+    /**
+     * @brief Returns all non-terminals of the grammar ordered by their ids.
+     * @return Const reference to the non-terminals.
+     */
+    const std::vector<NonTerminal> &GetNonTerminals() const;
+
+private:
+    void AddTerminal(const Terminal &t);
+
+    std::vector<Terminal> terminals_;
+    std::vector<NonTerminal> nonterminals_;
+    std::unordered_map<std::string, size_t> terminal_ids_;
+    std::unordered_map<NonTerminal, size_t> nonterminal_ids_;
+};
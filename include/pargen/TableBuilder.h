@@ -43,23 +43,48 @@ public:
      * specified GrammarAnalyzer.
      * @param g The grammar to generate tables for.
      * @param ga The GrammarAnalyzer that provides pregenerated sets for the
-     * grammar.
+     * grammar. Like the grammar, it is borrowed and must outlive the tables.
      */
     ParserTables(const Grammar &g, const GrammarAnalyzer &ga);
+    /**
+     * @brief Constructs a ParserTables object for an edited grammar, building
+     * its automaton incrementally from the previous one.
+     * @param g The edited grammar.
+     * @param ga The GrammarAnalyzer of the edited grammar.
+     * @param previous The tables of the grammar before the edit. Its grammar
+     * and analyzer must still be alive.
+     */
+    ParserTables(
+        const Grammar &g, const GrammarAnalyzer &ga,
+        const ParserTables &previous
+    );
 
     /**
      * @brief Generates both parser tables.
      */
     void Generate();
 
+    /**
+     * @brief Frees the automaton once the tables are generated, keeping only
+     * the tables.
+     * @details The item sets and the closure cache usually take much more
+     * memory than the tables. Tables built incrementally from these ones are
+     * then built from scratch.
+     */
+    void ReleaseAutomaton();
+
     /**
      * @brief Returns the action table.
      */
-    ActionTable GetActionTable() const;
+    const ActionTable &GetActionTable() const;
     /**
      * @brief Returns the goto table.
      */
-    GotoTable GetGotoTable() const;
+    const GotoTable &GetGotoTable() const;
+    /**
+     * @brief Returns the automaton the tables are built from.
+     */
+    const Automaton &GetAutomaton() const;
 
 private:
     /**
@@ -74,9 +99,8 @@ private:
      */
     void BuildGotoTable();
 
-    Automaton automaton_;
-    Automaton::StateMap states_;
     const Grammar &g_;
+    Automaton automaton_;
 
     ActionTable action_;
     GotoTable goto_;
@@ -0,0 +1,180 @@
+/**
+ * @file BatchParser.h
+ * @brief Provides a class for parsing many inputs on a pool of threads.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "LRParser.h"
+
+namespace pargen {
+namespace detail {
+/**
+ * @brief The type of the files `BatchParser::ParseFiles` maps: the
+ * `MappedFile` of the generated lexer, or `void` for tables without one.
+ */
+template <class Tables>
+struct MappedFileOf {
+    using type = void;
+};
+
+template <class Tables>
+    requires requires { typename Tables::MappedFile; }
+struct MappedFileOf<Tables> {
+    using type = typename Tables::MappedFile;
+};
+}  // namespace detail
+
+/**
+ * @struct BatchResult
+ * @brief The result of parsing one input of a batch.
+ * @tparam Tables The tables of the grammar, see `LRParser`. To parse buffers
+ * they also provide a `Lexer`, constructed from a buffer or returned by
+ * `CreateLexer(buffer)` of the tables, and for `ParseFiles` the `MappedFile`
+ * of the generated lexer.
+ */
+template <class Tables>
+struct BatchResult {
+    int status = 0;
+    /**
+     * @brief The tree, set whenever `status >= 0`.
+     */
+    std::optional<ParseTree<Tables>> tree;
+    /**
+     * @brief The file the tree points into, set by `ParseFiles`.
+     */
+    std::shared_ptr<const typename detail::MappedFileOf<Tables>::type> source;
+    /**
+     * @brief The exception thrown while reading, lexing or parsing the input,
+     * e.g. a `LexerError`; `status` is -1 then and there is no tree.
+     */
+    std::exception_ptr error;
+};
+
+/**
+ * @class BatchParser
+ * @brief Parses many inputs on a pool of worker threads.
+ * @details Each worker owns its parser, the tables are shared read-only.
+ * Results are returned in the order of the inputs. An exception thrown for an
+ * input is stored in its result and does not affect the others.
+ * @tparam Tables The tables of the grammar, see `BatchResult`.
+ */
+template <class Tables>
+class BatchParser {
+public:
+    explicit BatchParser(
+        size_t threads = std::thread::hardware_concurrency()
+    )
+        : BatchParser(Tables(), threads) {}
+
+    /**
+     * @brief Constructs a BatchParser object for tables that are not static,
+     * e.g. those of a `GrammarEngine`.
+     * @param tables The tables, copied into the parser of each worker.
+     * @param threads The number of workers.
+     */
+    explicit BatchParser(
+        Tables tables, size_t threads = std::thread::hardware_concurrency()
+    )
+        : tables_(std::move(tables)), threads_(std::max<size_t>(threads, 1)) {}
+
+    std::vector<BatchResult<Tables>> Parse(
+        std::span<const std::vector<typename Tables::Terminal>> streams
+    ) const {
+        return Run(streams.size(), [&](LRParser<Tables> &parser, BatchResult<Tables> &, size_t i) {
+            return parser.Parse(streams[i]);
+        });
+    }
+
+    /**
+     * @brief Parses buffers with the lexer of the tables.
+     * @details Each buffer is lexed in place while being parsed, so the
+     * trees point into the buffers, which must outlive them.
+     */
+    std::vector<BatchResult<Tables>> Parse(
+        std::span<const std::string_view> buffers
+    ) const {
+        return Run(buffers.size(), [&](LRParser<Tables> &parser, BatchResult<Tables> &, size_t i) {
+            auto lexer = CreateLexer(buffers[i]);
+            return parser.Parse(lexer);
+        });
+    }
+
+    /**
+     * @brief Parses files with the generated lexer.
+     * @details The files are mapped into memory and lexed in place while
+     * being parsed; the trees point into the mappings, kept alive by
+     * `BatchResult::source`. A file that cannot be read or lexed gets its
+     * `LexerError` in `BatchResult::error`.
+     */
+    std::vector<BatchResult<Tables>> ParseFiles(
+        std::span<const std::string> filenames
+    ) const {
+        using MappedFile = typename Tables::MappedFile;
+        return Run(filenames.size(), [&](LRParser<Tables> &parser, BatchResult<Tables> &result, size_t i) {
+            result.source = std::make_shared<const MappedFile>(filenames[i]);
+            auto lexer = CreateLexer(result.source->Data());
+            return parser.Parse(lexer);
+        });
+    }
+
+private:
+    auto CreateLexer(std::string_view source) const {
+        if constexpr (requires { tables_.CreateLexer(source); }) {
+            return tables_.CreateLexer(source);
+        } else {
+            return typename Tables::Lexer(source);
+        }
+    }
+
+    template <class ParseOne>
+    std::vector<BatchResult<Tables>> Run(size_t count, ParseOne parse_one) const {
+        std::vector<BatchResult<Tables>> results(count);
+        std::atomic<size_t> next = 0;
+        auto worker = [&]() {
+            LRParser<Tables> parser(tables_);
+            for (size_t i = next++; i < count; i = next++) {
+                // an exception must not escape the thread, which would
+                // terminate the program
+                try {
+                    results[i].status = parse_one(parser, results[i], i);
+                    if (results[i].status >= 0) {
+                        results[i].tree = parser.GetParseTree();
+                    }
+                } catch (...) {
+                    results[i].status = -1;
+                    results[i].tree.reset();
+                    results[i].error = std::current_exception();
+                }
+            }
+        };
+        std::vector<std::thread> pool;
+        size_t workers = std::min(threads_, count);
+        for (size_t i = 1; i < workers; ++i) {
+            pool.emplace_back(worker);
+        }
+        worker();
+        for (std::thread &thread : pool) {
+            thread.join();
+        }
+        return results;
+    }
+
+    [[no_unique_address]] Tables tables_;
+    size_t threads_;
+};
+}  // namespace pargen
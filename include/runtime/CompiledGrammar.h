@@ -0,0 +1,748 @@
+/**
+ * @file CompiledGrammar.h
+ * @brief Provides `compile`, which builds parser tables from a grammar at
+ * compile time, for grammars small enough not to need a `gen` build step.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "LRParser.h"
+#include "LineIndex.h"
+#include "TokenStream.h"
+
+namespace pargen {
+/**
+ * @class CompileError
+ * @brief An exception class for reporting errors in a grammar passed to
+ * `compile`.
+ * @note In a constant expression the exception cannot be thrown: the
+ * compilation fails instead, and the diagnostic points at the `throw` with the
+ * message.
+ */
+class CompileError : public std::exception {
+public:
+    /**
+     * @brief Constructs a CompileError object with the specified error.
+     * @param msg The error message, a string literal.
+     */
+    explicit CompileError(const char *msg) : msg_(msg) {}
+
+    /**
+     * @brief Returns the error message.
+     * @return The error message.
+     */
+    const char *what() const noexcept override {
+        return msg_;
+    }
+
+private:
+    const char *msg_;
+};
+
+/**
+ * @struct CompiledGrammar
+ * @brief The parser tables of a grammar in fixed-size arrays, in the layout
+ * the generator emits (see `LRParser`).
+ * @details Only the first `state_count`, `terminal_count`, ... entries are
+ * used. Terminal 0 is the end of input and non-terminal 0 is the start symbol
+ * of the augmented grammar, other symbols are numbered in the order of their
+ * first appearance in the grammar.
+ * @tparam MaxStates The capacity for states.
+ * @tparam MaxTerminals The capacity for terminals, including the end of input.
+ * @tparam MaxNonTerminals The capacity for non-terminals, including the start
+ * symbol of the augmented grammar.
+ * @tparam MaxRules The capacity for rules, including the augmenting one.
+ */
+template <size_t MaxStates, size_t MaxTerminals, size_t MaxNonTerminals, size_t MaxRules>
+struct CompiledGrammar {
+    static_assert(MaxStates < (1 << 14), "states must fit into packed actions");
+    static constexpr size_t kFollowWords = (MaxTerminals + 63) / 64;
+
+    size_t state_count = 0;
+    size_t terminal_count = 0;
+    size_t nonterminal_count = 0;
+    size_t rule_count = 0;
+
+    /**
+     * @brief The names of the terminals: the lexeme of a quote terminal, the
+     * name of a regex one.
+     */
+    std::array<std::string_view, MaxTerminals> terminal_names{};
+    std::array<bool, MaxTerminals> terminal_is_quote{};
+    std::array<std::string_view, MaxNonTerminals> nonterminal_names{};
+
+    std::array<std::array<uint16_t, MaxTerminals>, MaxStates> actions{};
+    std::array<std::array<uint16_t, MaxNonTerminals>, MaxStates> gotos{};
+    std::array<uint16_t, MaxRules> rule_lhs{};
+    std::array<uint16_t, MaxRules> rule_length{};
+    std::array<std::array<uint64_t, kFollowWords>, MaxNonTerminals> follow{};
+
+    /**
+     * @brief Returns the kind of a terminal.
+     * @param name The lexeme of a quote terminal or the name of a regex one.
+     * @return The kind.
+     * @throws CompileError if there is no such terminal.
+     */
+    constexpr uint32_t TerminalKind(std::string_view name) const {
+        for (size_t i = 1; i < terminal_count; ++i) {
+            if (terminal_names[i] == name) {
+                return static_cast<uint32_t>(i);
+            }
+        }
+        throw CompileError("Unknown terminal");
+    }
+
+    /**
+     * @brief Returns the kind of a non-terminal.
+     * @param name The name of the non-terminal, without angle brackets.
+     * @return The kind.
+     * @throws CompileError if there is no such non-terminal.
+     */
+    constexpr uint32_t NonTerminalKind(std::string_view name) const {
+        for (size_t i = 1; i < nonterminal_count; ++i) {
+            if (nonterminal_names[i] == name) {
+                return static_cast<uint32_t>(i);
+            }
+        }
+        throw CompileError("Unknown non-terminal");
+    }
+};
+
+namespace detail {
+// A set of terminal kinds.
+class Bits {
+public:
+    constexpr explicit Bits(size_t size = 0) : words_((size + 63) / 64, 0) {}
+
+    constexpr bool Test(size_t i) const {
+        return (words_[i / 64] >> (i % 64)) & 1;
+    }
+    constexpr void Set(size_t i) {
+        words_[i / 64] |= uint64_t{1} << (i % 64);
+    }
+    // Adds the elements of another set, returns whether any were new.
+    constexpr bool Merge(const Bits &other) {
+        bool changed = false;
+        for (size_t i = 0; i < words_.size(); ++i) {
+            uint64_t merged = words_[i] | other.words_[i];
+            changed = changed || merged != words_[i];
+            words_[i] = merged;
+        }
+        return changed;
+    }
+    constexpr bool Empty() const {
+        return std::all_of(words_.begin(), words_.end(), [](uint64_t w) {
+            return w == 0;
+        });
+    }
+    constexpr uint64_t Word(size_t i) const {
+        return words_[i];
+    }
+
+    constexpr bool operator==(const Bits &other) const = default;
+
+private:
+    std::vector<uint64_t> words_;
+};
+
+struct Symbol {
+    bool nonterminal = false;
+    size_t id = 0;
+
+    constexpr bool operator==(const Symbol &other) const = default;
+};
+
+struct Rule {
+    size_t lhs = 0;
+    std::vector<Symbol> rhs;
+};
+
+// An LR(1) item with the lookaheads of all items of the same core merged.
+struct Item {
+    size_t rule = 0;
+    size_t dot = 0;
+    Bits lookahead;
+
+    constexpr bool operator==(const Item &other) const = default;
+};
+
+/*
+ * A constexpr counterpart of GrammarParser, GrammarAnalyzer, Automaton and
+ * ParserTables of the generator for the subset of BNF that does not concern
+ * the lexer: regex terminals are declared by `NAME = ...` but their regexes
+ * are ignored, as are `IGNORE` lines. The classes of the generator keep their
+ * symbols in std::set and std::map, which cannot be used in constant
+ * expressions, hence the second implementation; the containers here are
+ * vectors, and are all released before `compile` returns. TestCompiledGrammar
+ * checks that both build the same parser for the example grammars.
+ */
+class GrammarCompiler {
+public:
+    struct TerminalName {
+        std::string_view name;
+        bool quote = false;
+    };
+
+    constexpr explicit GrammarCompiler(std::string_view source) {
+        terminals_.push_back(TerminalName{"$", false});
+        nonterminals_.push_back("S'");
+        defined_.push_back(true);
+        rules_.push_back(Rule{});
+        size_t pos = 0;
+        while (pos < source.size()) {
+            size_t end = std::min(source.find('\n', pos), source.size());
+            ParseLine(source.substr(pos, end - pos));
+            pos = end + 1;
+        }
+        Verify();
+        Analyze();
+        BuildStates();
+    }
+
+    std::vector<TerminalName> terminals_;
+    std::vector<std::string_view> nonterminals_;
+    std::vector<Rule> rules_;
+    std::vector<Bits> follow_;
+    std::vector<std::vector<size_t>> actions_;
+    std::vector<std::vector<size_t>> gotos_;
+
+private:
+    static constexpr bool IsSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+    static constexpr bool IsAlpha(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+    static constexpr bool IsNameChar(char c) {
+        return IsAlpha(c) || (c >= '0' && c <= '9') || c == '_';
+    }
+    static constexpr bool IsEbnfOperator(char c) {
+        return c == '(' || c == ')' || c == '*' || c == '+' || c == '?';
+    }
+
+    static constexpr void SkipSpace(std::string_view line, size_t &i) {
+        while (i < line.size() && IsSpace(line[i])) {
+            ++i;
+        }
+    }
+
+    static constexpr std::string_view ParseName(std::string_view line, size_t &i) {
+        size_t begin = i;
+        while (i < line.size() && IsNameChar(line[i])) {
+            ++i;
+        }
+        return line.substr(begin, i - begin);
+    }
+
+    constexpr size_t InternTerminal(std::string_view name, bool quote) {
+        for (size_t i = 0; i < terminals_.size(); ++i) {
+            if (terminals_[i].name == name && terminals_[i].quote == quote) {
+                return i;
+            }
+        }
+        terminals_.push_back(TerminalName{name, quote});
+        return terminals_.size() - 1;
+    }
+
+    constexpr std::optional<size_t> FindRegexTerminal(std::string_view name) const {
+        for (size_t i = 1; i < terminals_.size(); ++i) {
+            if (terminals_[i].name == name && !terminals_[i].quote) {
+                return i;
+            }
+        }
+        return std::nullopt;
+    }
+
+    constexpr size_t InternNonTerminal(std::string_view name) {
+        for (size_t i = 1; i < nonterminals_.size(); ++i) {
+            if (nonterminals_[i] == name) {
+                return i;
+            }
+        }
+        nonterminals_.push_back(name);
+        defined_.push_back(false);
+        return nonterminals_.size() - 1;
+    }
+
+    constexpr size_t ParseNonTerminal(std::string_view line, size_t &i) {
+        ++i;
+        std::string_view name = ParseName(line, i);
+        if (i == line.size() || line[i] != '>') {
+            throw CompileError("Unterminated `<`");
+        }
+        ++i;
+        return InternNonTerminal(name);
+    }
+
+    constexpr void ParseLine(std::string_view line) {
+        size_t i = 0;
+        SkipSpace(line, i);
+        if (i == line.size()) {
+            return;
+        }
+        bool nonterminal = line[i] == '<';
+        std::string_view name;
+        size_t lhs = 0;
+        if (nonterminal) {
+            lhs = ParseNonTerminal(line, i);
+        } else if (IsAlpha(line[i])) {
+            name = ParseName(line, i);
+        } else if (line[i] == '\'' || line[i] == '"') {
+            throw CompileError(
+                "Can't assign a regex to a quote terminal; try removing "
+                "surrounding quotes on LHS"
+            );
+        } else {
+            throw CompileError("Unknown token");
+        }
+        SkipSpace(line, i);
+        if (i == line.size() || line[i] != '=') {
+            throw CompileError("Expected `=`");
+        }
+        ++i;
+        SkipSpace(line, i);
+        if (i == line.size()) {
+            throw CompileError("Empty production");
+        }
+
+        if (!nonterminal) {
+            if (name == "EPSILON") {
+                throw CompileError("Changing EPSILON is not allowed");
+            }
+            if (name != "IGNORE") {
+                InternTerminal(name, false);
+            }
+            return;
+        }
+        defined_[lhs] = true;
+        while (i < line.size()) {
+            Rule rule{lhs, {}};
+            bool has_epsilon = false;
+            size_t tokens = 0;
+            while (i < line.size() && line[i] != '|') {
+                ++tokens;
+                if (line[i] == '<') {
+                    rule.rhs.push_back(Symbol{true, ParseNonTerminal(line, i)});
+                } else if (line[i] == '\'' || line[i] == '"') {
+                    char quote = line[i++];
+                    size_t end = line.find(quote, i);
+                    if (end == std::string_view::npos) {
+                        throw CompileError("Unterminated quote terminal");
+                    }
+                    if (end == i) {
+                        throw CompileError("Empty quote terminal");
+                    }
+                    rule.rhs.push_back(
+                        Symbol{false, InternTerminal(line.substr(i, end - i), true)}
+                    );
+                    i = end + 1;
+                } else if (IsAlpha(line[i])) {
+                    std::string_view terminal = ParseName(line, i);
+                    if (terminal == "EPSILON") {
+                        has_epsilon = true;
+                    } else if (auto id = FindRegexTerminal(terminal)) {
+                        rule.rhs.push_back(Symbol{false, *id});
+                    } else {
+                        throw CompileError(
+                            "Unknown terminal encountered; if the token is "
+                            "defined after this line, try moving it before "
+                            "the current line"
+                        );
+                    }
+                } else if (IsEbnfOperator(line[i])) {
+                    throw CompileError(
+                        "EBNF operators are not supported by compile; write "
+                        "repetitions as recursive rules"
+                    );
+                } else {
+                    throw CompileError("Unknown token");
+                }
+                SkipSpace(line, i);
+            }
+            if (has_epsilon && tokens != 1) {
+                throw CompileError(
+                    "Epsilon can only be used in a single-token production; "
+                    "try getting rid of unnecessary epsilon productions"
+                );
+            }
+            // an empty alternative is skipped, as by the generator
+            if (tokens != 0) {
+                rules_.push_back(std::move(rule));
+            }
+            if (i < line.size()) {
+                ++i;
+                SkipSpace(line, i);
+            }
+        }
+    }
+
+    // Checks for undefined non-terminals and augments the grammar.
+    constexpr void Verify() {
+        if (rules_.size() == 1) {
+            throw CompileError("Empty grammar");
+        }
+        for (bool defined : defined_) {
+            if (!defined) {
+                throw CompileError("Encountered an undefined non-terminal");
+            }
+        }
+        rules_[0].rhs.push_back(Symbol{true, rules_[1].lhs});
+        rules_by_lhs_.resize(nonterminals_.size());
+        for (size_t r = 0; r < rules_.size(); ++r) {
+            rules_by_lhs_[rules_[r].lhs].push_back(r);
+        }
+    }
+
+    // Computes the FIRST sets, nullability and the FOLLOW sets.
+    constexpr void Analyze() {
+        size_t terminal_count = terminals_.size();
+        first_.assign(nonterminals_.size(), Bits(terminal_count));
+        nullable_.assign(nonterminals_.size(), false);
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (const Rule &rule : rules_) {
+                Bits first(terminal_count);
+                bool nullable = FirstOfSequence(rule, 0, first);
+                changed = first_[rule.lhs].Merge(first) || changed;
+                if (nullable && !nullable_[rule.lhs]) {
+                    nullable_[rule.lhs] = true;
+                    changed = true;
+                }
+            }
+        }
+
+        follow_.assign(nonterminals_.size(), Bits(terminal_count));
+        follow_[0].Set(0);
+        changed = true;
+        while (changed) {
+            changed = false;
+            for (const Rule &rule : rules_) {
+                for (size_t i = 0; i < rule.rhs.size(); ++i) {
+                    if (!rule.rhs[i].nonterminal) {
+                        continue;
+                    }
+                    Bits &follow = follow_[rule.rhs[i].id];
+                    Bits rest(terminal_count);
+                    if (FirstOfSequence(rule, i + 1, rest)) {
+                        changed = follow.Merge(follow_[rule.lhs]) || changed;
+                    }
+                    changed = follow.Merge(rest) || changed;
+                }
+            }
+        }
+    }
+
+    // Adds FIRST of the symbols of a rule starting from `from` to `out`,
+    // returns whether they can all derive epsilon.
+    constexpr bool FirstOfSequence(const Rule &rule, size_t from, Bits &out) const {
+        for (size_t i = from; i < rule.rhs.size(); ++i) {
+            const Symbol &symbol = rule.rhs[i];
+            if (!symbol.nonterminal) {
+                out.Set(symbol.id);
+                return false;
+            }
+            out.Merge(first_[symbol.id]);
+            if (!nullable_[symbol.id]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // The items of a state given its kernel, the kernel items first, then the
+    // items with the dot at the start in the order of the rules.
+    constexpr std::vector<Item> Closure(const std::vector<Item> &kernel) const {
+        size_t terminal_count = terminals_.size();
+        std::vector<Bits> initial(rules_.size(), Bits(terminal_count));
+        std::vector<size_t> pending;
+        auto propagate = [&](size_t rule, size_t dot, const Bits &lookahead) {
+            const std::vector<Symbol> &rhs = rules_[rule].rhs;
+            if (dot >= rhs.size() || !rhs[dot].nonterminal) {
+                return;
+            }
+            Bits first(terminal_count);
+            if (FirstOfSequence(rules_[rule], dot + 1, first)) {
+                first.Merge(lookahead);
+            }
+            for (size_t r : rules_by_lhs_[rhs[dot].id]) {
+                if (initial[r].Merge(first)) {
+                    pending.push_back(r);
+                }
+            }
+        };
+
+        std::vector<Item> items;
+        for (const Item &item : kernel) {
+            if (item.dot == 0) {
+                if (initial[item.rule].Merge(item.lookahead)) {
+                    pending.push_back(item.rule);
+                }
+            } else {
+                items.push_back(item);
+                propagate(item.rule, item.dot, item.lookahead);
+            }
+        }
+        while (!pending.empty()) {
+            size_t r = pending.back();
+            pending.pop_back();
+            Bits lookahead = initial[r];
+            propagate(r, 0, lookahead);
+        }
+        for (size_t r = 0; r < rules_.size(); ++r) {
+            if (!initial[r].Empty()) {
+                items.push_back(Item{r, 0, std::move(initial[r])});
+            }
+        }
+        return items;
+    }
+
+    // The kernels of the states reached from the items over each symbol, in
+    // one pass over the items: terminals first, then non-terminals, indexed
+    // by `SymbolIndex`.
+    constexpr std::vector<std::vector<Item>> Advance(const std::vector<Item> &items) const {
+        std::vector<std::vector<Item>> kernels(terminals_.size() + nonterminals_.size());
+        for (const Item &item : items) {
+            const std::vector<Symbol> &rhs = rules_[item.rule].rhs;
+            if (item.dot < rhs.size()) {
+                kernels[SymbolIndex(rhs[item.dot])].push_back(
+                    Item{item.rule, item.dot + 1, item.lookahead}
+                );
+            }
+        }
+        for (std::vector<Item> &kernel : kernels) {
+            std::sort(kernel.begin(), kernel.end(), [](const Item &lhs, const Item &rhs) {
+                return std::pair(lhs.rule, lhs.dot) < std::pair(rhs.rule, rhs.dot);
+            });
+        }
+        return kernels;
+    }
+
+    constexpr size_t SymbolIndex(const Symbol &symbol) const {
+        return symbol.nonterminal ? terminals_.size() + symbol.id : symbol.id;
+    }
+
+    // Builds the canonical collection of LR(1) states breadth-first along with
+    // the action and goto tables.
+    constexpr void BuildStates() {
+        size_t terminal_count = terminals_.size();
+        Bits end_of_input(terminal_count);
+        end_of_input.Set(0);
+        std::vector<std::vector<Item>> kernels;
+        kernels.push_back({Item{0, 0, end_of_input}});
+        // the states by the rule of the first kernel item, to look kernels up
+        std::vector<std::vector<size_t>> states_by_rule(rules_.size());
+        states_by_rule[0].push_back(0);
+
+        for (size_t s = 0; s < kernels.size(); ++s) {
+            std::vector<Item> items = Closure(kernels[s]);
+            actions_.emplace_back(terminal_count, 0);
+            gotos_.emplace_back(nonterminals_.size(), 0);
+            std::vector<size_t> shifts(terminal_count, 0);
+            std::vector<std::vector<Item>> next_kernels = Advance(items);
+            for (bool nonterminal : {false, true}) {
+                size_t count = nonterminal ? nonterminals_.size() : terminal_count;
+                for (size_t id = 0; id < count; ++id) {
+                    std::vector<Item> &kernel =
+                        next_kernels[SymbolIndex(Symbol{nonterminal, id})];
+                    if (kernel.empty()) {
+                        continue;
+                    }
+                    std::vector<size_t> &candidates = states_by_rule[kernel[0].rule];
+                    auto found = std::find_if(
+                        candidates.begin(), candidates.end(),
+                        [&](size_t state) {
+                            return kernels[state] == kernel;
+                        }
+                    );
+                    size_t next = found == candidates.end() ? kernels.size() : *found;
+                    if (next == kernels.size()) {
+                        candidates.push_back(next);
+                        kernels.push_back(std::move(kernel));
+                    }
+                    (nonterminal ? gotos_[s] : shifts)[id] = next;
+                }
+            }
+
+            for (const Item &item : items) {
+                const std::vector<Symbol> &rhs = rules_[item.rule].rhs;
+                if (item.dot < rhs.size()) {
+                    if (!rhs[item.dot].nonterminal) {
+                        size_t t = rhs[item.dot].id;
+                        PutAction(s, t, shifts[t] << 2 | size_t(ActionType::SHIFT));
+                    }
+                } else if (item.rule == 0) {
+                    PutAction(s, 0, size_t(ActionType::ACCEPT));
+                } else {
+                    for (size_t t = 0; t < terminal_count; ++t) {
+                        if (item.lookahead.Test(t)) {
+                            PutAction(s, t, item.rule << 2 | size_t(ActionType::REDUCE));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    constexpr void PutAction(size_t state, size_t terminal, size_t action) {
+        size_t &existing = actions_[state][terminal];
+        if (existing == 0 || existing == action) {
+            existing = action;
+            return;
+        }
+        auto type = [](size_t packed) {
+            return ActionType(packed & 3);
+        };
+        if (type(existing) == ActionType::SHIFT || type(action) == ActionType::SHIFT) {
+            throw CompileError("Provided grammar is ambiguous (shift/reduce conflict)");
+        }
+        if (type(existing) == ActionType::REDUCE && type(action) == ActionType::REDUCE) {
+            throw CompileError("Provided grammar is ambiguous (reduce/reduce conflict)");
+        }
+        throw CompileError("Provided grammar is ambiguous (conflict in action table)");
+    }
+
+    std::vector<bool> defined_;
+    std::vector<std::vector<size_t>> rules_by_lhs_;
+    std::vector<Bits> first_;
+    std::vector<bool> nullable_;
+};
+}  // namespace detail
+
+/**
+ * @brief Builds the canonical LR(1) tables of a grammar.
+ * @details The grammar is written in the same BNF as the input of `gen`, e.g.
+ * @code
+ * static constexpr auto kGrammar = pargen::compile(R"(
+ *     NUM = [0-9]+
+ *     <E> = <E> '+' NUM | NUM
+ * )");
+ * using Parser = pargen::LRParser<pargen::CompiledTables<kGrammar>>;
+ * @endcode
+ * When evaluated as a constant expression, no work is done at startup and an
+ * ambiguous or malformed grammar fails to compile.
+ *
+ * Only a subset of what `gen` takes is supported:
+ * - plain BNF: rules, alternatives, quote and regex terminals, `EPSILON`; the
+ *   EBNF operators `*`, `+`, `?` and groups are rejected, lists have to be
+ *   written as recursive rules;
+ * - the grammar is used as written, without the rewrites of `--optimize`;
+ * - there is no lexer: regexes of terminals are not checked, and tokens are
+ *   made with the kinds from `TerminalKind`;
+ * - the tables fit into the capacities below, 128 states, 32 terminals,
+ *   32 non-terminals and 64 rules by default. Larger grammars also run into
+ *   the limits of the compiler on constant evaluation (e.g.
+ *   `-fconstexpr-ops-limit` of GCC) and are better generated with `gen`.
+ *
+ * Within the subset the states and the parse trees are the same as those of
+ * `gen` and `GrammarEngine`.
+ * @tparam MaxStates See `CompiledGrammar`.
+ * @tparam MaxTerminals See `CompiledGrammar`.
+ * @tparam MaxNonTerminals See `CompiledGrammar`.
+ * @tparam MaxRules See `CompiledGrammar`.
+ * @param source The grammar. The names in the result point into it, so it has
+ * to outlive the result; a string literal always does.
+ * @return The tables.
+ * @throws CompileError if the grammar is malformed, is outside the subset, is
+ * not LR(1) or does not fit into the capacities.
+ */
+template <size_t MaxStates = 128, size_t MaxTerminals = 32, size_t MaxNonTerminals = 32, size_t MaxRules = 64>
+constexpr CompiledGrammar<MaxStates, MaxTerminals, MaxNonTerminals, MaxRules> compile(
+    std::string_view source
+) {
+    detail::GrammarCompiler compiler(source);
+    CompiledGrammar<MaxStates, MaxTerminals, MaxNonTerminals, MaxRules> g;
+    g.state_count = compiler.actions_.size();
+    g.terminal_count = compiler.terminals_.size();
+    g.nonterminal_count = compiler.nonterminals_.size();
+    g.rule_count = compiler.rules_.size();
+    if (g.state_count > MaxStates) {
+        throw CompileError("The grammar has more states than MaxStates");
+    }
+    if (g.terminal_count > MaxTerminals) {
+        throw CompileError("The grammar has more terminals than MaxTerminals");
+    }
+    if (g.nonterminal_count > MaxNonTerminals) {
+        throw CompileError("The grammar has more non-terminals than MaxNonTerminals");
+    }
+    if (g.rule_count > MaxRules) {
+        throw CompileError("The grammar has more rules than MaxRules");
+    }
+
+    for (size_t t = 0; t < g.terminal_count; ++t) {
+        g.terminal_names[t] = compiler.terminals_[t].name;
+        g.terminal_is_quote[t] = compiler.terminals_[t].quote;
+    }
+    for (size_t nt = 0; nt < g.nonterminal_count; ++nt) {
+        g.nonterminal_names[nt] = compiler.nonterminals_[nt];
+        for (size_t w = 0; w < (g.terminal_count + 63) / 64; ++w) {
+            g.follow[nt][w] = compiler.follow_[nt].Word(w);
+        }
+    }
+    for (size_t s = 0; s < g.state_count; ++s) {
+        for (size_t t = 0; t < g.terminal_count; ++t) {
+            g.actions[s][t] = static_cast<uint16_t>(compiler.actions_[s][t]);
+        }
+        for (size_t nt = 0; nt < g.nonterminal_count; ++nt) {
+            g.gotos[s][nt] = static_cast<uint16_t>(compiler.gotos_[s][nt]);
+        }
+    }
+    for (size_t r = 0; r < g.rule_count; ++r) {
+        g.rule_lhs[r] = static_cast<uint16_t>(compiler.rules_[r].lhs);
+        g.rule_length[r] = static_cast<uint16_t>(compiler.rules_[r].rhs.size());
+    }
+    return g;
+}
+
+/**
+ * @struct CompiledTables
+ * @brief The tables of a grammar built by `compile` in the form `LRParser`
+ * takes, along with the token types to parse with.
+ * @tparam Grammar The result of `compile`, a constexpr variable.
+ */
+template <const auto &Grammar>
+struct CompiledTables {
+    struct Terminal {
+        uint32_t kind = 0;
+        /**
+         * @brief The lexeme, pointing into the input buffer.
+         */
+        std::string_view repr = {};
+
+        constexpr std::string_view Name() const {
+            return Grammar.terminal_names[kind];
+        }
+        constexpr bool IsQuote() const {
+            return Grammar.terminal_is_quote[kind];
+        }
+    };
+
+    struct NonTerminal {
+        uint32_t kind = 0;
+
+        constexpr std::string_view Name() const {
+            return Grammar.nonterminal_names[kind];
+        }
+    };
+
+    using TokenStream = pargen::TokenStream<Terminal>;
+    using LineIndex = pargen::LineIndex;
+
+    static constexpr const auto &kActions = Grammar.actions;
+    static constexpr const auto &kGoto = Grammar.gotos;
+    static constexpr const auto &kRuleLhs = Grammar.rule_lhs;
+    static constexpr const auto &kRuleLength = Grammar.rule_length;
+    static constexpr const auto &kFollow = Grammar.follow;
+};
+}  // namespace pargen
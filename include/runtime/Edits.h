@@ -0,0 +1,34 @@
+/**
+ * @file Edits.h
+ * @brief Provides the descriptions of edits of an input that incremental
+ * lexing and parsing take.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <cstddef>
+
+namespace pargen {
+/**
+ * @struct TextEdit
+ * @brief Describes an edit of a buffer: `removed` bytes starting at offset
+ * `start` of the previous buffer were replaced by `inserted` bytes.
+ */
+struct TextEdit {
+    size_t start = 0;
+    size_t removed = 0;
+    size_t inserted = 0;
+};
+
+/**
+ * @struct TokenEdit
+ * @brief Describes an edit of a token stream: `removed` tokens starting at
+ * index `start` of the previous stream were replaced by `inserted` tokens.
+ */
+struct TokenEdit {
+    size_t start = 0;
+    size_t removed = 0;
+    size_t inserted = 0;
+};
+}  // namespace pargen
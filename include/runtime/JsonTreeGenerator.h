@@ -0,0 +1,72 @@
+/**
+ * @file JsonTreeGenerator.h
+ * @brief Provides a class for writing parse trees to JSON files. Requires
+ * `nlohmann/json`.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <variant>
+
+#include "ParseTree.h"
+
+namespace pargen {
+/**
+ * @class JsonTreeGenerator
+ * @brief Writes a parse tree to a JSON file: every node is an object with the
+ * name of its symbol, the lexeme of a non-quote terminal and the children of a
+ * non-terminal.
+ * @tparam Tables The tables of the grammar, see `LRParser`.
+ */
+template <class Tables>
+class JsonTreeGenerator {
+public:
+    /**
+     * @brief Constructs a JsonTreeGenerator object.
+     * @param filename The file to write to.
+     * @param indent The number of spaces per indent.
+     */
+    explicit JsonTreeGenerator(const std::string &filename, int indent = 4)
+        : filename_(filename), indent_(indent) {}
+
+    void Generate(const ParseTree<Tables> &tree) const {
+        nlohmann::ordered_json j;
+        if (tree.GetRoot()) {
+            j = GenerateForNode(*tree.GetRoot(), 0);
+        }
+        std::ofstream out(filename_);
+        out << j.dump(indent_);
+    }
+
+private:
+    static nlohmann::ordered_json GenerateForNode(
+        const ParseTreeNode<Tables> &node, std::ptrdiff_t outer
+    ) {
+        using Terminal = typename Tables::Terminal;
+        using NonTerminal = typename Tables::NonTerminal;
+        nlohmann::ordered_json tree;
+        if (std::holds_alternative<Terminal>(node.value)) {
+            Terminal t = node.GetTerminal(outer);
+            tree["value"] = std::string(t.Name());
+            if (!t.IsQuote()) {
+                tree["lexeme"] = std::string(t.repr);
+            }
+        } else {
+            tree["type"] = std::string(std::get<NonTerminal>(node.value).Name());
+        }
+        for (const auto &child : node.children) {
+            tree["children"].push_back(GenerateForNode(*child, outer + node.shift));
+        }
+        return tree;
+    }
+
+    std::string filename_;
+    int indent_;
+};
+}  // namespace pargen
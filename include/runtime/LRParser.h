@@ -0,0 +1,613 @@
+/**
+ * @file LRParser.h
+ * @brief Provides the LR parsing driver that generated parsers instantiate
+ * with their tables.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "Edits.h"
+#include "ParseTree.h"
+
+namespace pargen {
+enum class ActionType : uint8_t {
+    ERROR,
+    SHIFT,
+    REDUCE,
+    ACCEPT
+};
+
+struct Action {
+    ActionType type = ActionType::ERROR;
+    size_t value = 0;
+};
+
+/**
+ * @class ReuseCursor
+ * @brief Walks a previous parse tree in token order, yielding the outermost
+ * node that starts at the requested token position.
+ * @tparam Tables The tables of the grammar, see `LRParser`.
+ */
+template <class Tables>
+class ReuseCursor {
+public:
+    using Node = ParseTreeNode<Tables>;
+
+    explicit ReuseCursor(std::shared_ptr<Node> root) : root_(std::move(root)) {
+        if (root_) {
+            stack_.push_back(Frame{&root_, 0, 0, 0});
+        }
+    }
+
+    /**
+     * @brief Finds the outermost node starting at a token position.
+     * @param pos The position. Positions must be requested in non-decreasing
+     * order.
+     * @param outer Set to the sum of the shifts of the ancestors of the node.
+     * @return The node, or `nullptr` if no node starts there.
+     */
+    const std::shared_ptr<Node> *Seek(size_t pos, std::ptrdiff_t &outer) {
+        while (!stack_.empty()) {
+            const Frame &top = stack_.back();
+            const Node &node = **top.node;
+            if (top.start + node.width <= pos) {
+                Next();
+            } else if (top.start == pos) {
+                outer = top.outer;
+                return top.node;
+            } else if (!node.children.empty()) {
+                stack_.push_back(
+                    Frame{&node.children[0], top.start, 0, top.outer + node.shift}
+                );
+            } else {
+                return nullptr;
+            }
+        }
+        return nullptr;
+    }
+
+private:
+    struct Frame {
+        const std::shared_ptr<Node> *node;
+        size_t start;
+        size_t index;
+        std::ptrdiff_t outer;
+    };
+
+    void Next() {
+        Frame done = stack_.back();
+        stack_.pop_back();
+        if (stack_.empty()) {
+            return;
+        }
+        const Node &parent = **stack_.back().node;
+        if (done.index + 1 < parent.children.size()) {
+            stack_.push_back(Frame{
+                &parent.children[done.index + 1],
+                done.start + (*done.node)->width,
+                done.index + 1,
+                done.outer
+            });
+        }
+    }
+
+    std::shared_ptr<Node> root_;
+    std::vector<Frame> stack_;
+};
+
+/**
+ * @brief A lexer the parser can pull tokens from: `Next` stores the next
+ * token and returns false at the end of input, `GetSource` returns the
+ * buffer being scanned.
+ */
+template <class Lexer, class Terminal>
+concept PullLexer = requires(Lexer &lexer, Terminal &token) {
+    { lexer.Next(token) } -> std::convertible_to<bool>;
+    { lexer.GetSource() } -> std::convertible_to<std::string_view>;
+};
+
+/**
+ * @class LRParser
+ * @brief A table-driven LR parser with error recovery and incremental
+ * reparsing.
+ * @details The driver is the same for every grammar; a grammar supplies only
+ * `Tables`, a struct with
+ * - the token types of its lexer: `Terminal` (with `kind`, `repr` and
+ *   optionally `Name()`, kind 0 being the end of input), `NonTerminal` (with
+ *   `kind`),
+ *   `TokenStream` (with `size()`, `operator[]` and `GetSource()`) and
+ *   `LineIndex` (constructible from the buffer, with `Locate(token)`), as a
+ *   rule `pargen::LineIndex`;
+ * - the static arrays `kActions[state][terminal]`, with actions packed as
+ *   `value << 2 | type` in the numbering of `ActionType`, so 0 is an error,
+ *   `kGoto[state][non-terminal]`, `kRuleLhs[rule]`, `kRuleLength[rule]` and
+ *   `kFollow[non-terminal][word]`, the FOLLOW sets as bitsets of terminal
+ *   kinds;
+ * - optionally `kRuleFlatten[rule]`, nonzero for the recursive rules of EBNF
+ *   repetitions, `R -> R ...`: their symbols are appended to the node of `R`
+ *   instead of nesting it, so a list of any length is a single node.
+ *
+ * The arrays may have any unsigned element types, and each instantiation reads
+ * them at their own width. They are usually static, but may also be members
+ * of a `Tables` object passed to the constructor, for tables built at run
+ * time; anything indexable twice will do for the two-dimensional ones.
+ *
+ * An instance may be reused for any number of `Parse` calls (but not
+ * concurrently). Its stacks keep their capacity between calls, so once warmed
+ * up on inputs of similar nesting depth, reusing the same instance performs no
+ * heap allocations for stack management. The tree returned by `GetParseTree`
+ * stays valid after subsequent `Parse` calls.
+ * @tparam Tables The tables of the grammar.
+ */
+template <class Tables>
+class LRParser {
+public:
+    using Terminal = typename Tables::Terminal;
+    using NonTerminal = typename Tables::NonTerminal;
+    using TokenStream = typename Tables::TokenStream;
+    using Node = ParseTreeNode<Tables>;
+    using Tree = ParseTree<Tables>;
+
+    /**
+     * @brief Constructs an LRParser object.
+     * @param tables The tables, needed only if they are not static.
+     */
+    explicit LRParser(Tables tables = Tables()) : tables_(std::move(tables)) {
+        state_stack_.reserve(kInitialStackCapacity);
+        node_stack_.reserve(kInitialStackCapacity);
+    }
+
+    /**
+     * @brief Parses a stream of tokens.
+     * @param stream The tokens, without the end of input.
+     * @return 0 on success, the number of errors recovered from if there were
+     * any, or minus that number if the parser could not recover.
+     */
+    int Parse(const std::vector<Terminal> &stream) {
+        StreamSource source(stream);
+        return Run(source, nullptr, TokenEdit{});
+    }
+
+    /**
+     * @brief Same as above for packed tokens.
+     */
+    int Parse(const TokenStream &stream) {
+        StreamSource source(stream);
+        return Run(source, nullptr, TokenEdit{});
+    }
+
+    /**
+     * @brief Parses the tokens of a lexer, pulling them only when a new
+     * lookahead is needed.
+     * @details The input is never materialized as a vector of tokens: memory
+     * use is bounded by the depth of the stacks and the size of the tree.
+     * @param lexer The lexer.
+     * @return See above.
+     */
+    template <class Lexer>
+        requires PullLexer<Lexer, Terminal>
+    int Parse(Lexer &lexer) {
+        LexerSource<Lexer> source(lexer);
+        return Run(source, nullptr, TokenEdit{});
+    }
+
+    /**
+     * @brief Parses an edited stream of tokens, reusing the unaffected parts
+     * of the tree of the previous one.
+     * @details Every subtree of `previous` that lies outside of the edit and
+     * is reached in the same parser state is reused, so the work done is
+     * proportional to the size of the edit and the depth of the tree rather
+     * than to the length of the input. Falls back to a full parse if
+     * `previous` was produced with errors.
+     *
+     * The exception are the flattened lists of EBNF repetitions (see
+     * `kRuleFlatten`): a list node that contains the edit is built anew, from
+     * its elements reused one by one, so an edit also costs time in the
+     * number of elements of every list it lies in. A document that is one
+     * long list is thus reparsed in time linear in its length, if with a far
+     * smaller constant than a full parse; nesting the list, e.g. into
+     * sections, bounds the cost. Keeping lists flat is what makes a list of
+     * any length a single node, and a chunked list would change that shape.
+     *
+     * A generated lexer updates the tokens of an edited buffer with `Relex`,
+     * which lexes only around the edit and returns the `TokenEdit`.
+     *
+     * Reused subtrees are shared with `previous`. Where their lexemes moved to
+     * other bytes, e.g. behind an edit or into another buffer, only the
+     * `shift` of their root is changed, on a copy of it. The new tree thus
+     * refers only to the buffer `stream` was lexed from, and the previous one
+     * may be released.
+     * @param stream The input of `previous` with `edit` applied.
+     * @param previous The tree of the previous input.
+     * @param edit The edit.
+     * @return See `Parse`.
+     */
+    int Reparse(
+        const std::vector<Terminal> &stream, const Tree &previous,
+        const TokenEdit &edit
+    ) {
+        return ReparseStream(stream, previous, edit);
+    }
+
+    /**
+     * @brief Same as above for packed tokens.
+     */
+    int Reparse(
+        const TokenStream &stream, const Tree &previous, const TokenEdit &edit
+    ) {
+        return ReparseStream(stream, previous, edit);
+    }
+
+    /**
+     * @brief Returns the tree of the last parse.
+     * @details The tree has no root if the parser could not recover from an
+     * error before anything was shifted.
+     */
+    Tree GetParseTree() const {
+        if (node_stack_.empty()) {
+            return Tree(nullptr, true);
+        }
+        return Tree(node_stack_.back(), last_status_ != 0);
+    }
+
+private:
+    static constexpr size_t kInitialStackCapacity = 64;
+
+    // Reads the lookahead from a vector of tokens or a `TokenStream`.
+    template <class Stream>
+    class StreamSource {
+    public:
+        // Whether subtrees of a previous tree can be skipped over.
+        static constexpr bool kRandomAccess = true;
+
+        explicit StreamSource(const Stream &stream) : stream_(stream) {}
+
+        Terminal Peek() const {
+            return pos_ < stream_.size() ? stream_[pos_] : Terminal{};
+        }
+        void Advance() {
+            ++pos_;
+        }
+        // Whether the end of input has been consumed as well.
+        bool IsPastEnd() const {
+            return pos_ > stream_.size();
+        }
+
+        size_t GetPosition() const {
+            return pos_;
+        }
+        void Skip(size_t count) {
+            pos_ += count;
+        }
+        const Stream &GetStream() const {
+            return stream_;
+        }
+        // The buffer the tokens were lexed from, if known.
+        std::string_view GetBuffer() const {
+            if constexpr (std::is_same_v<Stream, TokenStream>) {
+                return stream_.GetSource();
+            } else {
+                return {};
+            }
+        }
+
+    private:
+        const Stream &stream_;
+        size_t pos_ = 0;
+    };
+
+    // Asks the lexer for the next token each time the lookahead is consumed.
+    template <class Lexer>
+    class LexerSource {
+    public:
+        static constexpr bool kRandomAccess = false;
+
+        explicit LexerSource(Lexer &lexer) : lexer_(lexer) {
+            Fetch();
+        }
+
+        const Terminal &Peek() const {
+            return current_;
+        }
+        void Advance() {
+            if (current_.kind == 0) {
+                past_end_ = true;
+            } else {
+                Fetch();
+            }
+        }
+        bool IsPastEnd() const {
+            return past_end_;
+        }
+        std::string_view GetBuffer() const {
+            return lexer_.GetSource();
+        }
+
+    private:
+        void Fetch() {
+            if (!lexer_.Next(current_)) {
+                current_ = Terminal{};
+            }
+        }
+
+        Lexer &lexer_;
+        Terminal current_;
+        bool past_end_ = false;
+    };
+
+    Action GetAction(size_t state, uint32_t terminal) const {
+        size_t packed = tables_.kActions[state][terminal];
+        return Action{static_cast<ActionType>(packed & 3), packed >> 2};
+    }
+
+    size_t GetGoto(size_t state, const NonTerminal &nt) const {
+        return tables_.kGoto[state][nt.kind];
+    }
+
+    // Whether a rule appends to the node of its first symbol.
+    bool ExtendsList(size_t rule) const {
+        if constexpr (requires { tables_.kRuleFlatten[rule]; }) {
+            return tables_.kRuleFlatten[rule] != 0;
+        } else {
+            return false;
+        }
+    }
+
+    bool InFollowSet(const NonTerminal &nt, const Terminal &t) const {
+        return (tables_.kFollow[nt.kind][t.kind / 64] >> (t.kind % 64)) & 1;
+    }
+
+    // How a token is shown in error messages.
+    static std::string_view Describe(const Terminal &t) {
+        if (!t.repr.empty()) {
+            return t.repr;
+        }
+        if constexpr (requires { t.Name(); }) {
+            return t.Name();
+        } else {
+            return t.kind == 0 ? "$" : "<empty>";
+        }
+    }
+
+    template <class Source>
+    int Run(Source &source, ReuseCursor<Tables> *cursor, const TokenEdit &edit) {
+        Clear();
+
+        Terminal a = source.Peek();
+        std::optional<typename Tables::LineIndex> lines;
+        bool done = false;
+        int return_state = 0;
+        while (!done) {
+            if constexpr (Source::kRandomAccess) {
+                if (cursor && TryReuse(source, *cursor, edit)) {
+                    a = source.Peek();
+                    continue;
+                }
+            }
+            size_t s = state_stack_.back();
+            Action action = GetAction(s, a.kind);
+            switch (action.type) {
+                case ActionType::SHIFT: {
+                    node_stack_.push_back(
+                        std::make_shared<Node>(Node{a, {}, s, 1, 0})
+                    );
+                    state_stack_.push_back(action.value);
+                    source.Advance();
+                    a = source.Peek();
+                    break;
+                }
+                case ActionType::REDUCE: {
+                    NonTerminal lhs{static_cast<uint32_t>(tables_.kRuleLhs[action.value])};
+                    size_t n = tables_.kRuleLength[action.value];
+                    size_t width = 0;
+                    for (size_t i = node_stack_.size() - n; i < node_stack_.size(); ++i) {
+                        width += node_stack_[i]->width;
+                    }
+                    if (ExtendsList(action.value)) {
+                        std::shared_ptr<Node> &list = node_stack_[node_stack_.size() - n];
+                        if (list.use_count() > 1) {
+                            // never modify the nodes of a previous tree
+                            list = std::make_shared<Node>(*list);
+                        }
+                        for (auto it = node_stack_.end() - n + 1; it != node_stack_.end(); ++it) {
+                            // the shift of the list applies to its new children too
+                            if (list->shift != 0) {
+                                if (it->use_count() > 1) {
+                                    *it = std::make_shared<Node>(**it);
+                                }
+                                (*it)->shift -= list->shift;
+                            }
+                            list->children.push_back(std::move(*it));
+                        }
+                        list->width = width;
+                        node_stack_.resize(node_stack_.size() - n + 1);
+                        state_stack_.resize(state_stack_.size() - n);
+                        state_stack_.push_back(GetGoto(state_stack_.back(), lhs));
+                        current_nt_ = lhs;
+                        break;
+                    }
+                    std::vector<std::shared_ptr<Node>> new_children(
+                        std::make_move_iterator(node_stack_.end() - n),
+                        std::make_move_iterator(node_stack_.end())
+                    );
+                    node_stack_.resize(node_stack_.size() - n);
+                    state_stack_.resize(state_stack_.size() - n);
+                    size_t t = state_stack_.back();
+                    node_stack_.push_back(std::make_shared<Node>(
+                        Node{lhs, std::move(new_children), t, width, 0}
+                    ));
+                    state_stack_.push_back(GetGoto(t, lhs));
+                    current_nt_ = lhs;
+                    break;
+                }
+                case ActionType::ACCEPT:
+                    done = true;
+                    break;
+                case ActionType::ERROR: {
+                    if constexpr (Source::kRandomAccess) {
+                        if (cursor) {
+                            // recovery depends on the reductions made so far,
+                            // so erroneous input is handled by a full parse
+                            Source restarted(source.GetStream());
+                            return Run(restarted, nullptr, TokenEdit{});
+                        }
+                    }
+                    std::cerr << "Error on token " << Describe(a);
+                    if (!source.GetBuffer().empty()) {
+                        // positions are only needed from now on
+                        if (!lines) {
+                            lines.emplace(source.GetBuffer());
+                        }
+                        auto position = lines->Locate(a);
+                        std::cerr << " at " << position.line << ":" << position.column;
+                    }
+                    std::cerr << ", trying to recover" << std::endl;
+                    ++return_state;
+                    last_status_ = return_state;
+                    if (!current_nt_) {
+                        std::cerr << "Error, cannot recover" << std::endl;
+                        return -return_state;
+                    }
+                    bool recovered = false;
+                    while (!source.IsPastEnd() && !recovered) {
+                        if (InFollowSet(*current_nt_, source.Peek())) {
+                            recovered = true;
+                        }
+                        source.Advance();
+                    }
+                    if (!recovered) {
+                        std::cerr << "Error, cannot recover" << std::endl;
+                        return -return_state;
+                    }
+                    if (!source.IsPastEnd()) {
+                        a = source.Peek();
+                    }
+                }
+            }
+        }
+        return return_state;
+    }
+
+    template <class Stream>
+    int ReparseStream(
+        const Stream &stream, const Tree &previous, const TokenEdit &edit
+    ) {
+        if (previous.HasErrors()) {
+            return Parse(stream);
+        }
+        ReuseCursor<Tables> cursor(previous.GetRoot());
+        StreamSource source(stream);
+        return Run(source, &cursor, edit);
+    }
+
+    void Clear() {
+        last_status_ = 0;
+        current_nt_.reset();
+        state_stack_.clear();
+        state_stack_.push_back(0);
+        node_stack_.clear();
+    }
+
+    template <class Source>
+    bool TryReuse(
+        Source &source, ReuseCursor<Tables> &cursor, const TokenEdit &edit
+    ) {
+        size_t pos = source.GetPosition();
+        size_t old_pos = pos;
+        if (pos >= edit.start + edit.inserted) {
+            old_pos = pos - edit.inserted + edit.removed;
+        } else if (pos >= edit.start) {
+            return false;
+        }
+        // a subtree is reusable if neither it nor its lookahead was edited
+        size_t s = state_stack_.back();
+        std::ptrdiff_t outer = 0;
+        const std::shared_ptr<Node> *candidate = cursor.Seek(old_pos, outer);
+        while (candidate) {
+            const Node &node = **candidate;
+            if (!std::holds_alternative<NonTerminal>(node.value)) {
+                return false;
+            }
+            bool outside_edit = old_pos + node.width < edit.start ||
+                                old_pos >= edit.start + edit.removed;
+            if (node.state == s && outside_edit) {
+                const NonTerminal &nt = std::get<NonTerminal>(node.value);
+                node_stack_.push_back(Moved(*candidate, outer, source.Peek()));
+                state_stack_.push_back(GetGoto(s, nt));
+                source.Skip(node.width);
+                current_nt_ = nt;
+                return true;
+            }
+            outer += node.shift;
+            candidate = nullptr;
+            for (const auto &child : node.children) {
+                if (child->width > 0) {
+                    candidate = &child;
+                    break;
+                }
+            }
+        }
+        return false;
+    }
+
+    // A subtree of the previous tree placed at the current position. Its
+    // tokens were not edited, so they are the same bytes as before, possibly
+    // at another address: the subtree is moved by where its first token is
+    // now, `first`. `outer` is the sum of the shifts of its previous ancestors.
+    static std::shared_ptr<Node> Moved(
+        const std::shared_ptr<Node> &node, std::ptrdiff_t outer,
+        const Terminal &first
+    ) {
+        if (node->width == 0) {
+            return node;
+        }
+        const Node *leaf = node.get();
+        std::ptrdiff_t inner = 0;
+        while (!leaf->children.empty()) {
+            for (const auto &child : leaf->children) {
+                if (child->width > 0) {
+                    leaf = child.get();
+                    break;
+                }
+            }
+            inner += leaf->shift;
+        }
+        const char *was = std::get<Terminal>(leaf->value).repr.data();
+        const char *is = first.repr.data();
+        std::ptrdiff_t shift = outer + node->shift;
+        if (was != nullptr && is != nullptr) {
+            shift = static_cast<std::ptrdiff_t>(
+                reinterpret_cast<std::uintptr_t>(is) -
+                reinterpret_cast<std::uintptr_t>(was)
+            ) - inner;
+        }
+        if (shift == node->shift) {
+            return node;
+        }
+        auto moved = std::make_shared<Node>(*node);
+        moved->shift = shift;
+        return moved;
+    }
+
+    [[no_unique_address]] Tables tables_;
+    int last_status_ = 0;
+    std::vector<size_t> state_stack_;
+    std::vector<std::shared_ptr<Node>> node_stack_;
+
+    std::optional<NonTerminal> current_nt_;
+};
+}  // namespace pargen
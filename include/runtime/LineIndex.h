@@ -0,0 +1,91 @@
+/**
+ * @file LineIndex.h
+ * @brief Provides the lookup of lines and columns in a buffer, shared by
+ * generated lexers, `GrammarEngine` and the parser runtime.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace pargen {
+/**
+ * @struct Position
+ * @brief The line and the column of a byte, both counted from 1; the column
+ * counts bytes.
+ */
+struct Position {
+    size_t line = 1;
+    size_t column = 1;
+};
+
+/**
+ * @class LineIndex
+ * @brief The starts of the lines of a buffer.
+ * @details Tokens carry no positions, only their lexemes in the buffer; an
+ * index is built once positions are needed, e.g. on the first error, in a
+ * single pass of `memchr`, which the C library vectorizes. It then locates any
+ * byte by a binary search.
+ */
+class LineIndex {
+public:
+    explicit LineIndex(std::string_view source) : source_(source) {
+        line_starts_.push_back(0);
+        const char *begin = source.data();
+        const char *end = begin + source.size();
+        for (const char *at = begin; at != end;) {
+            const void *newline = std::memchr(at, '\n', end - at);
+            if (!newline) {
+                break;
+            }
+            at = static_cast<const char *>(newline) + 1;
+            line_starts_.push_back(at - begin);
+        }
+    }
+
+    /**
+     * @brief Locates the byte at an offset of the buffer.
+     */
+    Position Locate(size_t offset) const {
+        auto next = std::upper_bound(line_starts_.begin(), line_starts_.end(), offset);
+        size_t line = next - line_starts_.begin();
+        return Position{line, offset - line_starts_[line - 1] + 1};
+    }
+
+    /**
+     * @brief Locates the first byte of a token lexed from the buffer; the end
+     * of input, which has no lexeme, is placed at the end of the buffer.
+     * @tparam Terminal The token type, with its lexeme in `repr`.
+     */
+    template <class Terminal>
+        requires requires(const Terminal &token) { token.repr.data(); }
+    Position Locate(const Terminal &token) const {
+        return Locate(
+            token.repr.empty() ? source_.size()
+                               : static_cast<size_t>(token.repr.data() - source_.data())
+        );
+    }
+
+    size_t GetLineCount() const {
+        return line_starts_.size();
+    }
+
+    /**
+     * @brief Returns the text of a line, counted from 1, without its newline.
+     */
+    std::string_view GetLine(size_t line) const {
+        size_t begin = line_starts_[line - 1];
+        size_t end = line < line_starts_.size() ? line_starts_[line] - 1 : source_.size();
+        return source_.substr(begin, end - begin);
+    }
+
+private:
+    std::string_view source_;
+    std::vector<size_t> line_starts_;
+};
+}  // namespace pargen
@@ -0,0 +1,155 @@
+/**
+ * @file ParseTree.h
+ * @brief Provides the parse tree built by generated parsers and the visitors
+ * that walk it.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace pargen {
+/**
+ * @class ParseTreePreorderVisitor
+ * @brief A visitor called for every node of a parse tree before its children.
+ * @tparam Tables The tables of the grammar, see `LRParser`.
+ */
+template <class Tables>
+class ParseTreePreorderVisitor {
+public:
+    virtual void VisitTerminal(const typename Tables::Terminal &t) = 0;
+    virtual void VisitNonTerminal(const typename Tables::NonTerminal &nt) = 0;
+    virtual ~ParseTreePreorderVisitor() = default;
+};
+
+/**
+ * @class ParseTreePostorderVisitor
+ * @brief A visitor called for every node of a parse tree after its children.
+ * @tparam Tables The tables of the grammar, see `LRParser`.
+ */
+template <class Tables>
+class ParseTreePostorderVisitor {
+public:
+    virtual void VisitTerminal(const typename Tables::Terminal &t) = 0;
+    virtual void VisitNonTerminal(const typename Tables::NonTerminal &nt) = 0;
+    virtual ~ParseTreePostorderVisitor() = default;
+};
+
+/**
+ * @struct ParseTreeNode
+ * @brief A node of a parse tree: a token and the nodes it was reduced from.
+ * @tparam Tables The tables of the grammar, see `LRParser`.
+ */
+template <class Tables>
+struct ParseTreeNode {
+    using Terminal = typename Tables::Terminal;
+    using NonTerminal = typename Tables::NonTerminal;
+
+    std::variant<Terminal, NonTerminal> value;
+    std::vector<std::shared_ptr<ParseTreeNode>> children;
+    /**
+     * @brief The parser state the node was pushed onto; used by
+     * `LRParser::Reparse` to reuse subtrees.
+     */
+    size_t state = 0;
+    /**
+     * @brief The number of tokens the node spans.
+     */
+    size_t width = 0;
+    /**
+     * @brief How many bytes the lexemes of the node and of the nodes below it
+     * lie away from where their `repr` points. Nonzero only for subtrees that
+     * `LRParser::Reparse` took over from the tree of a previous buffer.
+     */
+    std::ptrdiff_t shift = 0;
+
+    /**
+     * @brief Returns the token of a terminal node with its lexeme in the
+     * buffer of the tree.
+     * @param outer The sum of the shifts of the ancestors of the node.
+     */
+    Terminal GetTerminal(std::ptrdiff_t outer = 0) const {
+        Terminal t = std::get<Terminal>(value);
+        std::ptrdiff_t total = outer + shift;
+        if (total != 0 && t.repr.data() != nullptr) {
+            std::uintptr_t address = reinterpret_cast<std::uintptr_t>(t.repr.data());
+            t.repr = std::string_view(
+                reinterpret_cast<const char *>(address + total), t.repr.size()
+            );
+        }
+        return t;
+    }
+
+    void Accept(
+        ParseTreePreorderVisitor<Tables> &visitor, std::ptrdiff_t outer = 0
+    ) const {
+        if (std::holds_alternative<Terminal>(value)) {
+            visitor.VisitTerminal(GetTerminal(outer));
+        } else {
+            visitor.VisitNonTerminal(std::get<NonTerminal>(value));
+        }
+        for (const auto &child : children) {
+            child->Accept(visitor, outer + shift);
+        }
+    }
+
+    void Accept(
+        ParseTreePostorderVisitor<Tables> &visitor, std::ptrdiff_t outer = 0
+    ) const {
+        for (const auto &child : children) {
+            child->Accept(visitor, outer + shift);
+        }
+        if (std::holds_alternative<Terminal>(value)) {
+            visitor.VisitTerminal(GetTerminal(outer));
+        } else {
+            visitor.VisitNonTerminal(std::get<NonTerminal>(value));
+        }
+    }
+};
+
+/**
+ * @class ParseTree
+ * @brief The result of a parse: the root of the tree and whether errors were
+ * recovered from while building it. The root is null if nothing was parsed.
+ * @tparam Tables The tables of the grammar, see `LRParser`.
+ */
+template <class Tables>
+class ParseTree {
+public:
+    explicit ParseTree(
+        std::shared_ptr<ParseTreeNode<Tables>> root, bool has_errors = false
+    )
+        : root_(std::move(root)), has_errors_(has_errors) {}
+
+    std::shared_ptr<ParseTreeNode<Tables>> GetRoot() const {
+        return root_;
+    }
+
+    bool HasErrors() const {
+        return has_errors_;
+    }
+
+    void Accept(ParseTreePreorderVisitor<Tables> &visitor) const {
+        if (root_) {
+            root_->Accept(visitor);
+        }
+    }
+
+    void Accept(ParseTreePostorderVisitor<Tables> &visitor) const {
+        if (root_) {
+            root_->Accept(visitor);
+        }
+    }
+
+private:
+    std::shared_ptr<ParseTreeNode<Tables>> root_;
+    bool has_errors_;
+};
+}  // namespace pargen
@@ -0,0 +1,42 @@
+/**
+ * @file TokenStream.h
+ * @brief Provides a stream of tokens tied to the buffer they were lexed from,
+ * for parsers whose lexer is not generated.
+ * @author Vadim Melnikov
+ * @version 1.0
+ */
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace pargen {
+/**
+ * @class TokenStream
+ * @brief Tokens along with the buffer they were lexed from, so that errors are
+ * reported with their positions.
+ * @tparam Terminal The token type, with its lexeme in `repr`.
+ */
+template <class Terminal>
+class TokenStream {
+public:
+    TokenStream(std::vector<Terminal> tokens, std::string_view source)
+        : tokens_(std::move(tokens)), source_(source) {}
+
+    size_t size() const {
+        return tokens_.size();
+    }
+    const Terminal &operator[](size_t i) const {
+        return tokens_[i];
+    }
+    std::string_view GetSource() const {
+        return source_;
+    }
+
+private:
+    std::vector<Terminal> tokens_;
+    std::string_view source_;
+};
+}  // namespace pargen
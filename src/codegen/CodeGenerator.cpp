@@ -4,8 +4,10 @@
 #include <filesystem>
 
 #include "Entities.h"
+#include "Helpers.h"
 #include "LexerGenerator.h"
 #include "ParserGenerator.h"
+#include "SymbolTable.h"
 
 CodeGeneratorError::CodeGeneratorError(const std::string &msg) : msg_(msg) {
 }
@@ -15,8 +17,10 @@ const char *CodeGeneratorError::what() const noexcept {
 }
 
 CodeGenerator::CodeGenerator(
-    const std::string &folder, ActionTable &at, GotoTable &gt, FollowSets &fs,
-    const Grammar &g, bool add_json_generator, size_t json_indents
+    const std::string &folder, const ActionTable &at, const GotoTable &gt,
+    const FollowSets &fs, const Grammar &g, bool add_json_generator, size_t json_indents,
+    bool add_parallel_lexer, bool validate_utf8, const std::string &ns,
+    bool overwrite
 )
     : folder_(
           folder.starts_with('/')
@@ -25,21 +29,31 @@ CodeGenerator::CodeGenerator(
                 )
               : folder
       ),
+      g_(g),
       at_(at),
       gt_(gt),
       fs_(fs),
-      g_(g),
       add_json_generator_(add_json_generator),
-      json_indents_(json_indents) {
+      json_indents_(json_indents),
+      add_parallel_lexer_(add_parallel_lexer),
+      validate_utf8_(validate_utf8),
+      namespace_(ns) {
+    if (!IsNamespaceName(namespace_)) {
+        throw CodeGeneratorError("Invalid namespace name " + namespace_);
+    }
     bool created = std::filesystem::create_directories(folder_);
-    if (!created) {
+    if (!created && !(overwrite && std::filesystem::is_directory(folder_))) {
         throw CodeGeneratorError("Could not create directory " + folder_);
     }
 }
 
 void CodeGenerator::Generate() {
+    SymbolTable symbols(g_);
     try {
-        LexerGenerator lexer_generator(folder_, g_);
+        LexerGenerator lexer_generator(
+            folder_, g_, symbols, add_parallel_lexer_, validate_utf8_,
+            namespace_
+        );
         lexer_generator.Generate();
     } catch (const LexerGeneratorError &e) {
         std::rethrow_exception(std::current_exception());
@@ -47,7 +61,8 @@ void CodeGenerator::Generate() {
 
     try {
         ParserGenerator parser_generator(
-            folder_, g_, at_, gt_, fs_, add_json_generator_, json_indents_
+            folder_, g_, symbols, at_, gt_, fs_, add_json_generator_,
+            json_indents_, namespace_
         );
         parser_generator.Generate();
     } catch (const ParserGeneratorError &e) {
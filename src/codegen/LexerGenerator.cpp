@@ -1,9 +1,15 @@
 #include "LexerGenerator.h"
 
-#include <filesystem>
+#include <algorithm>
+#include <cstdint>
 #include <fstream>
+#include <map>
+#include <optional>
+#include <set>
 
 #include "Helpers.h"
+#include "KeywordTable.h"
+#include "LexerDFA.h"
 
 LexerGeneratorError::LexerGeneratorError(const std::string &msg) : msg_(msg) {
 }
@@ -12,44 +18,87 @@ const char *LexerGeneratorError::what() const noexcept {
     return msg_.c_str();
 }
 
-LexerGenerator::LexerGenerator(const std::string &folder, const Grammar &g)
-    : folder_(folder), g_(g) {
+LexerGenerator::LexerGenerator(
+    const std::string &folder, const Grammar &g, const SymbolTable &symbols,
+    bool add_parallel_driver, bool validate_utf8, const std::string &ns
+)
+    : folder_(folder),
+      g_(g),
+      symbols_(symbols),
+      add_parallel_driver_(add_parallel_driver),
+      validate_utf8_(validate_utf8),
+      namespace_(ns) {
 }
 
 void LexerGenerator::Generate() {
-    std::ofstream out(folder_ + "/Lexer.l");
-    out << "%option noyywrap\n";
-    out << "%{\n";
-    out << "#include <cstdio>\n";
-    out << "#include <cstdlib>\n";
-    out << "#include <iostream>\n";
+    Scanner scanner = BuildScanner();
+
+    std::ofstream out(folder_ + "/Lexer.cpp");
+    if (!scanner.run_sets.empty() || !scanner.keywords.empty() || validate_utf8_) {
+        out << "#include <bit>\n";
+    }
+    out << "#include <algorithm>\n";
+    out << "#include <cerrno>\n";
+    out << "#include <cstdint>\n";
+    out << "#include <cstring>\n";
+    out << "#include <fstream>\n";
+    out << "#include <iterator>\n";
+    out << "#include <string>\n";
+    out << "#include <string_view>\n";
+    if (add_parallel_driver_) {
+        out << "#include <thread>\n";
+    }
+    out << "#include <utility>\n";
     out << "#include <vector>\n";
     out << "\n";
-    out << "#include \"LexerFwd.hpp\"\n";
-    out << "\n";
-    out << "std::vector<p::Terminal> tokens;\n";
+    out << "#if __has_include(<sys/mman.h>)\n";
+    out << "#include <fcntl.h>\n";
+    out << "#include <sys/mman.h>\n";
+    out << "#include <sys/stat.h>\n";
+    out << "#include <unistd.h>\n";
+    out << "#endif\n";
     out << "\n";
-    out << "extern FILE *yyin;\n";
-    out << "extern \"C\" int yylex();\n";
-    out << "\n";
-    out << "std::vector<p::Terminal> Lex(const char *filename) {\n";
-    out << "    tokens.clear();\n";
-    out << "    FILE *file = fopen(filename, \"r\");\n";
-    out << "    if (!file) {\n";
-    out << "        std::cerr << \"Error: cannot open file `\" << filename << "
-           "\"`\" << std::endl;\n";
-    out << "        exit(1);\n";
-    out << "    }\n";
-    out << "    yyin = file;\n";
-    out << "    yylex();\n";
-    out << "    return tokens;\n";
-    out << "}\n";
-    out << "%}\n";
+    if (!scanner.run_sets.empty() || validate_utf8_) {
+        out << "#if defined(__SSE2__) || defined(__x86_64__)\n";
+        out << "#include <immintrin.h>\n";
+        out << "#endif\n";
+        out << "\n";
+    }
+    out << "#include \"LexerFwd.hpp\"\n";
     out << "\n";
-    out << "%%\n";
+    out << "namespace {\n";
+    EmitTables(out, scanner);
+    if (!scanner.run_sets.empty()) {
+        EmitRunScanners(out, scanner);
+    }
+    if (!scanner.keywords.empty()) {
+        EmitKeywordTable(out, scanner);
+    }
+    if (validate_utf8_) {
+        EmitUtf8Validator(out);
+    }
+    out << "}  // namespace\n";
     out << "\n";
+    out << "namespace " << namespace_ << " {\n";
+    EmitLexer(out, scanner);
+    EmitRelex(out);
+    if (add_parallel_driver_) {
+        EmitParallelDriver(out);
+    }
+    EmitMappedFile(out);
+    out << "}  // namespace " << namespace_ << "\n";
+    out.close();
+
+    out = std::ofstream(folder_ + "/LexerFwd.hpp");
+    EmitHeader(out);
+}
+
+LexerGenerator::Scanner LexerGenerator::BuildScanner() const {
+    // rule priority follows declaration kinds: quote terminals first, then
+    // regex terminals, then ignored input; -1 marks ignored input
+    std::vector<LexerRule> literals;
+    std::vector<int64_t> literal_actions;
     for (const Token &token : g_.tokens_) {
-        // if (IsTerminal(token)) {
         if (IsNonTerminal(token)) {
             continue;
         }
@@ -58,21 +107,15 @@ void LexerGenerator::Generate() {
             continue;
         }
         if (t.IsQuote()) {
-            out << "\"";
-            for (const char &c : t.name_) {
-                // user may pass something like '\n' as a token. this should
-                // be taken exactly as if it was embraced in double quotes
-                // without modifying (so '\n' is considered a newline, not a
-                // sequence of backslash and `n`)
-                if (c == '"') {
-                    out << "\\";
-                }
-                out << c;
-            }
-            out << "\"" << "\t"
-                << "{ tokens.push_back(p::Terminal{yytext}); }\n";
+            // user may pass something like '\n' as a token. the escapes are
+            // interpreted just as in a double-quoted C string, so '\n' is
+            // considered a newline, not a sequence of backslash and `n`
+            literals.push_back(LexerRule{t.name_, true});
+            literal_actions.push_back(symbols_.GetTerminalId(t));
         }
     }
+    std::vector<LexerRule> rules;
+    std::vector<int64_t> actions;
     for (const Token &token : g_.tokens_) {
         if (IsNonTerminal(token)) {
             continue;
@@ -82,57 +125,1578 @@ void LexerGenerator::Generate() {
             continue;
         }
         if (t.IsRegex() && t.repr_ != " ") {
-            out << t.repr_ << "\t"
-                << "{ tokens.push_back(p::Terminal{\"" << t.name_ << "\", "
-                << "yytext}); }\n";
+            rules.push_back(LexerRule{t.repr_, false});
+            actions.push_back(symbols_.GetTerminalId(t));
         }
     }
     for (const std::string &regex : g_.ignored_) {
-        out << regex << "\t;\n";
+        rules.push_back(LexerRule{regex, false});
+        actions.push_back(-1);
+    }
+
+    // a keyword that a regex terminal (usually the identifier) matches as a
+    // whole may be left out of the DFA: it is lexed as that terminal and then
+    // recognized by a lookup in a perfect hash table. the tokens stay the
+    // same, as the keyword would have beaten any rule matching the same text.
+    // the lookup costs more per token than a transition through a table that
+    // is in the cache, so it is only done when keywords blow the table up
+    std::vector<std::string> keywords;
+    std::vector<int64_t> keyword_kinds;
+    std::vector<int64_t> keyword_lexed_as;
+    std::vector<LexerRule> kept;
+    std::vector<int64_t> kept_actions;
+    std::set<uint64_t> keyword_hashes;
+    std::optional<LexerDFA> dfa;
+    try {
+        LexerDFA words(rules);
+        for (size_t i = 0; i < literals.size(); ++i) {
+            std::optional<std::string> text =
+                RegexParser(literals[i].pattern_, true).GetLiteralString();
+            if (text && !text->empty()) {
+                if (std::find(keywords.begin(), keywords.end(), *text) !=
+                    keywords.end()) {
+                    // spelled differently, but always shadowed by the earlier
+                    // keyword
+                    continue;
+                }
+                auto [length, rule] = words.Match(*text);
+                if (length == text->size() && rule != -1 &&
+                    actions[rule] != -1 &&
+                    keyword_hashes.insert(KeywordTable::Hash(*text)).second) {
+                    keywords.push_back(*text);
+                    keyword_kinds.push_back(literal_actions[i]);
+                    keyword_lexed_as.push_back(actions[rule]);
+                    continue;
+                }
+            }
+            kept.push_back(literals[i]);
+            kept_actions.push_back(literal_actions[i]);
+        }
+        std::vector<LexerRule> all_rules = literals;
+        all_rules.insert(all_rules.end(), rules.begin(), rules.end());
+        dfa.emplace(all_rules);
+        if (keywords.empty() || GetTableSize(*dfa) <= kMaxKeywordTableSize) {
+            keywords.clear();
+            keyword_kinds.clear();
+            keyword_lexed_as.clear();
+            kept = literals;
+            kept_actions = literal_actions;
+        } else {
+            std::vector<LexerRule> reduced = kept;
+            reduced.insert(reduced.end(), rules.begin(), rules.end());
+            dfa.emplace(reduced);
+        }
+        rules.insert(rules.begin(), kept.begin(), kept.end());
+        actions.insert(actions.begin(), kept_actions.begin(), kept_actions.end());
+    } catch (const RegexError &e) {
+        throw LexerGeneratorError(e.what());
     }
 
+    size_t state_count = dfa->GetStateCount();
+
+    // states that loop on a few ranges of bytes (or on all bytes but a few
+    // ranges), like string bodies, whitespace and digits, consume runs of
+    // such bytes in bulk
+    std::vector<std::string> run_sets;
+    std::map<std::string, size_t> run_ids;
+    std::vector<size_t> state_runs(state_count, SIZE_MAX);
+    for (size_t state = 0; state < state_count; ++state) {
+        if (state == LexerDFA::kDeadState) {
+            continue;
+        }
+        CharSet loop = dfa->GetLoopBytes(state);
+        if (loop.none()) {
+            continue;
+        }
+        std::vector<std::pair<size_t, size_t>> ranges = ToRanges(loop);
+        std::vector<std::pair<size_t, size_t>> excluded = ToRanges(~loop);
+        bool negate = excluded.size() < ranges.size();
+        if (negate) {
+            ranges = excluded;
+        }
+        if (ranges.size() > kMaxRunRanges) {
+            continue;
+        }
+        std::string lo;
+        std::string hi;
+        for (size_t k = 0; k < kMaxRunRanges; ++k) {
+            lo += (k == 0 ? "" : ", ") +
+                  std::to_string(k < ranges.size() ? ranges[k].first : 0);
+            hi += (k == 0 ? "" : ", ") +
+                  std::to_string(k < ranges.size() ? ranges[k].second : 0);
+        }
+        std::string set = "{" + std::to_string(ranges.size()) + ", " +
+                          (negate ? "true" : "false") + ", {" + lo + "}, {" +
+                          hi + "}}";
+        auto [it, inserted] = run_ids.try_emplace(set, run_sets.size());
+        if (inserted) {
+            run_sets.push_back(set);
+        }
+        state_runs[state] = it->second;
+    }
+    return Scanner{
+        std::move(*dfa), std::move(actions), std::move(keywords),
+        std::move(keyword_kinds), std::move(keyword_lexed_as), std::move(run_sets),
+        std::move(state_runs)
+    };
+}
+
+void LexerGenerator::EmitTables(std::ostream &out, const Scanner &scanner) {
+    size_t state_count = scanner.dfa.GetStateCount();
+    std::vector<uint64_t> classes;
+    for (size_t b = 0; b < 256; ++b) {
+        classes.push_back(scanner.dfa.GetClass(static_cast<unsigned char>(b)));
+    }
+    std::string state_type = FitIntegerType(state_count - 1);
+    out << "constexpr size_t kStart = " << scanner.dfa.GetStart() << ";\n";
+    out << "constexpr size_t kDead = " << LexerDFA::kDeadState << ";\n";
+    out << "constexpr int32_t kNoMatch = -1;\n";
+    out << "constexpr int32_t kSkip = -2;\n";
     out << "\n";
-    out << "%%\n";
-    out.close();
+    out << "// Bytes no state tells apart share an equivalence class.\n";
+    out << "constexpr " << FitIntegerType(scanner.dfa.GetClassCount() - 1)
+        << " kByteClasses[256] = {\n";
+    out << "    ";
+    WriteIntegers(out, classes, 4);
+    out << "\n";
+    out << "};\n";
+    out << "\n";
+    out << "// Indexed by state and byte class.\n";
+    out << "constexpr " << state_type << " kTransitions[" << state_count
+        << "][" << scanner.dfa.GetClassCount() << "] = {\n";
+    for (size_t state = 0; state < state_count; ++state) {
+        std::vector<uint64_t> row;
+        for (size_t cls = 0; cls < scanner.dfa.GetClassCount(); ++cls) {
+            row.push_back(scanner.dfa.GetTransition(state, cls));
+        }
+        out << "    {";
+        WriteIntegers(out, row, 5);
+        out << "},\n";
+    }
+    out << "};\n";
+    out << "\n";
+    out << "// The terminal kind of a token that ends in a state, kSkip for ignored\n";
+    out << "// input or kNoMatch.\n";
+    out << "constexpr int32_t kAccept[" << state_count << "] = {\n";
+    for (size_t state = 0; state < state_count; ++state) {
+        int rule = scanner.dfa.GetAccept(state);
+        out << "    ";
+        if (rule == -1) {
+            out << "kNoMatch";
+        } else if (scanner.actions[rule] == -1) {
+            out << "kSkip";
+        } else {
+            out << scanner.actions[rule];
+        }
+        out << ",\n";
+    }
+    out << "};\n";
+}
 
-    std::string build_lexer_command = "flex --outfile=" + folder_ +
-                                      "/Lexer.cpp " + folder_ +
-                                      "/Lexer.l > /dev/null 2>&1";
-    int result = std::system(build_lexer_command.c_str());
-    if (result != 0) {
-        throw LexerGeneratorError(
-            "Failed to build lexer. Check whether `flex` is installed and "
-            "available in PATH."
-        );
-    }
-    std::filesystem::remove(folder_ + "/Lexer.l");
-    out = std::ofstream(folder_ + "/LexerFwd.hpp");
+void LexerGenerator::EmitRunScanners(
+    std::ostream &out, const Scanner &scanner
+) {
+    out << "\n";
+    out << "// A set of bytes given by up to three inclusive ranges, or the complement of\n";
+    out << "// such a set.\n";
+    out << "struct ByteRanges {\n";
+    out << "    uint8_t count;\n";
+    out << "    bool negate;\n";
+    out << "    uint8_t lo[3];\n";
+    out << "    uint8_t hi[3];\n";
+    out << "};\n";
+    out << "\n";
+    out << "bool InRanges(const ByteRanges &set, unsigned char c) {\n";
+    out << "    bool in = false;\n";
+    out << "    for (size_t k = 0; k < set.count; ++k) {\n";
+    out << "        in |= static_cast<uint8_t>(c - set.lo[k]) <=\n";
+    out << "              static_cast<uint8_t>(set.hi[k] - set.lo[k]);\n";
+    out << "    }\n";
+    out << "    return in != set.negate;\n";
+    out << "}\n";
+    out << "\n";
+    out << "// Each Scan* function returns the length of the longest prefix of\n";
+    out << "// [data, data + size) that consists of bytes of `set`.\n";
+    out << "size_t ScanScalar(const ByteRanges &set, const char *data, size_t size) {\n";
+    out << "    size_t i = 0;\n";
+    out << "    while (i < size && InRanges(set, static_cast<unsigned char>(data[i]))) {\n";
+    out << "        ++i;\n";
+    out << "    }\n";
+    out << "    return i;\n";
+    out << "}\n";
+    out << "\n";
+    out << "#if defined(__SSE2__)\n";
+    out << "size_t ScanSse2(const ByteRanges &set, const char *data, size_t size) {\n";
+    out << "    __m128i lo[3];\n";
+    out << "    __m128i span[3];\n";
+    out << "    for (size_t k = 0; k < set.count; ++k) {\n";
+    out << "        lo[k] = _mm_set1_epi8(static_cast<char>(set.lo[k]));\n";
+    out << "        span[k] = _mm_set1_epi8(static_cast<char>(set.hi[k] - set.lo[k]));\n";
+    out << "    }\n";
+    out << "    size_t i = 0;\n";
+    out << "    for (; i + 16 <= size; i += 16) {\n";
+    out << "        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));\n";
+    out << "        __m128i in = _mm_setzero_si128();\n";
+    out << "        for (size_t k = 0; k < set.count; ++k) {\n";
+    out << "            // c is in [lo, hi] iff min(c - lo, hi - lo) == c - lo, unsigned\n";
+    out << "            __m128i shifted = _mm_sub_epi8(v, lo[k]);\n";
+    out << "            in = _mm_or_si128(\n";
+    out << "                in, _mm_cmpeq_epi8(_mm_min_epu8(shifted, span[k]), shifted)\n";
+    out << "            );\n";
+    out << "        }\n";
+    out << "        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(in));\n";
+    out << "        uint32_t outside = set.negate ? mask : ~mask & 0xFFFF;\n";
+    out << "        if (outside != 0) {\n";
+    out << "            return i + std::countr_zero(outside);\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "    return i + ScanScalar(set, data + i, size - i);\n";
+    out << "}\n";
+    out << "#endif\n";
+    out << "\n";
+    out << "#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))\n";
+    out << "__attribute__((target(\"avx2\"))) size_t ScanAvx2(\n";
+    out << "    const ByteRanges &set, const char *data, size_t size\n";
+    out << ") {\n";
+    out << "    __m256i lo[3];\n";
+    out << "    __m256i span[3];\n";
+    out << "    for (size_t k = 0; k < set.count; ++k) {\n";
+    out << "        lo[k] = _mm256_set1_epi8(static_cast<char>(set.lo[k]));\n";
+    out << "        span[k] = _mm256_set1_epi8(static_cast<char>(set.hi[k] - set.lo[k]));\n";
+    out << "    }\n";
+    out << "    size_t i = 0;\n";
+    out << "    for (; i + 32 <= size; i += 32) {\n";
+    out << "        __m256i v =\n";
+    out << "            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));\n";
+    out << "        __m256i in = _mm256_setzero_si256();\n";
+    out << "        for (size_t k = 0; k < set.count; ++k) {\n";
+    out << "            __m256i shifted = _mm256_sub_epi8(v, lo[k]);\n";
+    out << "            in = _mm256_or_si256(\n";
+    out << "                in,\n";
+    out << "                _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, span[k]), shifted)\n";
+    out << "            );\n";
+    out << "        }\n";
+    out << "        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(in));\n";
+    out << "        uint32_t outside = set.negate ? mask : ~mask;\n";
+    out << "        if (outside != 0) {\n";
+    out << "            return i + std::countr_zero(outside);\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "    return i + ScanSse2(set, data + i, size - i);\n";
+    out << "}\n";
+    out << "#endif\n";
+    out << "\n";
+    out << "using ScanFunction = size_t (*)(const ByteRanges &, const char *, size_t);\n";
+    out << "\n";
+    out << "ScanFunction SelectScan() {\n";
+    out << "#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))\n";
+    out << "    if (__builtin_cpu_supports(\"avx2\")) {\n";
+    out << "        return ScanAvx2;\n";
+    out << "    }\n";
+    out << "#endif\n";
+    out << "#if defined(__SSE2__)\n";
+    out << "    return ScanSse2;\n";
+    out << "#else\n";
+    out << "    return ScanScalar;\n";
+    out << "#endif\n";
+    out << "}\n";
+    out << "\n";
+    out << "// The bytes each state with a fast path loops on.\n";
+    out << "constexpr ByteRanges kRunSets[" << scanner.run_sets.size() << "] = {\n";
+    for (const std::string &set : scanner.run_sets) {
+        out << "    " << set << ",\n";
+    }
+    out << "};\n";
+    out << "\n";
+    out << "// Indexed by state: an index into kRunSets or kNoRun.\n";
+    out << "constexpr " << FitIntegerType(scanner.run_sets.size())
+        << " kNoRun = " << scanner.run_sets.size() << ";\n";
+    std::vector<uint64_t> runs;
+    for (size_t run : scanner.state_runs) {
+        runs.push_back(run == SIZE_MAX ? scanner.run_sets.size() : run);
+    }
+    out << "constexpr " << FitIntegerType(scanner.run_sets.size()) << " kRuns["
+        << scanner.state_runs.size() << "] = {\n";
+    out << "    ";
+    WriteIntegers(out, runs, 4);
+    out << "\n";
+    out << "};\n";
+}
+
+void LexerGenerator::EmitKeywordTable(
+    std::ostream &out, const Scanner &scanner
+) const {
+    KeywordTable keyword_table(scanner.keywords);
+    size_t min_length = SIZE_MAX;
+    size_t max_length = 0;
+    std::vector<bool> carries(symbols_.GetTerminals().size(), false);
+    for (size_t i = 0; i < scanner.keywords.size(); ++i) {
+        min_length = std::min(min_length, scanner.keywords[i].size());
+        max_length = std::max(max_length, scanner.keywords[i].size());
+        carries[scanner.keyword_lexed_as[i]] = true;
+    }
+    size_t bucket_count = keyword_table.GetBucketCount();
+    size_t slot_count = keyword_table.GetSlotCount();
+    out << "\n";
+    out << "// Keywords that another terminal matches as a whole are lexed as that\n";
+    out << "// terminal (`lexed_as`) and told apart by a lookup in a perfect hash\n";
+    out << "// table: the hash of a word picks a bucket, and the displacement of the\n";
+    out << "// bucket picks the only slot the word may be in.\n";
+    out << "struct Keyword {\n";
+    out << "    std::string_view text;\n";
+    out << "    uint64_t hash;\n";
+    out << "    uint32_t kind;\n";
+    out << "    uint32_t lexed_as;\n";
+    out << "};\n";
+    out << "\n";
+    out << "constexpr size_t kMinKeywordLength = " << min_length << ";\n";
+    out << "constexpr size_t kMaxKeywordLength = " << max_length << ";\n";
+    out << "constexpr uint64_t kKeywordBucketMask = " << bucket_count - 1
+        << ";\n";
+    out << "constexpr uint64_t kKeywordSlotMask = " << slot_count - 1
+        << ";\n";
+    out << "\n";
+    out << "// Indexed by terminal kind: whether a keyword may be lexed as it.\n";
+    out << "constexpr bool kCarriesKeywords[" << carries.size() << "] = {\n";
+    out << "    ";
+    WriteIntegers(out, std::vector<uint64_t>(carries.begin(), carries.end()), 4);
+    out << "\n";
+    out << "};\n";
+    out << "\n";
+    out << "constexpr uint32_t kKeywordDisplacements[" << bucket_count
+        << "] = {\n";
+    out << "    ";
+    WriteIntegers(
+        out,
+        std::vector<uint64_t>(
+            keyword_table.GetDisplacements().begin(),
+            keyword_table.GetDisplacements().end()
+        ),
+        4
+    );
+    out << "\n";
+    out << "};\n";
+    out << "\n";
+    out << "// Empty slots are lexed as the end of input, which no lexeme is.\n";
+    out << "constexpr Keyword kKeywords[" << slot_count << "] = {\n";
+    for (int index : keyword_table.GetSlots()) {
+        if (index == KeywordTable::kEmptySlot) {
+            out << "    {\"\", 0, 0, 0},\n";
+        } else {
+            out << "    {\"" << EscapeString(scanner.keywords[index]) << "\", "
+                << KeywordTable::Hash(scanner.keywords[index]) << "u, "
+                << scanner.keyword_kinds[index] << ", " << scanner.keyword_lexed_as[index]
+                << "},\n";
+        }
+    }
+    out << "};\n";
+    out << "\n";
+    out << "// Must hash exactly like KeywordTable of the generator: 8-byte little-endian\n";
+    out << "// chunks, then the finalizer of splitmix64. `limit` is the end of the\n";
+    out << "// input, so a chunk may be loaded at once when 8 bytes are readable.\n";
+    out << "uint32_t Reclassify(uint32_t kind, std::string_view lexeme, const char *limit) {\n";
+    out << "    size_t size = lexeme.size();\n";
+    out << "    if (size - kMinKeywordLength > kMaxKeywordLength - kMinKeywordLength) {\n";
+    out << "        return kind;\n";
+    out << "    }\n";
+    out << "    uint64_t hash = size;\n";
+    out << "    for (size_t i = 0; i < size; i += 8) {\n";
+    out << "        const char *data = lexeme.data() + i;\n";
+    out << "        size_t count = std::min<size_t>(size - i, 8);\n";
+    out << "        uint64_t chunk = 0;\n";
+    out << "        if (std::endian::native == std::endian::little && limit - data >= 8) {\n";
+    out << "            std::memcpy(&chunk, data, 8);\n";
+    out << "            if (count < 8) {\n";
+    out << "                chunk &= (uint64_t{1} << (8 * count)) - 1;\n";
+    out << "            }\n";
+    out << "        } else {\n";
+    out << "            for (size_t k = 0; k < count; ++k) {\n";
+    out << "                chunk |= static_cast<uint64_t>(static_cast<unsigned char>(data[k]))\n";
+    out << "                         << (8 * k);\n";
+    out << "            }\n";
+    out << "        }\n";
+    out << "        hash = (hash ^ chunk) * 0x9e3779b97f4a7c15;\n";
+    out << "        hash ^= hash >> 32;\n";
+    out << "    }\n";
+    out << "    uint64_t x = hash ^ kKeywordDisplacements[(hash >> 32) & kKeywordBucketMask];\n";
+    out << "    x ^= x >> 30;\n";
+    out << "    x *= 0xbf58476d1ce4e5b9;\n";
+    out << "    x ^= x >> 27;\n";
+    out << "    x *= 0x94d049bb133111eb;\n";
+    out << "    x ^= x >> 31;\n";
+    out << "    const Keyword &keyword = kKeywords[x & kKeywordSlotMask];\n";
+    out << "    // a single chunk hashes to a bijection of its bytes, so up to 8 bytes\n";
+    out << "    // equal hashes and sizes mean equal words\n";
+    out << "    if (keyword.hash == hash && keyword.lexed_as == kind &&\n";
+    out << "        keyword.text.size() == size && (size <= 8 || keyword.text == lexeme)) {\n";
+    out << "        return keyword.kind;\n";
+    out << "    }\n";
+    out << "    return kind;\n";
+    out << "}\n";
+}
+
+void LexerGenerator::EmitUtf8Validator(std::ostream &out) {
+    out << "\n";
+    out << "// The length of the valid UTF-8 encoded character at `data[i]`, or 0 if the\n";
+    out << "// bytes there are malformed or cut off.\n";
+    out << "size_t Utf8Length(const unsigned char *data, size_t size, size_t i) {\n";
+    out << "    unsigned char c = data[i];\n";
+    out << "    if (c < 0x80) {\n";
+    out << "        return 1;\n";
+    out << "    }\n";
+    out << "    // the second byte is narrowed after some leads to rule out overlong forms,\n";
+    out << "    // surrogates and code points above U+10FFFF\n";
+    out << "    size_t length = 0;\n";
+    out << "    unsigned char lo = 0x80;\n";
+    out << "    unsigned char hi = 0xBF;\n";
+    out << "    if (c >= 0xC2 && c <= 0xDF) {\n";
+    out << "        length = 2;\n";
+    out << "    } else if (c >= 0xE0 && c <= 0xEF) {\n";
+    out << "        length = 3;\n";
+    out << "        lo = c == 0xE0 ? 0xA0 : 0x80;\n";
+    out << "        hi = c == 0xED ? 0x9F : 0xBF;\n";
+    out << "    } else if (c >= 0xF0 && c <= 0xF4) {\n";
+    out << "        length = 4;\n";
+    out << "        lo = c == 0xF0 ? 0x90 : 0x80;\n";
+    out << "        hi = c == 0xF4 ? 0x8F : 0xBF;\n";
+    out << "    } else {\n";
+    out << "        return 0;\n";
+    out << "    }\n";
+    out << "    if (size - i < length || data[i + 1] < lo || data[i + 1] > hi) {\n";
+    out << "        return 0;\n";
+    out << "    }\n";
+    out << "    for (size_t k = 2; k < length; ++k) {\n";
+    out << "        if ((data[i + k] & 0xC0) != 0x80) {\n";
+    out << "            return 0;\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "    return length;\n";
+    out << "}\n";
+    out << "\n";
+    out << "// Each FindInvalidUtf8* function returns the offset of the first malformed\n";
+    out << "// character of [data, data + size), or `size` if there is none.\n";
+    out << "size_t FindInvalidUtf8Scalar(const char *data, size_t size) {\n";
+    out << "    const auto *bytes = reinterpret_cast<const unsigned char *>(data);\n";
+    out << "    size_t i = 0;\n";
+    out << "    while (i < size) {\n";
+    out << "        size_t length = Utf8Length(bytes, size, i);\n";
+    out << "        if (length == 0) {\n";
+    out << "            return i;\n";
+    out << "        }\n";
+    out << "        i += length;\n";
+    out << "    }\n";
+    out << "    return size;\n";
+    out << "}\n";
+    out << "\n";
+    out << "#if defined(__SSE2__)\n";
+    out << "size_t FindInvalidUtf8Sse2(const char *data, size_t size) {\n";
+    out << "    const auto *bytes = reinterpret_cast<const unsigned char *>(data);\n";
+    out << "    size_t i = 0;\n";
+    out << "    while (i < size) {\n";
+    out << "        if (i + 16 <= size) {\n";
+    out << "            // SSE2 has no byte shuffle for the lookups below, so it only skips\n";
+    out << "            // ASCII in bulk and checks other characters one by one\n";
+    out << "            uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(\n";
+    out << "                _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i))\n";
+    out << "            ));\n";
+    out << "            if (mask == 0) {\n";
+    out << "                i += 16;\n";
+    out << "                continue;\n";
+    out << "            }\n";
+    out << "            i += std::countr_zero(mask);\n";
+    out << "        }\n";
+    out << "        size_t length = Utf8Length(bytes, size, i);\n";
+    out << "        if (length == 0) {\n";
+    out << "            return i;\n";
+    out << "        }\n";
+    out << "        i += length;\n";
+    out << "    }\n";
+    out << "    return size;\n";
+    out << "}\n";
+    out << "#endif\n";
+    out << "\n";
+    out << "#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))\n";
+    out << "// The lookup algorithm of Keiser and Lemire classifies every pair of adjacent\n";
+    out << "// bytes by three table lookups, on the high and the low nibble of the first\n";
+    out << "// byte and on the high nibble of the second. Each bit stands for a kind of\n";
+    out << "// malformed pair and survives the AND of the three lookups only if the pair is\n";
+    out << "// of that kind.\n";
+    out << "constexpr uint8_t kTooShort = 1 << 0;       // a lead not followed by a continuation\n";
+    out << "constexpr uint8_t kTooLong = 1 << 1;        // ASCII followed by a continuation\n";
+    out << "constexpr uint8_t kOverlong3 = 1 << 2;      // E0 followed by 80..9F\n";
+    out << "constexpr uint8_t kTooLarge = 1 << 3;       // F4..FF followed by 90..BF\n";
+    out << "constexpr uint8_t kSurrogate = 1 << 4;      // ED followed by A0..BF\n";
+    out << "constexpr uint8_t kOverlong2 = 1 << 5;      // C0 or C1 followed by a continuation\n";
+    out << "constexpr uint8_t kTooLarge1000 = 1 << 6;   // F5..FF followed by 80..8F\n";
+    out << "constexpr uint8_t kOverlong4 = 1 << 6;      // F0 followed by 80..8F\n";
+    out << "constexpr uint8_t kTwoContinuations = 1 << 7;\n";
+    out << "constexpr uint8_t kCarry = kTooShort | kTooLong | kTwoContinuations;\n";
+    out << "\n";
+    out << "alignas(16) constexpr uint8_t kFirstHigh[16] = {\n";
+    out << "    kTooLong, kTooLong, kTooLong, kTooLong,\n";
+    out << "    kTooLong, kTooLong, kTooLong, kTooLong,\n";
+    out << "    kTwoContinuations, kTwoContinuations, kTwoContinuations, kTwoContinuations,\n";
+    out << "    kTooShort | kOverlong2,\n";
+    out << "    kTooShort,\n";
+    out << "    kTooShort | kOverlong3 | kSurrogate,\n";
+    out << "    kTooShort | kTooLarge | kTooLarge1000 | kOverlong4,\n";
+    out << "};\n";
+    out << "alignas(16) constexpr uint8_t kFirstLow[16] = {\n";
+    out << "    kCarry | kOverlong3 | kOverlong2 | kOverlong4,\n";
+    out << "    kCarry | kOverlong2,\n";
+    out << "    kCarry,\n";
+    out << "    kCarry,\n";
+    out << "    kCarry | kTooLarge,\n";
+    out << "    kCarry | kTooLarge | kTooLarge1000,\n";
+    out << "    kCarry | kTooLarge | kTooLarge1000,\n";
+    out << "    kCarry | kTooLarge | kTooLarge1000,\n";
+    out << "    kCarry | kTooLarge | kTooLarge1000,\n";
+    out << "    kCarry | kTooLarge | kTooLarge1000,\n";
+    out << "    kCarry | kTooLarge | kTooLarge1000,\n";
+    out << "    kCarry | kTooLarge | kTooLarge1000,\n";
+    out << "    kCarry | kTooLarge | kTooLarge1000,\n";
+    out << "    kCarry | kTooLarge | kTooLarge1000 | kSurrogate,\n";
+    out << "    kCarry | kTooLarge | kTooLarge1000,\n";
+    out << "    kCarry | kTooLarge | kTooLarge1000,\n";
+    out << "};\n";
+    out << "alignas(16) constexpr uint8_t kSecondHigh[16] = {\n";
+    out << "    kTooShort, kTooShort, kTooShort, kTooShort,\n";
+    out << "    kTooShort, kTooShort, kTooShort, kTooShort,\n";
+    out << "    kTooLong | kOverlong2 | kTwoContinuations | kOverlong3 | kTooLarge1000 | kOverlong4,\n";
+    out << "    kTooLong | kOverlong2 | kTwoContinuations | kOverlong3 | kTooLarge,\n";
+    out << "    kTooLong | kOverlong2 | kTwoContinuations | kSurrogate | kTooLarge,\n";
+    out << "    kTooLong | kOverlong2 | kTwoContinuations | kSurrogate | kTooLarge,\n";
+    out << "    kTooShort, kTooShort, kTooShort, kTooShort,\n";
+    out << "};\n";
+    out << "\n";
+    out << "__attribute__((target(\"avx2\"))) __m256i LoadLookup(const uint8_t (&table)[16]) {\n";
+    out << "    return _mm256_broadcastsi128_si256(\n";
+    out << "        _mm_load_si128(reinterpret_cast<const __m128i *>(table))\n";
+    out << "    );\n";
+    out << "}\n";
+    out << "\n";
+    out << "__attribute__((target(\"avx2\"))) size_t FindInvalidUtf8Avx2(\n";
+    out << "    const char *data, size_t size\n";
+    out << ") {\n";
+    out << "    const __m256i first_high = LoadLookup(kFirstHigh);\n";
+    out << "    const __m256i first_low = LoadLookup(kFirstLow);\n";
+    out << "    const __m256i second_high = LoadLookup(kSecondHigh);\n";
+    out << "    const __m256i nibble = _mm256_set1_epi8(0x0F);\n";
+    out << "    const __m256i top_bit = _mm256_set1_epi8(static_cast<char>(0x80));\n";
+    out << "    // the largest byte that does not start a character cut off by the end of\n";
+    out << "    // the block, at each position of the block\n";
+    out << "    const __m256i max_complete = _mm256_setr_epi8(\n";
+    out << "        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,\n";
+    out << "        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,\n";
+    out << "        static_cast<char>(0xEF), static_cast<char>(0xDF), static_cast<char>(0xBF)\n";
+    out << "    );\n";
+    out << "    __m256i previous = _mm256_setzero_si256();\n";
+    out << "    __m256i incomplete = _mm256_setzero_si256();\n";
+    out << "    size_t i = 0;\n";
+    out << "    for (; i + 32 <= size; i += 32) {\n";
+    out << "        __m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));\n";
+    out << "        // ASCII cannot finish a character the previous block cut off\n";
+    out << "        __m256i error = incomplete;\n";
+    out << "        if (_mm256_movemask_epi8(input) != 0) {\n";
+    out << "            // the bytes one, two and three positions back\n";
+    out << "            __m256i carried = _mm256_permute2x128_si256(previous, input, 0x21);\n";
+    out << "            __m256i back1 = _mm256_alignr_epi8(input, carried, 15);\n";
+    out << "            __m256i back2 = _mm256_alignr_epi8(input, carried, 14);\n";
+    out << "            __m256i back3 = _mm256_alignr_epi8(input, carried, 13);\n";
+    out << "            __m256i pairs = _mm256_and_si256(\n";
+    out << "                _mm256_and_si256(\n";
+    out << "                    _mm256_shuffle_epi8(\n";
+    out << "                        first_high, _mm256_and_si256(_mm256_srli_epi16(back1, 4), nibble)\n";
+    out << "                    ),\n";
+    out << "                    _mm256_shuffle_epi8(first_low, _mm256_and_si256(back1, nibble))\n";
+    out << "                ),\n";
+    out << "                _mm256_shuffle_epi8(\n";
+    out << "                    second_high, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble)\n";
+    out << "                )\n";
+    out << "            );\n";
+    out << "            // a byte two after a lead of three or more bytes or three after a\n";
+    out << "            // lead of four is the only one that may follow a continuation with\n";
+    out << "            // a continuation, and it has to\n";
+    out << "            __m256i third_or_fourth = _mm256_and_si256(\n";
+    out << "                _mm256_or_si256(\n";
+    out << "                    _mm256_subs_epu8(back2, _mm256_set1_epi8(0xE0 - 0x80)),\n";
+    out << "                    _mm256_subs_epu8(back3, _mm256_set1_epi8(0xF0 - 0x80))\n";
+    out << "                ),\n";
+    out << "                top_bit\n";
+    out << "            );\n";
+    out << "            error = _mm256_xor_si256(third_or_fourth, pairs);\n";
+    out << "        }\n";
+    out << "        if (!_mm256_testz_si256(error, error)) {\n";
+    out << "            break;\n";
+    out << "        }\n";
+    out << "        previous = input;\n";
+    out << "        incomplete = _mm256_subs_epu8(input, max_complete);\n";
+    out << "    }\n";
+    out << "    // the rest of the input, or the block with an error to find its offset, is\n";
+    out << "    // checked from the start of the character the checked input ends in\n";
+    out << "    size_t start = i;\n";
+    out << "    if (start > 0) {\n";
+    out << "        --start;\n";
+    out << "        while (start + 3 >= i && start > 0 &&\n";
+    out << "               (static_cast<unsigned char>(data[start]) & 0xC0) == 0x80) {\n";
+    out << "            --start;\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "    return start + FindInvalidUtf8Scalar(data + start, size - start);\n";
+    out << "}\n";
+    out << "#endif\n";
+    out << "\n";
+    out << "using FindInvalidUtf8Function = size_t (*)(const char *, size_t);\n";
+    out << "\n";
+    out << "FindInvalidUtf8Function SelectFindInvalidUtf8() {\n";
+    out << "#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))\n";
+    out << "    if (__builtin_cpu_supports(\"avx2\")) {\n";
+    out << "        return FindInvalidUtf8Avx2;\n";
+    out << "    }\n";
+    out << "#endif\n";
+    out << "#if defined(__SSE2__)\n";
+    out << "    return FindInvalidUtf8Sse2;\n";
+    out << "#else\n";
+    out << "    return FindInvalidUtf8Scalar;\n";
+    out << "#endif\n";
+    out << "}\n";
+}
+
+void LexerGenerator::EmitLexer(
+    std::ostream &out, const Scanner &scanner
+) const {
+    if (validate_utf8_) {
+        out << "size_t FindInvalidUtf8(std::string_view source) {\n";
+        out << "    static const FindInvalidUtf8Function find = SelectFindInvalidUtf8();\n";
+        out << "    size_t offset = find(source.data(), source.size());\n";
+        out << "    return offset == source.size() ? std::string_view::npos : offset;\n";
+        out << "}\n";
+        out << "\n";
+        out << "namespace {\n";
+        out << "void ValidateUtf8(std::string_view source, size_t begin, size_t end) {\n";
+        out << "    size_t offset = FindInvalidUtf8(source.substr(begin, end - begin));\n";
+        out << "    if (offset != std::string_view::npos) {\n";
+        out << "        Position position = LineIndex(source).Locate(begin + offset);\n";
+        out << "        throw LexerError(\n";
+        out << "            \"Invalid UTF-8 at \" + std::to_string(position.line) + \":\" +\n";
+        out << "            std::to_string(position.column)\n";
+        out << "        );\n";
+        out << "    }\n";
+        out << "}\n";
+        out << "\n";
+        out << "void ValidateUtf8(std::string_view source) {\n";
+        out << "    ValidateUtf8(source, 0, source.size());\n";
+        out << "}\n";
+        out << "}  // namespace\n";
+        out << "\n";
+        out << "Lexer::Lexer(std::string_view source, bool validate) {\n";
+        out << "    Reset(source, validate);\n";
+        out << "}\n";
+        out << "\n";
+        out << "void Lexer::Reset(std::string_view source, bool validate) {\n";
+        out << "    if (validate) {\n";
+        out << "        ValidateUtf8(source);\n";
+        out << "    }\n";
+        out << "    source_ = source;\n";
+        out << "    pos_ = 0;\n";
+        out << "}\n";
+    } else {
+        out << "Lexer::Lexer(std::string_view source) : source_(source) {\n";
+        out << "}\n";
+        out << "\n";
+        out << "void Lexer::Reset(std::string_view source) {\n";
+        out << "    source_ = source;\n";
+        out << "    pos_ = 0;\n";
+        out << "}\n";
+    }
+    out << "\n";
+    out << "namespace {\n";
+    out << "// What `ScanToken` found.\n";
+    out << "enum class Scanned {\n";
+    out << "    kToken,\n";
+    out << "    kEnd,\n";
+    out << "    kNoMatch\n";
+    out << "};\n";
+    out << "\n";
+    out << "// Lexes the token at `pos` of `source`, skipping ignored input before it, and\n";
+    out << "// moves `pos` past it. At a byte no rule matches, `pos` is left on that byte.\n";
+    out << "Scanned ScanToken(std::string_view source, size_t &pos, Terminal &token) {\n";
+    if (!scanner.run_sets.empty()) {
+        out << "    static const ScanFunction scan = SelectScan();\n";
+    }
+    out << "    while (pos < source.size()) {\n";
+    out << "        // longest match: run the DFA until it dies and take the last\n";
+    out << "        // accepting state it went through\n";
+    out << "        size_t state = kStart;\n";
+    out << "        int32_t action = kNoMatch;\n";
+    out << "        size_t end = pos;\n";
+    out << "        size_t i = pos;\n";
+    out << "        while (i < source.size()) {\n";
+    out << "            unsigned char c = static_cast<unsigned char>(source[i]);\n";
+    out << "            state = kTransitions[state][kByteClasses[c]];\n";
+    out << "            if (state == kDead) {\n";
+    out << "                break;\n";
+    out << "            }\n";
+    out << "            ++i;\n";
+    if (!scanner.run_sets.empty()) {
+        out << "            if (kRuns[state] != kNoRun) {\n";
+        out << "                // bytes that keep the DFA in this state are consumed in bulk\n";
+        out << "                i += scan(\n";
+        out << "                    kRunSets[kRuns[state]], source.data() + i, source.size() - i\n";
+        out << "                );\n";
+        out << "            }\n";
+    }
+    out << "            if (kAccept[state] != kNoMatch) {\n";
+    out << "                action = kAccept[state];\n";
+    out << "                end = i;\n";
+    out << "            }\n";
+    out << "        }\n";
+    out << "        if (action == kNoMatch) {\n";
+    out << "            return Scanned::kNoMatch;\n";
+    out << "        }\n";
+    out << "        size_t start = pos;\n";
+    out << "        pos = end;\n";
+    out << "        if (action != kSkip) {\n";
+    out << "            uint32_t kind = static_cast<uint32_t>(action);\n";
+    out << "            std::string_view lexeme = source.substr(start, end - start);\n";
+    if (!scanner.keywords.empty()) {
+        out << "            if (kCarriesKeywords[kind]) {\n";
+        out << "                kind = Reclassify(kind, lexeme, source.data() + source.size());\n";
+        out << "            }\n";
+    }
+    out << "            token = Terminal{kind, lexeme};\n";
+    out << "            return Scanned::kToken;\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "    return Scanned::kEnd;\n";
+    out << "}\n";
+    out << "\n";
+    out << "[[noreturn]] void ThrowNoMatch(std::string_view source, size_t pos) {\n";
+    out << "    Position position = LineIndex(source).Locate(pos);\n";
+    out << "    throw LexerError(\n";
+    out << "        \"No token matches the input at \" + std::to_string(position.line) + \":\" +\n";
+    out << "        std::to_string(position.column)\n";
+    out << "    );\n";
+    out << "}\n";
+    out << "\n";
+    out << "// `Lexer::Next` on `source` from `pos`.\n";
+    out << "bool NextToken(std::string_view source, size_t &pos, Terminal &token) {\n";
+    out << "    Scanned scanned = ScanToken(source, pos, token);\n";
+    out << "    if (scanned == Scanned::kNoMatch) {\n";
+    out << "        ThrowNoMatch(source, pos);\n";
+    out << "    }\n";
+    out << "    return scanned == Scanned::kToken;\n";
+    out << "}\n";
+    out << "}  // namespace\n";
+    out << "\n";
+    out << "bool Lexer::Next(Terminal &token) {\n";
+    out << "    return NextToken(source_, pos_, token);\n";
+    out << "}\n";
+    out << "\n";
+    out << "void Lexer::LexTo(std::vector<Terminal> &sink) {\n";
+    out << "    Terminal token;\n";
+    out << "    while (Next(token)) {\n";
+    out << "        sink.push_back(token);\n";
+    out << "    }\n";
+    out << "}\n";
+    out << "\n";
+    out << "void Lexer::LexTo(TokenStream &sink) {\n";
+    out << "    Terminal token;\n";
+    out << "    while (Next(token)) {\n";
+    out << "        sink.push_back(token);\n";
+    out << "    }\n";
+    out << "}\n";
+    out << "std::vector<Terminal> Lex(std::string_view source) {\n";
+    out << "    std::vector<Terminal> tokens;\n";
+    out << "    Lexer(source).LexTo(tokens);\n";
+    out << "    return tokens;\n";
+    out << "}\n";
+    out << "\n";
+    out << "std::vector<Terminal> Lex(const char *data, size_t size) {\n";
+    out << "    return Lex(std::string_view(data, size));\n";
+    out << "}\n";
+    out << "\n";
+    out << "std::vector<Terminal> Lex(const MappedFile &file) {\n";
+    out << "    return Lex(file.Data());\n";
+    out << "}\n";
+    out << "\n";
+    out << "TokenStream LexPacked(std::string_view source) {\n";
+    out << "    TokenStream tokens(source);\n";
+    out << "    Lexer(source).LexTo(tokens);\n";
+    out << "    return tokens;\n";
+    out << "}\n";
+    out << "\n";
+    out << "TokenStream LexPacked(const MappedFile &file) {\n";
+    out << "    return LexPacked(file.Data());\n";
+    out << "}\n";
+}
+
+void LexerGenerator::EmitRelex(std::ostream &out) const {
+    out << "\n";
+    out << "namespace {\n";
+    out << "// The offset of the lexeme of the `i`-th token in the buffer it was lexed from.\n";
+    out << "size_t StartOf(const std::vector<Terminal> &tokens, std::string_view source, size_t i) {\n";
+    out << "    return static_cast<size_t>(tokens[i].repr.data() - source.data());\n";
+    out << "}\n";
+    out << "\n";
+    out << "size_t StartOf(const TokenStream &tokens, std::string_view, size_t i) {\n";
+    out << "    return static_cast<size_t>(tokens.GetRecord(i).Offset());\n";
+    out << "}\n";
+    out << "\n";
+    out << "// Whether a scan that is still running at `begin`, in any state, stops before\n";
+    out << "// it looks at the byte at `end`.\n";
+    out << "bool ScansStopBefore(std::string_view source, size_t begin, size_t end) {\n";
+    out << "    std::vector<size_t> states(std::size(kAccept));\n";
+    out << "    for (size_t state = 0; state < states.size(); ++state) {\n";
+    out << "        states[state] = state;\n";
+    out << "    }\n";
+    out << "    std::vector<size_t> next;\n";
+    out << "    for (size_t i = begin; i < end; ++i) {\n";
+    out << "        unsigned char c = static_cast<unsigned char>(source[i]);\n";
+    out << "        next.clear();\n";
+    out << "        for (size_t state : states) {\n";
+    out << "            size_t target = kTransitions[state][kByteClasses[c]];\n";
+    out << "            if (target != kDead) {\n";
+    out << "                next.push_back(target);\n";
+    out << "            }\n";
+    out << "        }\n";
+    out << "        std::sort(next.begin(), next.end());\n";
+    out << "        next.erase(std::unique(next.begin(), next.end()), next.end());\n";
+    out << "        states.swap(next);\n";
+    out << "        if (states.empty()) {\n";
+    out << "            return true;\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "    return false;\n";
+    out << "}\n";
+    out << "\n";
+    out << "// Lexes anew the part of `source`, which is `previous_source` with `edit`\n";
+    out << "// applied, that the edit may have changed, given `previous`, the tokens of\n";
+    out << "// `previous_source`. Appends the new tokens of that part to `inserted`, a\n";
+    out << "// `std::vector` of `Terminal` or a `TokenStream` over `source`, and returns\n";
+    out << "// which tokens of `previous` they replace.\n";
+    out << "template <class Sink>\n";
+    out << "TokenEdit RelexEdited(\n";
+    out << "    const Sink &previous, std::string_view previous_source, std::string_view source,\n";
+    out << "    const TextEdit &edit, Sink &inserted\n";
+    out << ") {\n";
+    out << "    size_t count = previous.size();\n";
+    out << "    auto start_of = [&](size_t i) {\n";
+    out << "        return StartOf(previous, previous_source, i);\n";
+    out << "    };\n";
+    out << "    auto end_of = [&](size_t i) {\n";
+    out << "        return start_of(i) + previous[i].repr.size();\n";
+    out << "    };\n";
+    out << "    // the scans for the tokens reaching the edit looked at it, and so may have\n";
+    out << "    // earlier ones whose lookahead ran on past their tokens, e.g. into an\n";
+    out << "    // unterminated string. the scan is resumed after a token once no scan that\n";
+    out << "    // started before can have got to the edit, going back further each time\n";
+    out << "    size_t first = 0;\n";
+    out << "    size_t last = count;\n";
+    out << "    while (first < last) {\n";
+    out << "        size_t middle = first + (last - first) / 2;\n";
+    out << "        if (end_of(middle) < edit.start) {\n";
+    out << "            first = middle + 1;\n";
+    out << "        } else {\n";
+    out << "            last = middle;\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "    size_t step = 1;\n";
+    out << "    while (first > 0 && !ScansStopBefore(source, end_of(first - 1), edit.start)) {\n";
+    out << "        first -= std::min(step, first);\n";
+    out << "        step *= 2;\n";
+    out << "    }\n";
+    out << "    size_t resume = first > 0 ? end_of(first - 1) : 0;\n";
+    if (validate_utf8_) {
+        out << "    // the rest of the input was valid before and did not change\n";
+        out << "    size_t checked = std::min(edit.start + edit.inserted, source.size());\n";
+        out << "    while (checked < source.size() &&\n";
+        out << "           (static_cast<unsigned char>(source[checked]) & 0xC0) == 0x80) {\n";
+        out << "        ++checked;\n";
+        out << "    }\n";
+        out << "    ValidateUtf8(source, resume, checked);\n";
+    }
+    out << "    // a token after the edit is the same bytes, moved by the size of the edit.\n";
+    out << "    // the lexer keeps no state between tokens, so once the scan starts a token\n";
+    out << "    // where one of them starts now, it goes on like the previous scan did\n";
+    out << "    size_t edit_end = edit.start + edit.removed;\n";
+    out << "    auto moved_start_of = [&](size_t i) {\n";
+    out << "        return start_of(i) - edit.removed + edit.inserted;\n";
+    out << "    };\n";
+    out << "    size_t pos = resume;\n";
+    out << "    Terminal token;\n";
+    out << "    size_t next = first;\n";
+    out << "    while (NextToken(source, pos, token)) {\n";
+    out << "        size_t start = static_cast<size_t>(token.repr.data() - source.data());\n";
+    out << "        while (next < count && (start_of(next) < edit_end || moved_start_of(next) < start)) {\n";
+    out << "            ++next;\n";
+    out << "        }\n";
+    out << "        if (next < count && moved_start_of(next) == start) {\n";
+    out << "            return TokenEdit{first, next - first, inserted.size()};\n";
+    out << "        }\n";
+    out << "        inserted.push_back(token);\n";
+    out << "    }\n";
+    out << "    return TokenEdit{first, count - first, inserted.size()};\n";
+    out << "}\n";
+    out << "}  // namespace\n";
+    out << "\n";
+    out << "TokenEdit Relex(\n";
+    out << "    std::vector<Terminal> &tokens, std::string_view previous_source,\n";
+    out << "    std::string_view source, const TextEdit &edit\n";
+    out << ") {\n";
+    out << "    std::vector<Terminal> inserted;\n";
+    out << "    TokenEdit token_edit = RelexEdited(tokens, previous_source, source, edit, inserted);\n";
+    out << "    // the other tokens are pointed to the same bytes in the new buffer\n";
+    out << "    if (source.data() != previous_source.data()) {\n";
+    out << "        for (size_t i = 0; i < token_edit.start; ++i) {\n";
+    out << "            size_t start = StartOf(tokens, previous_source, i);\n";
+    out << "            tokens[i].repr = source.substr(start, tokens[i].repr.size());\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "    for (size_t i = token_edit.start + token_edit.removed; i < tokens.size(); ++i) {\n";
+    out << "        size_t start = StartOf(tokens, previous_source, i) - edit.removed + edit.inserted;\n";
+    out << "        tokens[i].repr = source.substr(start, tokens[i].repr.size());\n";
+    out << "    }\n";
+    out << "    auto removed = tokens.begin() + token_edit.start;\n";
+    out << "    removed = tokens.erase(removed, removed + token_edit.removed);\n";
+    out << "    tokens.insert(removed, inserted.begin(), inserted.end());\n";
+    out << "    return token_edit;\n";
+    out << "}\n";
+    out << "\n";
+    out << "TokenEdit Relex(TokenStream &tokens, std::string_view source, const TextEdit &edit) {\n";
+    out << "    TokenStream inserted(source);\n";
+    out << "    TokenEdit token_edit = RelexEdited(tokens, tokens.GetSource(), source, edit, inserted);\n";
+    out << "    tokens.Replace(token_edit.start, token_edit.removed, inserted);\n";
+    out << "    return token_edit;\n";
+    out << "}\n";
+    out << "\n";
+}
+
+void LexerGenerator::EmitParallelDriver(std::ostream &out) const {
+    out << "namespace {\n";
+    out << "// Chunks smaller than this are not worth a thread.\n";
+    out << "constexpr size_t kMinChunkSize = size_t{1} << 16;\n";
+    out << "\n";
+    out << "// The tokens of `source[begin, end)` as lexed when starting right at `begin`,\n";
+    out << "// which is a guess: `begin` may be in the middle of a token.\n";
+    out << "template <class Sink>\n";
+    out << "struct Chunk {\n";
+    out << "    size_t begin = 0;\n";
+    out << "    size_t end = 0;\n";
+    out << "    Sink tokens;\n";
+    out << "    // The bytes no rule matched, which were skipped. Those before the point\n";
+    out << "    // where the guess turns out right are not errors.\n";
+    out << "    std::vector<size_t> no_match;\n";
+    out << "};\n";
+    out << "\n";
+    out << "void Append(std::vector<Terminal> &sink, const std::vector<Terminal> &tokens, size_t from) {\n";
+    out << "    sink.insert(sink.end(), tokens.begin() + from, tokens.end());\n";
+    out << "}\n";
+    out << "\n";
+    out << "void Append(TokenStream &sink, const TokenStream &tokens, size_t from) {\n";
+    out << "    sink.Append(tokens, from);\n";
+    out << "}\n";
+    out << "\n";
+    out << "size_t StartOf(std::string_view source, const Terminal &token) {\n";
+    out << "    return static_cast<size_t>(token.repr.data() - source.data());\n";
+    out << "}\n";
+    out << "\n";
+    out << "// Appends the tokens of `source` to `sink`, which is empty; a `std::vector` of\n";
+    out << "// `Terminal` or a `TokenStream` over `source`.\n";
+    out << "template <class Sink>\n";
+    out << "void LexParallelTo(std::string_view source, size_t threads, Sink &sink) {\n";
+    out << "    if (threads == 0) {\n";
+    out << "        threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);\n";
+    out << "    }\n";
+    if (validate_utf8_) {
+        out << "    // the lexers below start in the middle of the input, so it is\n";
+        out << "    // validated as a whole once\n";
+        out << "    ValidateUtf8(source);\n";
+    }
+    out << "    size_t count = std::clamp<size_t>(source.size() / kMinChunkSize, 1, threads);\n";
+    out << "    // chunks start right after a newline where there is one, since few\n";
+    out << "    // tokens span lines and lexing from there is most likely right\n";
+    out << "    std::vector<Chunk<Sink>> chunks(count, Chunk<Sink>{0, 0, sink, {}});\n";
+    out << "    size_t step = source.size() / count;\n";
+    out << "    for (size_t i = 1; i < count; ++i) {\n";
+    out << "        size_t begin = step * i;\n";
+    out << "        size_t limit = i + 1 < count ? step * (i + 1) : source.size();\n";
+    out << "        const void *newline =\n";
+    out << "            std::memchr(source.data() + begin, '\\n', limit - begin);\n";
+    out << "        if (newline) {\n";
+    out << "            begin = static_cast<const char *>(newline) - source.data() + 1;\n";
+    out << "        }\n";
+    out << "        chunks[i].begin = begin;\n";
+    out << "        chunks[i - 1].end = begin;\n";
+    out << "    }\n";
+    out << "    chunks.back().end = source.size();\n";
+    out << "\n";
+    out << "    auto lex_chunk = [&](size_t i) {\n";
+    out << "        Chunk<Sink> &chunk = chunks[i];\n";
+    out << "        size_t pos = chunk.begin;\n";
+    out << "        Terminal token;\n";
+    out << "        while (true) {\n";
+    out << "            Scanned scanned = ScanToken(source, pos, token);\n";
+    out << "            if (scanned == Scanned::kNoMatch && pos < chunk.end) {\n";
+    out << "                chunk.no_match.push_back(pos++);\n";
+    out << "                continue;\n";
+    out << "            }\n";
+    out << "            if (scanned != Scanned::kToken || StartOf(source, token) >= chunk.end) {\n";
+    out << "                break;\n";
+    out << "            }\n";
+    out << "            chunk.tokens.push_back(token);\n";
+    out << "        }\n";
+    out << "    };\n";
+    out << "    std::vector<std::thread> pool;\n";
+    out << "    for (size_t i = 1; i < count; ++i) {\n";
+    out << "        pool.emplace_back(lex_chunk, i);\n";
+    out << "    }\n";
+    out << "    lex_chunk(0);\n";
+    out << "    for (std::thread &thread : pool) {\n";
+    out << "        thread.join();\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    // the lexer keeps no state between tokens, so a scan from the start of a\n";
+    out << "    // token goes on like any other scan that reached it. the true scan is\n";
+    out << "    // resumed at each chunk and lexes anew only until it meets a token the\n";
+    out << "    // guess started at too, usually the first one\n";
+    out << "    size_t total = 0;\n";
+    out << "    for (const Chunk<Sink> &chunk : chunks) {\n";
+    out << "        total += chunk.tokens.size();\n";
+    out << "    }\n";
+    out << "    sink.reserve(total);\n";
+    out << "    size_t resume = 0;\n";
+    out << "    for (const Chunk<Sink> &chunk : chunks) {\n";
+    out << "        size_t pos = resume;\n";
+    out << "        Terminal token;\n";
+    out << "        size_t next = 0;\n";
+    out << "        while (true) {\n";
+    out << "            if (!NextToken(source, pos, token)) {\n";
+    out << "                return;\n";
+    out << "            }\n";
+    out << "            size_t start = StartOf(source, token);\n";
+    out << "            if (start >= chunk.end) {\n";
+    out << "                resume = start;\n";
+    out << "                break;\n";
+    out << "            }\n";
+    out << "            while (next < chunk.tokens.size() &&\n";
+    out << "                   StartOf(source, chunk.tokens[next]) < start) {\n";
+    out << "                ++next;\n";
+    out << "            }\n";
+    out << "            if (next < chunk.tokens.size() &&\n";
+    out << "                StartOf(source, chunk.tokens[next]) == start) {\n";
+    out << "                // from here on the guess lexed like the true scan\n";
+    out << "                auto error = std::lower_bound(\n";
+    out << "                    chunk.no_match.begin(), chunk.no_match.end(), start\n";
+    out << "                );\n";
+    out << "                if (error != chunk.no_match.end()) {\n";
+    out << "                    ThrowNoMatch(source, *error);\n";
+    out << "                }\n";
+    out << "                Append(sink, chunk.tokens, next);\n";
+    out << "                Terminal last = chunk.tokens[chunk.tokens.size() - 1];\n";
+    out << "                resume = StartOf(source, last) + last.repr.size();\n";
+    out << "                break;\n";
+    out << "            }\n";
+    out << "            sink.push_back(token);\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "}\n";
+    out << "}  // namespace\n";
+    out << "\n";
+    out << "std::vector<Terminal> LexParallel(std::string_view source, size_t threads) {\n";
+    out << "    std::vector<Terminal> tokens;\n";
+    out << "    LexParallelTo(source, threads, tokens);\n";
+    out << "    return tokens;\n";
+    out << "}\n";
+    out << "\n";
+    out << "std::vector<Terminal> LexParallel(const MappedFile &file, size_t threads) {\n";
+    out << "    return LexParallel(file.Data(), threads);\n";
+    out << "}\n";
+    out << "\n";
+    out << "TokenStream LexPackedParallel(std::string_view source, size_t threads) {\n";
+    out << "    TokenStream tokens(source);\n";
+    out << "    LexParallelTo(source, threads, tokens);\n";
+    out << "    return tokens;\n";
+    out << "}\n";
+    out << "\n";
+    out << "TokenStream LexPackedParallel(const MappedFile &file, size_t threads) {\n";
+    out << "    return LexPackedParallel(file.Data(), threads);\n";
+    out << "}\n";
+}
+
+void LexerGenerator::EmitMappedFile(std::ostream &out) {
+    out << "LexerError::LexerError(const std::string &msg) : std::runtime_error(msg) {\n";
+    out << "}\n";
+    out << "\n";
+    out << "MappedFile::MappedFile(const std::string &filename) {\n";
+    out << "#if __has_include(<sys/mman.h>)\n";
+    out << "    int fd = open(filename.c_str(), O_RDONLY);\n";
+    out << "    if (fd == -1) {\n";
+    out << "        throw LexerError(\n";
+    out << "            \"Cannot open file `\" + filename + \"`: \" + std::strerror(errno)\n";
+    out << "        );\n";
+    out << "    }\n";
+    out << "    struct stat info;\n";
+    out << "    if (fstat(fd, &info) == -1) {\n";
+    out << "        int error = errno;\n";
+    out << "        close(fd);\n";
+    out << "        throw LexerError(\n";
+    out << "            \"Cannot stat file `\" + filename + \"`: \" + std::strerror(error)\n";
+    out << "        );\n";
+    out << "    }\n";
+    out << "    if (S_ISREG(info.st_mode)) {\n";
+    out << "        size_ = static_cast<size_t>(info.st_size);\n";
+    out << "        // an empty file cannot be mapped, and needs no mapping anyway\n";
+    out << "        if (size_ > 0) {\n";
+    out << "            void *addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);\n";
+    out << "            if (addr == MAP_FAILED) {\n";
+    out << "                int error = errno;\n";
+    out << "                close(fd);\n";
+    out << "                throw LexerError(\n";
+    out << "                    \"Cannot map file `\" + filename + \"`: \" + std::strerror(error)\n";
+    out << "                );\n";
+    out << "            }\n";
+    out << "            madvise(addr, size_, MADV_SEQUENTIAL);\n";
+    out << "            data_ = static_cast<const char *>(addr);\n";
+    out << "            mapped_ = true;\n";
+    out << "        }\n";
+    out << "        close(fd);\n";
+    out << "        return;\n";
+    out << "    }\n";
+    out << "    // pipes and character devices cannot be mapped, so they are read instead\n";
+    out << "    char chunk[1 << 16];\n";
+    out << "    while (true) {\n";
+    out << "        ssize_t count = read(fd, chunk, sizeof(chunk));\n";
+    out << "        if (count == -1 && errno == EINTR) {\n";
+    out << "            continue;\n";
+    out << "        }\n";
+    out << "        if (count == -1) {\n";
+    out << "            int error = errno;\n";
+    out << "            close(fd);\n";
+    out << "            throw LexerError(\n";
+    out << "                \"Cannot read file `\" + filename + \"`: \" + std::strerror(error)\n";
+    out << "            );\n";
+    out << "        }\n";
+    out << "        if (count == 0) {\n";
+    out << "            break;\n";
+    out << "        }\n";
+    out << "        buffer_.insert(buffer_.end(), chunk, chunk + count);\n";
+    out << "    }\n";
+    out << "    close(fd);\n";
+    out << "#else\n";
+    out << "    std::ifstream in(filename, std::ios::binary);\n";
+    out << "    if (!in) {\n";
+    out << "        throw LexerError(\"Cannot open file `\" + filename + \"`\");\n";
+    out << "    }\n";
+    out << "    buffer_.assign(\n";
+    out << "        std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()\n";
+    out << "    );\n";
+    out << "    if (in.bad()) {\n";
+    out << "        throw LexerError(\"Cannot read file `\" + filename + \"`\");\n";
+    out << "    }\n";
+    out << "#endif\n";
+    out << "    data_ = buffer_.data();\n";
+    out << "    size_ = buffer_.size();\n";
+    out << "}\n";
+    out << "MappedFile::MappedFile(MappedFile &&other) noexcept\n";
+    out << "    : data_(std::exchange(other.data_, nullptr)),\n";
+    out << "      size_(std::exchange(other.size_, 0)),\n";
+    out << "      mapped_(std::exchange(other.mapped_, false)),\n";
+    out << "      buffer_(std::move(other.buffer_)) {\n";
+    out << "}\n";
+    out << "\n";
+    out << "MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {\n";
+    out << "    // the old contents of this object are released by the destructor of\n";
+    out << "    // `other`\n";
+    out << "    std::swap(data_, other.data_);\n";
+    out << "    std::swap(size_, other.size_);\n";
+    out << "    std::swap(mapped_, other.mapped_);\n";
+    out << "    std::swap(buffer_, other.buffer_);\n";
+    out << "    return *this;\n";
+    out << "}\n";
+    out << "\n";
+    out << "MappedFile::~MappedFile() {\n";
+    out << "#if __has_include(<sys/mman.h>)\n";
+    out << "    if (mapped_) {\n";
+    out << "        munmap(const_cast<char *>(data_), size_);\n";
+    out << "    }\n";
+    out << "#endif\n";
+    out << "}\n";
+}
+
+void LexerGenerator::EmitHeader(std::ostream &out) const {
     out << "#pragma once\n";
     out << "\n";
-    out << "#include \"variant\"\n";
+    out << "#include <algorithm>\n";
+    out << "#include <cstddef>\n";
+    out << "#include <cstdint>\n";
+    out << "#include <cstring>\n";
+    out << "#include <stdexcept>\n";
+    out << "#include <string>\n";
+    out << "#include <string_view>\n";
+    out << "#include <variant>\n";
+    out << "#include <vector>\n";
+    out << "\n";
+    out << "#include \"Edits.h\"\n";
+    out << "#include \"LineIndex.h\"\n";
+    out << "\n";
+    out << "namespace " << namespace_ << " {\n";
+    out << "using TextEdit = pargen::TextEdit;\n";
+    out << "using TokenEdit = pargen::TokenEdit;\n";
+    out << "using Position = pargen::Position;\n";
+    out << "using LineIndex = pargen::LineIndex;\n";
+    out << "\n";
+    out << "struct TerminalInfo {\n";
+    out << "    std::string_view name;\n";
+    out << "    bool quote;\n";
+    out << "};\n";
+    out << "\n";
+    out << "// Indexed by terminal kind; kind 0 is the end of input.\n";
+    out << "inline constexpr TerminalInfo kTerminals[] = {\n";
+    for (const Terminal &t : symbols_.GetTerminals()) {
+        out << "    {\"" << EscapeString(t.name_) << "\", "
+            << (t.IsQuote() ? "true" : "false") << "},\n";
+    }
+    out << "};\n";
+    out << "\n";
+    out << "// Indexed by non-terminal kind; kind 0 is the augmented start symbol.\n";
+    out << "inline constexpr std::string_view kNonTerminals[] = {\n";
+    for (const NonTerminal &nt : symbols_.GetNonTerminals()) {
+        out << "    \"" << EscapeString(nt.name_) << "\",\n";
+    }
+    out << "};\n";
     out << "\n";
-    out << "namespace p {\n";
+    out << "// `repr` is the lexeme; it points into the buffer the token was lexed from,\n";
+    out << "// which must outlive the token and every parse tree built from it.\n";
     out << "struct Terminal {\n";
-    out << "    std::string name;\n";
-    out << "    std::string repr = \"\";\n";
+    out << "    uint32_t kind = 0;\n";
+    out << "    std::string_view repr = {};\n";
+    out << "\n";
+    out << "    std::string_view Name() const {\n";
+    out << "        return kTerminals[kind].name;\n";
+    out << "    }\n";
+    out << "    bool IsQuote() const {\n";
+    out << "        return kTerminals[kind].quote;\n";
+    out << "    }\n";
     out << "    bool operator==(const Terminal &other) const {\n";
-    out << "        return name == other.name;\n";
+    out << "        return kind == other.kind;\n";
     out << "    }\n";
     out << "    bool operator!=(const Terminal &other) const {\n";
-    out << "        return name != other.name;\n";
+    out << "        return kind != other.kind;\n";
     out << "    }\n";
     out << "};\n";
     out << "\n";
     out << "struct NonTerminal {\n";
-    out << "    std::string name;\n";
+    out << "    uint32_t kind = 0;\n";
+    out << "\n";
+    out << "    std::string_view Name() const {\n";
+    out << "        return kNonTerminals[kind];\n";
+    out << "    }\n";
     out << "    bool operator==(const NonTerminal &other) const {\n";
-    out << "        return name == other.name;\n";
+    out << "        return kind == other.kind;\n";
     out << "    }\n";
     out << "    bool operator!=(const NonTerminal &other) const {\n";
-    out << "        return name != other.name;\n";
+    out << "        return kind != other.kind;\n";
     out << "    }\n";
     out << "};\n";
     out << "\n";
     out << "using Token = std::variant<Terminal, NonTerminal>;\n";
-    out << "};  // namespace p\n";
-}
\ No newline at end of file
+    out << "\n";
+    out << "// A token packed into 12 bytes: the kind and the position of the lexeme in the\n";
+    out << "// buffer it was lexed from. The kind takes the low 24 bits of the first word\n";
+    out << "// and bits 32-39 of the offset the high 8, so buffers of up to 1 TiB can be\n";
+    out << "// addressed.\n";
+    out << "struct PackedToken {\n";
+    out << "    static constexpr uint32_t kMaxKind = (uint32_t{1} << 24) - 1;\n";
+    out << "    static constexpr uint64_t kMaxOffset = (uint64_t{1} << 40) - 1;\n";
+    out << "\n";
+    out << "    uint32_t kind_and_offset_high = 0;\n";
+    out << "    uint32_t offset_low = 0;\n";
+    out << "    uint32_t length = 0;\n";
+    out << "\n";
+    out << "    uint32_t Kind() const {\n";
+    out << "        return kind_and_offset_high & kMaxKind;\n";
+    out << "    }\n";
+    out << "    uint64_t Offset() const {\n";
+    out << "        return (uint64_t{kind_and_offset_high >> 24} << 32) | offset_low;\n";
+    out << "    }\n";
+    out << "};\n";
+    out << "\n";
+    out << "static_assert(sizeof(PackedToken) == 12);\n";
+    out << "\n";
+    out << "// The tokens of a buffer as packed records, half the size of a vector of\n";
+    out << "// `Terminal`. Lexemes are not copied but referred to by their position in the\n";
+    out << "// buffer (the source, or a pool of lexemes filled by a custom lexer), which\n";
+    out << "// must outlive the stream and every parse tree built from it.\n";
+    out << "//\n";
+    out << "// The records are kept around a gap at the last edit, see `Replace`: those\n";
+    out << "// before it hold the offsets of their lexemes, those after it the distances\n";
+    out << "// from the end of the buffer, which an edit before them does not change. An\n";
+    out << "// edit thus costs as much as the records it replaces and those the gap moves\n";
+    out << "// over, not as the whole stream.\n";
+    out << "class TokenStream {\n";
+    out << "public:\n";
+    out << "    explicit TokenStream(std::string_view source = {}) : source_(source) {}\n";
+    out << "\n";
+    out << "    // Appends a token whose lexeme lies within the buffer.\n";
+    out << "    void push_back(const Terminal &token) {\n";
+    out << "        uint64_t offset = token.repr.empty() ? 0 : token.repr.data() - source_.data();\n";
+    out << "        emplace_back(token.kind, offset, token.repr.size());\n";
+    out << "    }\n";
+    out << "    // Appends a token by the position of its lexeme. Throws std::length_error\n";
+    out << "    // if the kind or the position do not fit a record.\n";
+    out << "    void emplace_back(uint32_t kind, uint64_t offset, uint64_t length) {\n";
+    out << "        if (kind > PackedToken::kMaxKind || offset > PackedToken::kMaxOffset ||\n";
+    out << "            length > UINT32_MAX) {\n";
+    out << "            throw std::length_error(\"Token does not fit a packed record\");\n";
+    out << "        }\n";
+    out << "        MoveGap(size());\n";
+    out << "        head_.push_back(Pack(kind, offset, static_cast<uint32_t>(length)));\n";
+    out << "    }\n";
+    out << "    // Replaces `removed` records from the `start`-th on by those of `inserted`\n";
+    out << "    // and takes the buffer of `inserted`, which is the current one with the\n";
+    out << "    // edit the records were lexed again for. The records after them keep their\n";
+    out << "    // distance from the end of the buffer. Throws std::length_error if the new\n";
+    out << "    // buffer is too large for a record.\n";
+    out << "    void Replace(size_t start, size_t removed, const TokenStream &inserted) {\n";
+    out << "        if (inserted.source_.size() > PackedToken::kMaxOffset) {\n";
+    out << "            throw std::length_error(\"Token does not fit a packed record\");\n";
+    out << "        }\n";
+    out << "        MoveGap(start + removed);\n";
+    out << "        head_.resize(start);\n";
+    out << "        source_ = inserted.source_;\n";
+    out << "        for (size_t i = 0; i < inserted.size(); ++i) {\n";
+    out << "            head_.push_back(inserted.GetRecord(i));\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    // Appends the tokens of `other`, which is over the same buffer, from the\n";
+    out << "    // `from`-th on.\n";
+    out << "    void Append(const TokenStream &other, size_t from) {\n";
+    out << "        MoveGap(size());\n";
+    out << "        if (other.tail_.empty()) {\n";
+    out << "            head_.insert(head_.end(), other.head_.begin() + from, other.head_.end());\n";
+    out << "            return;\n";
+    out << "        }\n";
+    out << "        for (size_t i = from; i < other.size(); ++i) {\n";
+    out << "            head_.push_back(other.GetRecord(i));\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    Terminal operator[](size_t i) const {\n";
+    out << "        PackedToken record = GetRecord(i);\n";
+    out << "        return Terminal{\n";
+    out << "            record.Kind(),\n";
+    out << "            std::string_view(source_.data() + record.Offset(), record.length)\n";
+    out << "        };\n";
+    out << "    }\n";
+    out << "    size_t size() const {\n";
+    out << "        return head_.size() + tail_.size();\n";
+    out << "    }\n";
+    out << "    bool empty() const {\n";
+    out << "        return size() == 0;\n";
+    out << "    }\n";
+    out << "    void reserve(size_t count) {\n";
+    out << "        head_.reserve(count);\n";
+    out << "    }\n";
+    out << "    void clear() {\n";
+    out << "        head_.clear();\n";
+    out << "        tail_.clear();\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    std::string_view GetSource() const {\n";
+    out << "        return source_;\n";
+    out << "    }\n";
+    out << "    // Points the records to another buffer, e.g. once a pool of lexemes is\n";
+    out << "    // complete and will not move anymore.\n";
+    out << "    void SetSource(std::string_view source) {\n";
+    out << "        MoveGap(size());\n";
+    out << "        source_ = source;\n";
+    out << "    }\n";
+    out << "    // The `i`-th record, with the offset of its lexeme.\n";
+    out << "    PackedToken GetRecord(size_t i) const {\n";
+    out << "        if (i < head_.size()) {\n";
+    out << "            return head_[i];\n";
+    out << "        }\n";
+    out << "        const PackedToken &record = tail_[size() - 1 - i];\n";
+    out << "        return Pack(record.Kind(), source_.size() - record.Offset(), record.length);\n";
+    out << "    }\n";
+    out << "\n";
+    out << "private:\n";
+    out << "    static PackedToken Pack(uint32_t kind, uint64_t offset, uint32_t length) {\n";
+    out << "        return PackedToken{\n";
+    out << "            kind | (static_cast<uint32_t>(offset >> 32) << 24),\n";
+    out << "            static_cast<uint32_t>(offset), length\n";
+    out << "        };\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    // Moves the gap in front of the `i`-th record.\n";
+    out << "    void MoveGap(size_t i) {\n";
+    out << "        while (head_.size() > i) {\n";
+    out << "            const PackedToken &record = head_.back();\n";
+    out << "            tail_.push_back(\n";
+    out << "                Pack(record.Kind(), source_.size() - record.Offset(), record.length)\n";
+    out << "            );\n";
+    out << "            head_.pop_back();\n";
+    out << "        }\n";
+    out << "        while (head_.size() < i) {\n";
+    out << "            head_.push_back(GetRecord(head_.size()));\n";
+    out << "            tail_.pop_back();\n";
+    out << "        }\n";
+    out << "    }\n";
+    out << "\n";
+    out << "    std::string_view source_;\n";
+    out << "    // the records before the gap, in order\n";
+    out << "    std::vector<PackedToken> head_;\n";
+    out << "    // the records after the gap, last first, with the distances of their\n";
+    out << "    // lexemes from the end of the buffer\n";
+    out << "    std::vector<PackedToken> tail_;\n";
+    out << "};\n";
+    if (validate_utf8_) {
+        out << "// Thrown when the input of the lexer cannot be read, is not valid UTF-8 or\n";
+        out << "// has a byte no rule matches.\n";
+    } else {
+        out << "// Thrown when the input of the lexer cannot be read or has a byte no rule\n";
+        out << "// matches.\n";
+    }
+    out << "class LexerError : public std::runtime_error {\n";
+    out << "public:\n";
+    out << "    explicit LexerError(const std::string &msg);\n";
+    out << "};\n";
+    out << "\n";
+    out << "// The contents of a file, mapped into memory where the platform allows it and\n";
+    out << "// read into a buffer otherwise. Tokens lexed from the file point into it, so it\n";
+    out << "// must outlive them.\n";
+    out << "class MappedFile {\n";
+    out << "public:\n";
+    out << "    // Throws LexerError if the file cannot be opened or read.\n";
+    out << "    explicit MappedFile(const std::string &filename);\n";
+    out << "    MappedFile(const MappedFile &) = delete;\n";
+    out << "    MappedFile &operator=(const MappedFile &) = delete;\n";
+    out << "    MappedFile(MappedFile &&other) noexcept;\n";
+    out << "    MappedFile &operator=(MappedFile &&other) noexcept;\n";
+    out << "    ~MappedFile();\n";
+    out << "\n";
+    out << "    std::string_view Data() const {\n";
+    out << "        return {data_, size_};\n";
+    out << "    }\n";
+    out << "\n";
+    out << "private:\n";
+    out << "    const char *data_ = nullptr;\n";
+    out << "    size_t size_ = 0;\n";
+    out << "    bool mapped_ = false;\n";
+    out << "    std::vector<char> buffer_;\n";
+    out << "};\n";
+    out << "\n";
+    out << "// Splits a buffer into tokens one at a time. All the state of a scan lives in\n";
+    out << "// the object, so lexers of any number of grammars can run at once, one per\n";
+    out << "// thread. The input is lexed in place: the lexemes of the tokens point into\n";
+    out << "// the buffer, which must outlive them.\n";
+    out << "class Lexer {\n";
+    out << "public:\n";
+    if (validate_utf8_) {
+        out << "    // Throws LexerError if `validate` is set and `source` is not valid UTF-8.\n";
+        out << "    explicit Lexer(std::string_view source = {}, bool validate = true);\n";
+        out << "\n";
+        out << "    // Starts scanning another buffer from its beginning, see the constructor.\n";
+        out << "    void Reset(std::string_view source, bool validate = true);\n";
+    } else {
+        out << "    explicit Lexer(std::string_view source = {});\n";
+        out << "\n";
+        out << "    // Starts scanning another buffer from its beginning.\n";
+        out << "    void Reset(std::string_view source);\n";
+    }
+    out << "    // Stores the next token to `token`; returns false at the end of input.\n";
+    out << "    // Throws LexerError, with the line and the column, at a byte no rule\n";
+    out << "    // matches; the rules have to cover whitespace too, e.g. `IGNORE = \\s+`.\n";
+    out << "    bool Next(Terminal &token);\n";
+    out << "    // Appends all the remaining tokens to `sink`.\n";
+    out << "    void LexTo(std::vector<Terminal> &sink);\n";
+    out << "    // Appends all the remaining tokens to `sink`, which has to be over the\n";
+    out << "    // buffer being scanned.\n";
+    out << "    void LexTo(TokenStream &sink);\n";
+    out << "\n";
+    out << "    std::string_view GetSource() const {\n";
+    out << "        return source_;\n";
+    out << "    }\n";
+    out << "    // The offset of the first byte not scanned yet.\n";
+    out << "    size_t GetPosition() const {\n";
+    out << "        return pos_;\n";
+    out << "    }\n";
+    out << "\n";
+    out << "private:\n";
+    out << "    std::string_view source_;\n";
+    out << "    size_t pos_ = 0;\n";
+    out << "};\n";
+    out << "\n";
+    if (validate_utf8_) {
+        out << "// The offset of the first byte of the first malformed UTF-8 character of\n";
+        out << "// `source`, or `std::string_view::npos` if it is valid UTF-8. Overlong forms,\n";
+        out << "// surrogates and code points above U+10FFFF are malformed.\n";
+        out << "size_t FindInvalidUtf8(std::string_view source);\n";
+    }
+    out << "// Lexes the whole input at once, see `Lexer`.\n";
+    out << "std::vector<Terminal> Lex(std::string_view source);\n";
+    out << "std::vector<Terminal> Lex(const char *data, size_t size);\n";
+    out << "std::vector<Terminal> Lex(const MappedFile &file);\n";
+    out << "// Lexes the whole input at once into packed records, see `TokenStream`.\n";
+    out << "TokenStream LexPacked(std::string_view source);\n";
+    out << "TokenStream LexPacked(const MappedFile &file);\n";
+    out << "\n";
+    out << "// Updates `tokens`, the tokens of `previous_source`, to those of `source`, which\n";
+    out << "// is `previous_source` with `edit` applied, and returns the edit of the tokens\n";
+    out << "// for `Parser::Reparse`. Only the part of the input the edit may have changed\n";
+    out << "// is lexed again; the result is the same as that of `Lex(source)`. Only the\n";
+    out << "// positions of the previous lexemes are used, so `previous_source` may be the\n";
+    out << "// same buffer, edited in place. If the lexing throws, `tokens` are unchanged.\n";
+    out << "// The tokens after the edit are pointed into `source` one by one, so this\n";
+    out << "// takes time in the number of tokens; for an editor, use the overload below.\n";
+    out << "TokenEdit Relex(\n";
+    out << "    std::vector<Terminal> &tokens, std::string_view previous_source,\n";
+    out << "    std::string_view source, const TextEdit &edit\n";
+    out << ");\n";
+    out << "// Same as above for packed tokens, whose previous buffer is not needed at all.\n";
+    out << "// The tokens after the edit are left as they are (see `TokenStream`), so this\n";
+    out << "// takes time in the size of the edit and its distance from the previous one.\n";
+    out << "TokenEdit Relex(TokenStream &tokens, std::string_view source, const TextEdit &edit);\n";
+    if (add_parallel_driver_) {
+        out << "// Lexes the whole input at once on `threads` threads, all the hardware ones\n";
+        out << "// if 0. Every thread lexes a chunk starting after a newline as if a token\n";
+        out << "// started there, and the chunks are joined at the first token that the scan\n";
+        out << "// of the preceding input starts at too, so the result is always the same as\n";
+        out << "// of `Lex`. Only input before that token is lexed twice.\n";
+        out << "std::vector<Terminal> LexParallel(std::string_view source, size_t threads = 0);\n";
+        out << "std::vector<Terminal> LexParallel(const MappedFile &file, size_t threads = 0);\n";
+        out << "TokenStream LexPackedParallel(std::string_view source, size_t threads = 0);\n";
+        out << "TokenStream LexPackedParallel(const MappedFile &file, size_t threads = 0);\n";
+    }
+    out << "}  // namespace " << namespace_ << "\n";
+}
+
+std::vector<std::pair<size_t, size_t>> LexerGenerator::ToRanges(
+    const CharSet &bytes
+) {
+    std::vector<std::pair<size_t, size_t>> ranges;
+    for (size_t b = 0; b < 256; ++b) {
+        if (!bytes[b]) {
+            continue;
+        }
+        if (!ranges.empty() && ranges.back().second + 1 == b) {
+            ranges.back().second = b;
+        } else {
+            ranges.emplace_back(b, b);
+        }
+    }
+    return ranges;
+}
+
+size_t LexerGenerator::GetTableSize(const LexerDFA &dfa) {
+    size_t max_state = dfa.GetStateCount() - 1;
+    size_t entry_size = sizeof(uint32_t);
+    if (max_state <= UINT8_MAX) {
+        entry_size = sizeof(uint8_t);
+    } else if (max_state <= UINT16_MAX) {
+        entry_size = sizeof(uint16_t);
+    }
+    return dfa.GetStateCount() * dfa.GetClassCount() * entry_size;
+}
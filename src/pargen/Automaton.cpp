@@ -1,8 +1,13 @@
 #include "Automaton.h"
 
+#include <algorithm>
 #include <boost/container_hash/hash_fwd.hpp>
 #include <cstddef>
+#include <map>
 #include <queue>
+#include <string>
+#include <unordered_set>
+#include <vector>
 
 #include "GrammarAnalyzer.h"
 #include "Helpers.h"
@@ -16,6 +21,13 @@ Automaton::Automaton(const Grammar &g, const GrammarAnalyzer &ga)
     BuildCanonicalCollection();
 }
 
+Automaton::Automaton(
+    const Grammar &g, const GrammarAnalyzer &ga, const Automaton &previous
+)
+    : g_(g), ga_(ga) {
+    BuildCanonicalCollection(ReusePrevious(previous));
+}
+
 bool Automaton::Item::operator==(const Item &other) const {
     return std::tie(rule_number_, dot_pos_, lookahead_) ==
            std::tie(other.rule_number_, other.dot_pos_, other.lookahead_);
@@ -108,28 +120,176 @@ std::set<Automaton::Item> Automaton::InternalClosure(const std::set<Item> &items
     return closure;
 }
 
-void Automaton::BuildCanonicalCollection() {
+void Automaton::BuildCanonicalCollection(
+    const std::map<State, Successors> &known
+) {
     State initial_state = Closure({Item{0, 0, T_EOF}});
     states_.insert({0, initial_state});
+    transitions_.emplace_back();
     std::queue<size_t> state_queue;
     state_queue.push(0);
     size_t state_idx = 1;
+    auto add_transition = [&](size_t from, const Token &token, State to) {
+        if (to.empty()) {
+            return;
+        }
+        size_t to_idx = state_idx;
+        auto found = states_.right.find(to);
+        if (found == states_.right.end()) {
+            states_.insert({state_idx, std::move(to)});
+            transitions_.emplace_back();
+            state_queue.push(state_idx);
+            ++state_idx;
+        } else {
+            to_idx = found->second;
+        }
+        transitions_[from].emplace_back(token, to_idx);
+    };
     while (!state_queue.empty()) {
         size_t current_idx = state_queue.front();
         state_queue.pop();
         const State &current_state = states_.left.at(current_idx);
+        auto successors = known.find(current_state);
+        if (successors != known.end()) {
+            for (const auto &[token, kernel] : successors->second) {
+                add_transition(current_idx, token, Closure(kernel));
+            }
+            continue;
+        }
         for (const Token &token : g_.tokens_) {
-            State goto_token_state = Goto(current_state, token);
-            if (!goto_token_state.empty()) {
-                if (states_.right.find(goto_token_state) ==
-                    states_.right.end()) {
-                    states_.insert({state_idx, goto_token_state});
-                    state_queue.push(state_idx);
-                    ++state_idx;
+            add_transition(current_idx, token, Goto(current_state, token));
+        }
+    }
+}
+
+std::map<Automaton::State, Automaton::Successors> Automaton::ReusePrevious(
+    const Automaton &previous
+) {
+    std::unordered_set<NonTerminal> rules_changed =
+        ChangedNonTerminals(previous.g_, g_);
+    const FirstSets &previous_first = previous.ga_.GetFirst();
+    std::unordered_set<NonTerminal> first_changed;
+    for (const auto &[token, first] : ga_.GetFirst()) {
+        if (!IsNonTerminal(token)) {
+            continue;
+        }
+        auto found = previous_first.find(token);
+        if (found == previous_first.end() || found->second != first) {
+            first_changed.insert(std::get<NonTerminal>(token));
+        }
+    }
+
+    // rules are matched by contents; identical ones keep their order
+    std::map<std::vector<std::string>, std::vector<size_t>> numbers;
+    for (size_t i = g_.rules_.size(); i-- > 0;) {
+        numbers[RuleKey(g_[i])].push_back(i);
+    }
+    std::vector<std::optional<size_t>> renumber(previous.g_.rules_.size());
+    for (size_t i = 0; i < previous.g_.rules_.size(); ++i) {
+        auto found = numbers.find(RuleKey(previous.g_[i]));
+        if (found != numbers.end() && !found->second.empty()) {
+            renumber[i] = found->second.back();
+            found->second.pop_back();
+        }
+    }
+
+    // an item adds to a closure the productions of the non-terminal after
+    // its dot, with FIRST of what follows that non-terminal as lookaheads
+    auto unaffected = [&](const Item &item) {
+        if (!renumber[item.rule_number_].has_value()) {
+            return false;
+        }
+        const Production &prod = previous.g_[item.rule_number_].prod;
+        if (item.dot_pos_ >= prod.size() || IsTerminal(prod[item.dot_pos_])) {
+            return true;
+        }
+        const NonTerminal &expanded = std::get<NonTerminal>(prod[item.dot_pos_]);
+        if (rules_changed.contains(expanded)) {
+            return false;
+        }
+        for (size_t i = item.dot_pos_ + 1; i < prod.size(); ++i) {
+            if (IsTerminal(prod[i])) {
+                break;
+            }
+            const NonTerminal &nt = std::get<NonTerminal>(prod[i]);
+            if (first_changed.contains(nt)) {
+                return false;
+            }
+            // FIRST of the rest is not needed past a non-nullable symbol
+            if (!previous_first.at(nt).contains(EPSILON)) {
+                break;
+            }
+        }
+        return true;
+    };
+    auto renumbered = [&](const auto &items) {
+        std::set<Item> result;
+        for (const Item &item : items) {
+            result.insert(Item{
+                *renumber[item.rule_number_], item.dot_pos_, item.lookahead_
+            });
+        }
+        return result;
+    };
+    for (const auto &[key, closure] : previous.closure_cache_) {
+        // the closure contains its kernel, so checking it covers the key
+        if (!std::all_of(closure.begin(), closure.end(), unaffected)) {
+            continue;
+        }
+        closure_cache_.emplace(
+            GetKey(renumbered(key.items_)), renumbered(closure)
+        );
+        ++reused_closures_;
+    }
+
+    // the kernel of a state reached by a transition is the part of it with
+    // the dot moved
+    std::map<State, Successors> known;
+    for (const auto &[idx, state] : previous.states_.left) {
+        bool renumbered_all = std::all_of(
+            state.begin(), state.end(),
+            [&](const Item &item) {
+                return renumber[item.rule_number_].has_value();
+            }
+        );
+        if (!renumbered_all) {
+            continue;
+        }
+        Successors successors;
+        for (const auto &[token, next] : previous.transitions_[idx]) {
+            std::vector<Item> kernel;
+            for (const Item &item : previous.states_.left.at(next)) {
+                if (item.dot_pos_ > 0) {
+                    kernel.push_back(item);
                 }
             }
+            successors.emplace_back(token, renumbered(kernel));
+        }
+        known.emplace(renumbered(state), std::move(successors));
+    }
+    return known;
+}
+
+std::optional<size_t> Automaton::GetTransition(
+    size_t state, const Token &next
+) const {
+    for (const auto &[token, to] : transitions_.at(state)) {
+        if (token == next) {
+            return to;
         }
     }
+    return std::nullopt;
+}
+
+size_t Automaton::GetReusedClosureCount() const {
+    return reused_closures_;
+}
+
+void Automaton::Release() {
+    // swapping with empty containers frees their memory, unlike `clear`
+    decltype(closure_cache_)().swap(closure_cache_);
+    StateMap().swap(states_);
+    decltype(transitions_)().swap(transitions_);
 }
 
 const Automaton::StateMap &Automaton::GetStates() const {
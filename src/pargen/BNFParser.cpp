@@ -1,5 +1,8 @@
 #include "BNFParser.h"
 
+#include <algorithm>
+#include <iterator>
+
 #include "Entities.h"
 #include "Helpers.h"
 
@@ -22,6 +25,8 @@ GrammarParser::GrammarParser(std::unique_ptr<std::istream> in)
 }
 
 void GrammarParser::Parse() {
+    buffer_.assign(std::istreambuf_iterator<char>(*in_), {});
+    pos_ = 0;
     while (!PeekAt(EOF)) {
         ++line_;
         SkipWS();
@@ -37,12 +42,23 @@ const Grammar &GrammarParser::Get() const {
     return g_;
 }
 
+Grammar GrammarParser::Take() {
+    return std::move(g_);
+}
+
+const std::vector<std::string> &GrammarParser::GetWarnings() const {
+    return warnings_;
+}
+
 void GrammarParser::ThrowError(const std::string &msg) {
     throw GrammarParserError(msg, line_);
 }
 
 int GrammarParser::GetChar() {
-    return in_->get();
+    if (pos_ == buffer_.size()) {
+        return EOF;
+    }
+    return static_cast<unsigned char>(buffer_[pos_++]);
 }
 
 int GrammarParser::GetChar(int expected) {
@@ -58,7 +74,10 @@ int GrammarParser::GetChar(int expected) {
 }
 
 int GrammarParser::Peek() const {
-    return in_->peek();
+    if (pos_ == buffer_.size()) {
+        return EOF;
+    }
+    return static_cast<unsigned char>(buffer_[pos_]);
 }
 
 bool GrammarParser::PeekAt(int c) const {
@@ -92,9 +111,11 @@ void GrammarParser::ParseLine() {
             ParseIgnore();
             return;
         } else if (t.name_ == "EPSILON") {
-            std::cerr << "Warning: changing EPSILON is not allowed, ignoring "
-                         "declaration on line "
-                      << line_ << std::endl;
+            warnings_.push_back(
+                "Warning: changing EPSILON is not allowed, ignoring "
+                "declaration on line " +
+                std::to_string(line_)
+            );
         }
         if (t.IsQuote()) {
             ThrowError(
@@ -102,25 +123,24 @@ void GrammarParser::ParseLine() {
                 "surrounding quotes on LHS"
             );
         }
-        std::string regex;
-        while (!(PeekAt('\n') || PeekAt(EOF))) {
-            regex += GetChar();
-        }
+        std::string_view regex = ParseRestOfLine();
         size_t last_non_space = regex.find_last_not_of(' ');
-        if (last_non_space != std::string::npos) {
+        if (last_non_space != std::string_view::npos) {
             regex = regex.substr(0, last_non_space + 1);
         }
-        g_.tokens_.insert(Terminal{t.name_, regex});
+        AddToken(Terminal{t.name_, std::string(regex)});
     } else if (IsNonTerminal(lhs)) {
         NonTerminal nt_lhs = std::get<NonTerminal>(lhs);
+        lhs_ = nt_lhs;
         while (!(PeekAt('\n') || PeekAt(EOF))) {
             SkipWS();
             Production prod = ParseProduction();
             if (prod.empty()) {
-                std::cerr << "Warning: empty production on line " << line_
-                          << std::endl;
+                warnings_.push_back(
+                    "Warning: empty production on line " + std::to_string(line_)
+                );
             } else {
-                g_.rules_.push_back(Rule{nt_lhs, prod});
+                g_.rules_.push_back(Rule{nt_lhs, std::move(prod)});
             }
             SkipWS();
             if (PeekAt('|')) {
@@ -128,6 +148,8 @@ void GrammarParser::ParseLine() {
             }
             ++rule_number;
         }
+        g_.rules_.insert(g_.rules_.end(), helpers_.begin(), helpers_.end());
+        helpers_.clear();
     } else {
         ThrowError("Unknown token type encountered");
     }
@@ -135,28 +157,35 @@ void GrammarParser::ParseLine() {
 
 Production GrammarParser::ParseProduction() {
     std::vector<Token> production;
-    bool has_epsilon = false;
-    while (!(PeekAt('\n') || PeekAt(EOF) || PeekAt('|'))) {
+    while (!(PeekAt('\n') || PeekAt(EOF) || PeekAt('|') ||
+             (group_depth_ > 0 && PeekAt(')')))) {
+        if (PeekAt('(')) {
+            std::vector<Production> alternatives = ParseGroup();
+            SkipWS();
+            int op = ParseOperator();
+            if (op == 0 && alternatives.size() == 1 &&
+                alternatives[0] != Production{EPSILON}) {
+                // a group of one alternative only changes the precedence
+                production.insert(
+                    production.end(), alternatives[0].begin(),
+                    alternatives[0].end()
+                );
+            } else {
+                production.push_back(Desugar(op, alternatives));
+            }
+            continue;
+        }
+
         Token token = ParseToken();
         bool is_eps = false;
         if (IsTerminal(token)) {
-            Terminal t = std::get<Terminal>(token);
+            const Terminal &t = std::get<Terminal>(token);
             if (t.IsRegex()) {
                 if (t.name_ == "EPSILON") {
                     is_eps = true;
-                    has_epsilon = true;
                     token = EPSILON;
                 } else {
-                    bool found = false;
-                    for (const Token &defined_token : g_.tokens_) {
-                        if (IsTerminal(defined_token) &&
-                            std::get<Terminal>(defined_token).name_ ==
-                                t.name_) {
-                            found = true;
-                            break;
-                        }
-                    }
-                    if (!found) {
+                    if (!terminal_names_.contains(t.name_)) {
                         ThrowError(
                             "Unknown terminal encountered: " + t.name_ +
                             "; if the token is defined after this line, "
@@ -166,14 +195,22 @@ Production GrammarParser::ParseProduction() {
                 }
             }
         }
-        production.push_back(token);
         if (!is_eps) {
-            g_.tokens_.insert(token);
+            AddToken(token);
         }
         SkipWS();
+        int op = ParseOperator();
+        if (op == 0) {
+            production.push_back(std::move(token));
+        } else if (is_eps) {
+            ThrowError("Can't apply `" + std::string(1, op) + "` to EPSILON");
+        } else {
+            production.push_back(Desugar(op, {{token}}));
+        }
     }
 
-    if (has_epsilon && production.size() != 1) {
+    if (std::count(production.begin(), production.end(), Token{EPSILON}) > 0 &&
+        production.size() != 1) {
         ThrowError(
             "Epsilon can only be used in a single-token production; try "
             "getting rid of unnecessary epsilon productions"
@@ -183,10 +220,91 @@ Production GrammarParser::ParseProduction() {
     return production;
 }
 
+std::vector<Production> GrammarParser::ParseGroup() {
+    GetChar('(');
+    ++group_depth_;
+    std::vector<Production> alternatives;
+    while (true) {
+        SkipWS();
+        Production prod = ParseProduction();
+        if (prod.empty()) {
+            ThrowError("Empty alternative in a group; try using EPSILON");
+        }
+        alternatives.push_back(std::move(prod));
+        if (!PeekAt('|')) {
+            break;
+        }
+        GetChar();
+    }
+    if (!PeekAt(')')) {
+        ThrowError("Unterminated `(`");
+    }
+    GetChar();
+    --group_depth_;
+
+    return alternatives;
+}
+
+int GrammarParser::ParseOperator() {
+    if (!(PeekAt('*') || PeekAt('+') || PeekAt('?'))) {
+        return 0;
+    }
+    int op = GetChar();
+    SkipWS();
+
+    return op;
+}
+
+NonTerminal GrammarParser::Desugar(
+    int op, const std::vector<Production> &alternatives
+) {
+    bool repeated = op == '*' || op == '+';
+    std::string kind = repeated ? "list" : op == '?' ? "opt" : "group";
+    NonTerminal helper{
+        lhs_.name_ + "." + kind + std::to_string(++helper_counts_[lhs_.name_])
+    };
+
+    bool has_epsilon = false;
+    for (const Production &alternative : alternatives) {
+        if (alternative == Production{EPSILON}) {
+            if (repeated) {
+                ThrowError(
+                    "Can't repeat an empty alternative; try using `*` "
+                    "instead of `+`"
+                );
+            }
+            has_epsilon = true;
+        }
+    }
+
+    // the repetition is left-recursive, so that the parser reduces each
+    // element as soon as it is read instead of keeping the whole list on the
+    // stack
+    if (repeated) {
+        for (const Production &alternative : alternatives) {
+            Production prod{helper};
+            prod.insert(prod.end(), alternative.begin(), alternative.end());
+            helpers_.push_back(Rule{helper, prod});
+        }
+        g_.lists_.insert(helper);
+    }
+    if (op != '*') {
+        for (const Production &alternative : alternatives) {
+            helpers_.push_back(Rule{helper, alternative});
+        }
+    }
+    if (op == '*' || (op == '?' && !has_epsilon)) {
+        helpers_.push_back(Rule{helper, {EPSILON}});
+    }
+    AddToken(helper);
+
+    return helper;
+}
+
 Token GrammarParser::ParseToken() {
     if (PeekAt('<')) {
         GetChar();
-        NonTerminal token = NonTerminal{ParseName()};
+        NonTerminal token = NonTerminal{std::string(ParseName())};
         if (GetChar() != '>') {
             ThrowError("Unterminated `<`");
         }
@@ -194,7 +312,7 @@ Token GrammarParser::ParseToken() {
     } else if (PeekAt('\'') || PeekAt('"')) {
         return ParseQuoteTerminal();
     } else if (std::isalpha(Peek())) {
-        return Terminal{ParseName(), " "};
+        return Terminal{std::string(ParseName()), " "};
     }
 
     ThrowError(
@@ -205,34 +323,49 @@ Token GrammarParser::ParseToken() {
 }
 
 Terminal GrammarParser::ParseQuoteTerminal() {
-    char init = GetChar();
-    std::string lexeme;
+    int init = GetChar();
+    size_t start = pos_;
     while (!(PeekAt(init) || PeekAt('\n') || PeekAt(EOF))) {
-        lexeme += GetChar();
+        ++pos_;
     }
+    std::string_view lexeme(buffer_.data() + start, pos_ - start);
     if (GetChar() != init) {
         ThrowError("Unterminated quote terminal");
     }
 
-    return Terminal{lexeme};
+    return Terminal{std::string(lexeme)};
 }
 
-std::string GrammarParser::ParseName() {
-    std::string name;
-    while ((std::isalnum(Peek()) || PeekAt('_')) && in_->peek() != '\n') {
-        name += GetChar();
+std::string_view GrammarParser::ParseName() {
+    size_t start = pos_;
+    while (std::isalnum(Peek()) || PeekAt('_')) {
+        ++pos_;
     }
 
-    return name;
+    return std::string_view(buffer_.data() + start, pos_ - start);
+}
+
+std::string_view GrammarParser::ParseRestOfLine() {
+    size_t start = pos_;
+    pos_ = std::min(buffer_.find('\n', pos_), buffer_.size());
+
+    return std::string_view(buffer_.data() + start, pos_ - start);
 }
 
 void GrammarParser::ParseIgnore() {
-    std::string regex;
-    while (!(PeekAt('\n') || PeekAt(EOF))) {
-        regex += GetChar();
-    }
+    g_.ignored_.emplace_back(ParseRestOfLine());
+}
 
-    g_.ignored_.push_back(regex);
+void GrammarParser::AddToken(const Token &token) {
+    // most symbols are referenced many times, and the hash set is much
+    // cheaper to probe than the ordered one
+    if (!added_.insert(token).second) {
+        return;
+    }
+    if (IsTerminal(token)) {
+        terminal_names_.insert(std::get<Terminal>(token).name_);
+    }
+    g_.tokens_.insert(token);
 }
 
 void GrammarParser::Verify() {
@@ -240,6 +373,11 @@ void GrammarParser::Verify() {
         ThrowError("Empty grammar");
     }
 
+    std::unordered_set<NonTerminal> defined;
+    for (const Rule &rule : g_.rules_) {
+        defined.insert(rule.lhs);
+    }
+
     line_ = 1;
     for (const Rule &rule : g_.rules_) {
         for (const Token &token : rule.prod) {
@@ -247,15 +385,7 @@ void GrammarParser::Verify() {
                 continue;
             }
 
-            bool found = false;
-            for (const Rule &other : g_.rules_) {
-                if (std::get<NonTerminal>(token) == other.lhs) {
-                    found = true;
-                    break;
-                }
-            }
-
-            if (!found) {
+            if (!defined.contains(std::get<NonTerminal>(token))) {
                 ThrowError(
                     "Encountered an undefined non-terminal " +
                     std::get<NonTerminal>(token).name_
@@ -269,5 +399,6 @@ void GrammarParser::Verify() {
 void GrammarParser::Augment() {
     NonTerminal first_rule = g_.rules_[0].lhs;
     g_.rules_.insert(g_.rules_.cbegin(), Rule{NonTerminal{"S'"}, {first_rule}});
-    g_.tokens_.insert({first_rule, T_EOF});
+    AddToken(first_rule);
+    AddToken(T_EOF);
 }
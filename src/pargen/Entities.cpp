@@ -38,8 +38,8 @@ bool NonTerminal::operator!=(const NonTerminal &other) const {
 
 bool operator<(const Token &a, const Token &b) {
     if (IsTerminal(a) && IsTerminal(b)) {
-        Terminal at = std::get<Terminal>(a);
-        Terminal bt = std::get<Terminal>(b);
+        const Terminal &at = std::get<Terminal>(a);
+        const Terminal &bt = std::get<Terminal>(b);
         return std::tie(at.name_, at.repr_) < std::tie(bt.name_, bt.repr_);
     } else if (IsNonTerminal(a) && IsNonTerminal(b)) {
         return std::get<NonTerminal>(a).name_ < std::get<NonTerminal>(b).name_;
@@ -1,14 +1,124 @@
 #include "GrammarAnalyzer.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
 #include "Entities.h"
 #include "Helpers.h"
 
+namespace {
+/**
+ * @brief Finds the strongly connected components of a graph with Tarjan's
+ * algorithm.
+ * @details A component is emitted only after all the components reachable
+ * from it, so they come in reverse topological order.
+ * @param edges The successors of each vertex.
+ * @return The components.
+ */
+std::vector<std::vector<size_t>> StronglyConnectedComponents(
+    const std::vector<std::vector<size_t>> &edges
+) {
+    constexpr size_t kUnvisited = SIZE_MAX;
+    size_t n = edges.size();
+    std::vector<size_t> index(n, kUnvisited);
+    std::vector<size_t> low(n, 0);
+    std::vector<bool> on_stack(n, false);
+    std::vector<size_t> stack;
+    std::vector<std::vector<size_t>> components;
+    size_t counter = 0;
+
+    // the depth-first search is iterative, a long chain of non-terminals must
+    // not overflow the call stack; each frame is a vertex and its next edge
+    std::vector<std::pair<size_t, size_t>> frames;
+    auto visit = [&](size_t v) {
+        index[v] = low[v] = counter++;
+        stack.push_back(v);
+        on_stack[v] = true;
+        frames.push_back({v, 0});
+    };
+    for (size_t root = 0; root < n; ++root) {
+        if (index[root] != kUnvisited) {
+            continue;
+        }
+        visit(root);
+        while (!frames.empty()) {
+            size_t v = frames.back().first;
+            size_t e = frames.back().second;
+            if (e < edges[v].size()) {
+                ++frames.back().second;
+                size_t w = edges[v][e];
+                if (index[w] == kUnvisited) {
+                    visit(w);
+                } else if (on_stack[w]) {
+                    low[v] = std::min(low[v], index[w]);
+                }
+                continue;
+            }
+            frames.pop_back();
+            if (!frames.empty()) {
+                size_t parent = frames.back().first;
+                low[parent] = std::min(low[parent], low[v]);
+            }
+            if (low[v] == index[v]) {
+                std::vector<size_t> component;
+                size_t w = 0;
+                do {
+                    w = stack.back();
+                    stack.pop_back();
+                    on_stack[w] = false;
+                    component.push_back(w);
+                } while (w != v);
+                components.push_back(std::move(component));
+            }
+        }
+    }
+    return components;
+}
+}  // namespace
+
 GrammarAnalyzer::GrammarAnalyzer(const Grammar &g) : g_(g) {
-    ComputeFirst();
-    ComputeFollow();
+    IndexNonTerminals();
+    std::vector<bool> first_changed = ComputeFirst(nullptr, {});
+    ComputeFollow(nullptr, {}, first_changed);
+}
+
+GrammarAnalyzer::GrammarAnalyzer(
+    const Grammar &g, const GrammarAnalyzer &previous
+)
+    : g_(g) {
+    IndexNonTerminals();
+    std::unordered_set<NonTerminal> changed =
+        ChangedNonTerminals(previous.g_, g_);
+    std::vector<bool> first_changed = ComputeFirst(&previous, changed);
+    ComputeFollow(&previous, changed, first_changed);
+}
+
+void GrammarAnalyzer::IndexNonTerminals() {
+    auto add = [&](const NonTerminal &nt) {
+        if (ids_.emplace(nt, nonterminals_.size()).second) {
+            nonterminals_.push_back(nt);
+        }
+    };
+    for (const Token &token : g_.tokens_) {
+        if (IsNonTerminal(token)) {
+            add(std::get<NonTerminal>(token));
+        }
+    }
+    for (const Rule &rule : g_.rules_) {
+        add(rule.lhs);
+        for (const Token &token : rule.prod) {
+            if (IsNonTerminal(token)) {
+                add(std::get<NonTerminal>(token));
+            }
+        }
+    }
 }
 
-void GrammarAnalyzer::ComputeFirst() {
+std::vector<bool> GrammarAnalyzer::ComputeFirst(
+    const GrammarAnalyzer *previous,
+    const std::unordered_set<NonTerminal> &changed
+) {
     for (const Token &token : g_.tokens_) {
         if (IsTerminal(token)) {
             first_[token] = {std::get<Terminal>(token)};
@@ -18,37 +128,90 @@ void GrammarAnalyzer::ComputeFirst() {
     }
     first_[EPSILON] = {EPSILON};
 
-    bool changed = true;
-    while (changed) {
-        changed = false;
-        for (const Rule &rule : g_.rules_) {
-            bool include_eps = true;
-            for (const Token &token : rule.prod) {
-                size_t prev_size = first_[rule.lhs].size();
-                std::set<Terminal> token_first = first_[token];
-                auto eps_location = token_first.find(EPSILON);
-                bool eps_in_token_first = token_first.contains(EPSILON);
-                if (eps_in_token_first) {
-                    token_first.erase(eps_location);
-                }
+    // FIRST of a non-terminal depends on FIRST of the non-terminals in its
+    // productions
+    size_t n = nonterminals_.size();
+    std::vector<std::vector<size_t>> rules(n);
+    std::vector<std::vector<size_t>> edges(n);
+    for (size_t i = 0; i < g_.rules_.size(); ++i) {
+        size_t lhs = ids_.at(g_[i].lhs);
+        rules[lhs].push_back(i);
+        for (const Token &token : g_[i].prod) {
+            if (IsNonTerminal(token)) {
+                edges[lhs].push_back(ids_.at(std::get<NonTerminal>(token)));
+            }
+        }
+    }
 
-                first_[rule.lhs].insert(token_first.begin(), token_first.end());
-                if (first_[rule.lhs].size() != prev_size) {
-                    changed = true;
-                }
-                if (!eps_in_token_first) {
-                    include_eps = false;
-                    break;
-                }
+    // the components a component depends on come before it, so their flags
+    // are final when it is reached
+    std::vector<bool> first_changed(n, false);
+    for (const std::vector<size_t> &component :
+         StronglyConnectedComponents(edges)) {
+        bool reuse = previous != nullptr;
+        for (size_t v : component) {
+            const NonTerminal &nt = nonterminals_[v];
+            reuse = reuse && !changed.contains(nt) &&
+                    previous->first_.contains(nt);
+            for (size_t w : edges[v]) {
+                reuse = reuse && !first_changed[w];
+            }
+        }
+        if (reuse) {
+            for (size_t v : component) {
+                first_[nonterminals_[v]] =
+                    previous->first_.at(nonterminals_[v]);
             }
-            if (include_eps) {
-                if (!first_[rule.lhs].contains(EPSILON)) {
-                    changed = true;
+            continue;
+        }
+
+        bool updated = true;
+        while (updated) {
+            updated = false;
+            for (size_t v : component) {
+                for (size_t i : rules[v]) {
+                    updated = AddFirst(g_[i]) || updated;
                 }
-                first_[rule.lhs].insert(EPSILON);
             }
         }
+        for (size_t v : component) {
+            const NonTerminal &nt = nonterminals_[v];
+            first_changed[v] = previous == nullptr ||
+                               !previous->first_.contains(nt) ||
+                               previous->first_.at(nt) != first_.at(nt);
+        }
     }
+    return first_changed;
+}
+
+bool GrammarAnalyzer::AddFirst(const Rule &rule) {
+    bool changed = false;
+    bool include_eps = true;
+    for (const Token &token : rule.prod) {
+        size_t prev_size = first_[rule.lhs].size();
+        std::set<Terminal> token_first = first_[token];
+        auto eps_location = token_first.find(EPSILON);
+        bool eps_in_token_first = token_first.contains(EPSILON);
+        if (eps_in_token_first) {
+            token_first.erase(eps_location);
+        }
+
+        first_[rule.lhs].insert(token_first.begin(), token_first.end());
+        if (first_[rule.lhs].size() != prev_size) {
+            changed = true;
+        }
+        if (!eps_in_token_first) {
+            include_eps = false;
+            break;
+        }
+    }
+    if (include_eps) {
+        if (!first_[rule.lhs].contains(EPSILON)) {
+            changed = true;
+        }
+        first_[rule.lhs].insert(EPSILON);
+    }
+    return changed;
 }
 
 std::set<Terminal> GrammarAnalyzer::FirstForSequence(
@@ -81,40 +244,125 @@ std::set<Terminal> GrammarAnalyzer::FirstForSequence(
     return result;
 }
 
-void GrammarAnalyzer::ComputeFollow() {
-    follow_[g_[0].lhs] = {T_EOF};
-    bool changed = true;
-    while (changed) {
-        changed = false;
-        for (const Rule &rule : g_.rules_) {
-            for (size_t i = 0; i < rule.prod.size(); ++i) {
-                if (IsTerminal(rule.prod[i])) {
+void GrammarAnalyzer::ComputeFollow(
+    const GrammarAnalyzer *previous,
+    const std::unordered_set<NonTerminal> &changed,
+    const std::vector<bool> &first_changed
+) {
+    // FOLLOW of a non-terminal takes FIRST of what comes after it in each of
+    // its occurrences, and FOLLOW of the LHS where that may be empty
+    size_t n = nonterminals_.size();
+    size_t start = ids_.at(g_[0].lhs);
+    std::vector<std::set<Terminal>> direct(n);
+    std::vector<std::vector<size_t>> edges(n);
+    std::vector<std::vector<size_t>> sources(n);
+    std::vector<bool> occurs(n, false);
+    // whether the occurrences of a non-terminal may differ from the previous
+    // ones, or FIRST of what follows them does
+    std::vector<bool> dirty(n, false);
+    for (const Rule &rule : g_.rules_) {
+        size_t lhs = ids_.at(rule.lhs);
+        bool rule_changed = changed.contains(rule.lhs);
+        bool tail_changed = false;
+        for (size_t i = rule.prod.size(); i-- > 0;) {
+            if (IsTerminal(rule.prod[i])) {
+                continue;
+            }
+            size_t nt = ids_.at(std::get<NonTerminal>(rule.prod[i]));
+            occurs[nt] = true;
+            std::vector<Token> beta(rule.prod.begin() + i + 1, rule.prod.end());
+            std::set<Terminal> to_add = FirstForSequence(beta);
+            if (to_add.contains(EPSILON)) {
+                to_add.erase(EPSILON);
+                edges[lhs].push_back(nt);
+                sources[nt].push_back(lhs);
+            }
+            direct[nt].insert(to_add.begin(), to_add.end());
+            dirty[nt] = dirty[nt] || rule_changed || tail_changed;
+            tail_changed = tail_changed || first_changed[nt];
+        }
+    }
+    if (previous != nullptr) {
+        // occurrences in the productions that are gone
+        for (const Rule &rule : previous->g_.rules_) {
+            if (!changed.contains(rule.lhs)) {
+                continue;
+            }
+            for (const Token &token : rule.prod) {
+                if (IsTerminal(token)) {
                     continue;
                 }
-                NonTerminal token = std::get<NonTerminal>(rule.prod[i]);
-                size_t prev_size = follow_[token].size();
-                if (i != rule.prod.size() - 1) {
-                    std::vector<Token> beta(
-                        rule.prod.begin() + i + 1, rule.prod.end()
-                    );
-                    auto to_add = FirstForSequence(beta);
-                    if (to_add.contains(EPSILON)) {
-                        to_add.erase(to_add.find(EPSILON));
-                        follow_[token].insert(
-                            follow_[rule.lhs].begin(), follow_[rule.lhs].end()
-                        );
+                auto found = ids_.find(std::get<NonTerminal>(token));
+                if (found != ids_.end()) {
+                    dirty[found->second] = true;
+                }
+            }
+        }
+    }
+
+    // FOLLOW flows along the edges, so the components are taken sources first
+    std::vector<std::set<Terminal>> follow(n);
+    std::vector<bool> follow_changed(n, false);
+    std::vector<std::vector<size_t>> components =
+        StronglyConnectedComponents(edges);
+    for (auto it = components.rbegin(); it != components.rend(); ++it) {
+        const std::vector<size_t> &component = *it;
+        bool reuse = previous != nullptr;
+        for (size_t v : component) {
+            const NonTerminal &nt = nonterminals_[v];
+            bool has_follow = occurs[v] || v == start;
+            reuse = reuse && !dirty[v] &&
+                    (!has_follow || previous->follow_.contains(nt));
+            for (size_t w : sources[v]) {
+                reuse = reuse && !follow_changed[w];
+            }
+        }
+        if (reuse) {
+            for (size_t v : component) {
+                auto found = previous->follow_.find(nonterminals_[v]);
+                if (found != previous->follow_.end()) {
+                    follow[v] = found->second;
+                }
+            }
+            continue;
+        }
+
+        for (size_t v : component) {
+            follow[v] = direct[v];
+            if (v == start) {
+                follow[v].insert(T_EOF);
+            }
+        }
+        bool updated = true;
+        while (updated) {
+            updated = false;
+            for (size_t v : component) {
+                size_t prev_size = follow[v].size();
+                for (size_t w : sources[v]) {
+                    if (w != v) {
+                        follow[v].insert(follow[w].begin(), follow[w].end());
                     }
-                    follow_[token].insert(to_add.begin(), to_add.end());
-                } else {
-                    follow_[token].insert(
-                        follow_[rule.lhs].begin(), follow_[rule.lhs].end()
-                    );
                 }
-                if (follow_[token].size() != prev_size) {
-                    changed = true;
+                if (follow[v].size() != prev_size) {
+                    updated = true;
                 }
             }
         }
+        for (size_t v : component) {
+            if (previous == nullptr) {
+                follow_changed[v] = true;
+                continue;
+            }
+            auto found = previous->follow_.find(nonterminals_[v]);
+            follow_changed[v] = found == previous->follow_.end() ||
+                                found->second != follow[v];
+        }
+    }
+
+    for (size_t v = 0; v < n; ++v) {
+        if (occurs[v] || v == start) {
+            follow_[nonterminals_[v]] = std::move(follow[v]);
+        }
     }
 }
 
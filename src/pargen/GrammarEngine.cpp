@@ -0,0 +1,215 @@
+#include "GrammarEngine.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "BNFParser.h"
+#include "GrammarAnalyzer.h"
+#include "Helpers.h"
+#include "LexerDFA.h"
+#include "PackedTables.h"
+#include "TableBuilder.h"
+
+GrammarEngineError::GrammarEngineError(const std::string &msg) : msg_(msg) {
+}
+
+const char *GrammarEngineError::what() const noexcept {
+    return msg_.c_str();
+}
+
+GrammarEngine::GrammarEngine(const std::string &grammar) {
+    GrammarParser gp(std::make_unique<std::istringstream>(grammar));
+    try {
+        gp.Parse();
+    } catch (const GrammarParserError &e) {
+        throw GrammarEngineError(e.what());
+    }
+    warnings_ = gp.GetWarnings();
+    const Grammar &g = gp.Get();
+    GrammarAnalyzer ga(g);
+    ParserTables tables(g, ga);
+    try {
+        tables.Generate();
+    } catch (const TableGeneratorError &e) {
+        throw GrammarEngineError(e.what());
+    }
+    SymbolTable symbols(g);
+    try {
+        BuildLexer(g, symbols);
+    } catch (const RegexError &e) {
+        throw GrammarEngineError(e.what());
+    }
+
+    for (const ::Terminal &t : symbols.GetTerminals()) {
+        terminal_names_.push_back(t.name_);
+        terminal_quotes_.push_back(t.IsQuote());
+    }
+    for (const ::NonTerminal &nt : symbols.GetNonTerminals()) {
+        nonterminal_names_.push_back(nt.name_);
+    }
+
+    // the tables are flattened row by row, so that a lookup costs the same
+    // two loads as in the static arrays of a generated parser
+    PackedTables packed(
+        g, symbols, tables.GetActionTable(), tables.GetGotoTable(), ga.GetFollow()
+    );
+    for (const std::vector<uint64_t> &row : packed.actions_) {
+        actions_.insert(actions_.end(), row.begin(), row.end());
+    }
+    for (const std::vector<uint64_t> &row : packed.gotos_) {
+        gotos_.insert(gotos_.end(), row.begin(), row.end());
+    }
+    rule_lhs_.assign(packed.rule_lhs_.begin(), packed.rule_lhs_.end());
+    rule_length_.assign(packed.rule_length_.begin(), packed.rule_length_.end());
+    rule_flatten_.assign(packed.rule_flatten_.begin(), packed.rule_flatten_.end());
+    follow_words_ = (terminal_names_.size() + 63) / 64;
+    for (const std::vector<uint64_t> &row : packed.follow_) {
+        follow_.insert(follow_.end(), row.begin(), row.end());
+    }
+}
+
+void GrammarEngine::BuildLexer(const Grammar &g, const SymbolTable &symbols) {
+    // the priorities of the generated lexer: quote terminals first, then regex
+    // terminals, then ignored input
+    std::vector<LexerRule> rules;
+    std::vector<int32_t> actions;
+    for (bool quote : {true, false}) {
+        for (const Token &token : g.tokens_) {
+            if (IsNonTerminal(token)) {
+                continue;
+            }
+            // the symbols of the grammar, not the tokens of the engine
+            ::Terminal t = std::get<::Terminal>(token);
+            if (t == T_EOF || t.name_.empty() || t.IsQuote() != quote) {
+                continue;
+            }
+            if (quote) {
+                rules.push_back(LexerRule{t.name_, true});
+            } else if (t.repr_ != " ") {
+                rules.push_back(LexerRule{t.repr_, false});
+            } else {
+                continue;
+            }
+            actions.push_back(static_cast<int32_t>(symbols.GetTerminalId(t)));
+        }
+    }
+    for (const std::string &regex : g.ignored_) {
+        rules.push_back(LexerRule{regex, false});
+        actions.push_back(kSkip);
+    }
+
+    LexerDFA dfa(rules);
+    class_count_ = dfa.GetClassCount();
+    for (size_t b = 0; b < 256; ++b) {
+        byte_classes_[b] = static_cast<uint32_t>(dfa.GetClass(static_cast<unsigned char>(b)));
+    }
+    start_ = static_cast<uint32_t>(dfa.GetStart());
+    transitions_.reserve(dfa.GetStateCount() * class_count_);
+    for (size_t state = 0; state < dfa.GetStateCount(); ++state) {
+        for (size_t cls = 0; cls < class_count_; ++cls) {
+            transitions_.push_back(static_cast<uint32_t>(dfa.GetTransition(state, cls)));
+        }
+        int rule = dfa.GetAccept(state);
+        accept_.push_back(rule == -1 ? kNoMatch : actions[rule]);
+    }
+}
+
+std::vector<GrammarEngine::Terminal> GrammarEngine::Lex(std::string_view source) const {
+    std::vector<Terminal> tokens;
+    Lexer lexer(*this, source);
+    Terminal token;
+    while (lexer.Next(token)) {
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+GrammarEngine::TokenStream GrammarEngine::LexStream(std::string_view source) const {
+    return TokenStream(Lex(source), source);
+}
+
+GrammarEngine::Tables GrammarEngine::GetTables() const {
+    Tables tables;
+    tables.kActions = TableView<uint32_t>{actions_.data(), terminal_names_.size()};
+    tables.kGoto = TableView<uint32_t>{gotos_.data(), nonterminal_names_.size()};
+    tables.kRuleLhs = rule_lhs_.data();
+    tables.kRuleLength = rule_length_.data();
+    tables.kRuleFlatten = rule_flatten_.data();
+    tables.kFollow = TableView<uint64_t>{follow_.data(), follow_words_};
+    tables.engine = this;
+    return tables;
+}
+
+GrammarEngine::Parser GrammarEngine::CreateParser() const {
+    return Parser(GetTables());
+}
+
+const std::string &GrammarEngine::GetTerminalName(uint32_t kind) const {
+    return terminal_names_.at(kind);
+}
+
+bool GrammarEngine::IsQuoteTerminal(uint32_t kind) const {
+    return terminal_quotes_.at(kind);
+}
+
+const std::string &GrammarEngine::GetNonTerminalName(uint32_t kind) const {
+    return nonterminal_names_.at(kind);
+}
+
+const std::vector<std::string> &GrammarEngine::GetWarnings() const {
+    return warnings_;
+}
+
+GrammarEngine::Lexer GrammarEngine::Tables::CreateLexer(std::string_view source) const {
+    return Lexer(*engine, source);
+}
+
+GrammarEngine::Lexer::Lexer(const GrammarEngine &engine, std::string_view source)
+    : engine_(engine), source_(source) {
+}
+
+bool GrammarEngine::Lexer::Next(Terminal &token) {
+    const uint32_t *transitions = engine_.transitions_.data();
+    const int32_t *accept = engine_.accept_.data();
+    size_t class_count = engine_.class_count_;
+    size_t pos = pos_;
+    while (pos < source_.size()) {
+        // longest match: run the DFA until it dies and take the last accepting
+        // state it went through
+        size_t state = engine_.start_;
+        int32_t action = kNoMatch;
+        size_t end = pos;
+        for (size_t i = pos; i < source_.size(); ++i) {
+            auto c = static_cast<unsigned char>(source_[i]);
+            state = transitions[state * class_count + engine_.byte_classes_[c]];
+            if (state == LexerDFA::kDeadState) {
+                break;
+            }
+            if (accept[state] != kNoMatch) {
+                action = accept[state];
+                end = i + 1;
+            }
+        }
+        if (action == kNoMatch) {
+            pargen::Position position = pargen::LineIndex(source_).Locate(pos);
+            throw GrammarEngineError(
+                "No token matches the input at " + std::to_string(position.line) + ":" +
+                std::to_string(position.column)
+            );
+        }
+        size_t start = pos;
+        pos = end;
+        if (action != kSkip) {
+            token = Terminal{static_cast<uint32_t>(action), source_.substr(start, end - start)};
+            pos_ = pos;
+            return true;
+        }
+    }
+    pos_ = pos;
+    return false;
+}
+
+std::string_view GrammarEngine::Lexer::GetSource() const {
+    return source_;
+}
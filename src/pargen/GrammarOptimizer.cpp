@@ -0,0 +1,397 @@
+#include "GrammarOptimizer.h"
+
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "GrammarAnalyzer.h"
+#include "Helpers.h"
+#include "TableBuilder.h"
+
+GrammarOptimizerError::GrammarOptimizerError(const std::string &msg)
+    : msg_(msg) {
+}
+
+const char *GrammarOptimizerError::what() const noexcept {
+    return msg_.c_str();
+}
+
+GrammarOptimizer::GrammarOptimizer(Grammar g, OptimizerOptions options)
+    : g_(std::move(g)), options_(options) {
+}
+
+void GrammarOptimizer::Optimize() {
+    // each transformation may enable the others, e.g. merging two
+    // non-terminals leaves a third one used once
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        if (options_.remove_useless) {
+            changed = RemoveUnproductive() || changed;
+            changed = RemoveUnreachable() || changed;
+        }
+        if (options_.merge_identical) {
+            changed = MergeIdentical() || changed;
+        }
+        if (options_.inline_single_use) {
+            changed = InlineSingleUse() || changed;
+        }
+        if (options_.left_recursion) {
+            changed = RewriteRightRecursion() || changed;
+        }
+    }
+}
+
+const Grammar &GrammarOptimizer::Get() const {
+    return g_;
+}
+
+Grammar GrammarOptimizer::Take() {
+    return std::move(g_);
+}
+
+const std::vector<std::string> &GrammarOptimizer::GetReport() const {
+    return report_;
+}
+
+bool GrammarOptimizer::RemoveUnproductive() {
+    std::unordered_set<NonTerminal> productive;
+    bool grown = true;
+    while (grown) {
+        grown = false;
+        for (const Rule &rule : g_.rules_) {
+            if (productive.contains(rule.lhs)) {
+                continue;
+            }
+            bool derives = std::all_of(
+                rule.prod.begin(), rule.prod.end(),
+                [&](const Token &token) {
+                    return IsTerminal(token) ||
+                           productive.contains(std::get<NonTerminal>(token));
+                }
+            );
+            if (derives) {
+                productive.insert(rule.lhs);
+                grown = true;
+            }
+        }
+    }
+
+    NonTerminal start = std::get<NonTerminal>(g_.rules_[0].prod[0]);
+    if (!productive.contains(start)) {
+        throw GrammarOptimizerError(
+            "The start symbol <" + start.name_ +
+            "> derives no string of terminals"
+        );
+    }
+
+    std::vector<NonTerminal> removed;
+    std::vector<Rule> kept;
+    for (const Rule &rule : g_.rules_) {
+        if (!productive.contains(rule.lhs)) {
+            if (std::find(removed.begin(), removed.end(), rule.lhs) ==
+                removed.end()) {
+                removed.push_back(rule.lhs);
+            }
+            continue;
+        }
+        bool derives = std::all_of(
+            rule.prod.begin(), rule.prod.end(),
+            [&](const Token &token) {
+                return IsTerminal(token) ||
+                       productive.contains(std::get<NonTerminal>(token));
+            }
+        );
+        if (derives) {
+            kept.push_back(rule);
+        }
+    }
+
+    bool changed = kept.size() != g_.rules_.size();
+    g_.rules_ = std::move(kept);
+    for (const NonTerminal &nt : removed) {
+        Erase(nt);
+        report_.push_back("Removed unproductive <" + nt.name_ + ">");
+    }
+    return changed;
+}
+
+bool GrammarOptimizer::RemoveUnreachable() {
+    std::unordered_map<NonTerminal, std::vector<size_t>> rules_of;
+    for (size_t i = 0; i < g_.rules_.size(); ++i) {
+        rules_of[g_.rules_[i].lhs].push_back(i);
+    }
+
+    std::unordered_set<NonTerminal> reachable{g_.rules_[0].lhs};
+    std::vector<NonTerminal> queue{g_.rules_[0].lhs};
+    while (!queue.empty()) {
+        NonTerminal nt = queue.back();
+        queue.pop_back();
+        for (size_t i : rules_of[nt]) {
+            for (const Token &token : g_.rules_[i].prod) {
+                if (IsNonTerminal(token) &&
+                    reachable.insert(std::get<NonTerminal>(token)).second) {
+                    queue.push_back(std::get<NonTerminal>(token));
+                }
+            }
+        }
+    }
+
+    std::vector<NonTerminal> removed;
+    std::vector<Rule> kept;
+    for (const Rule &rule : g_.rules_) {
+        if (reachable.contains(rule.lhs)) {
+            kept.push_back(rule);
+        } else if (std::find(removed.begin(), removed.end(), rule.lhs) ==
+                   removed.end()) {
+            removed.push_back(rule.lhs);
+        }
+    }
+
+    g_.rules_ = std::move(kept);
+    for (const NonTerminal &nt : removed) {
+        Erase(nt);
+        report_.push_back("Removed unreachable <" + nt.name_ + ">");
+    }
+    return !removed.empty();
+}
+
+bool GrammarOptimizer::MergeIdentical() {
+    // references of a non-terminal to itself are replaced, so that recursive
+    // non-terminals compare equal too; no name in a grammar has brackets
+    const Token self = NonTerminal{"<self>"};
+    std::vector<NonTerminal> order;
+    std::unordered_map<NonTerminal, std::vector<Production>> productions;
+    for (size_t i = 1; i < g_.rules_.size(); ++i) {
+        const Rule &rule = g_.rules_[i];
+        if (!productions.contains(rule.lhs)) {
+            order.push_back(rule.lhs);
+        }
+        Production prod = rule.prod;
+        std::replace(prod.begin(), prod.end(), Token{rule.lhs}, self);
+        productions[rule.lhs].push_back(prod);
+    }
+
+    // replacing a non-terminal everywhere keeps equal productions equal, so
+    // all the merges found in one pass can be made
+    std::map<std::pair<bool, std::vector<Production>>, NonTerminal> first_with;
+    bool changed = false;
+    for (const NonTerminal &nt : order) {
+        std::vector<Production> &prods = productions[nt];
+        std::sort(prods.begin(), prods.end());
+        auto [it, inserted] =
+            first_with.try_emplace({g_.lists_.contains(nt), prods}, nt);
+        if (!inserted) {
+            Replace(nt, it->second);
+            report_.push_back(
+                "Merged <" + nt.name_ + "> into <" + it->second.name_ + ">"
+            );
+            changed = true;
+        }
+    }
+    if (changed) {
+        RemoveDuplicates();
+    }
+    return changed;
+}
+
+bool GrammarOptimizer::InlineSingleUse() {
+    NonTerminal start = std::get<NonTerminal>(g_.rules_[0].prod[0]);
+    std::unordered_map<NonTerminal, size_t> rule_counts;
+    std::unordered_map<NonTerminal, size_t> uses;
+    for (const Rule &rule : g_.rules_) {
+        ++rule_counts[rule.lhs];
+        for (const Token &token : rule.prod) {
+            if (IsNonTerminal(token)) {
+                ++uses[std::get<NonTerminal>(token)];
+            }
+        }
+    }
+
+    // inlining moves the symbols of a production from one rule to another, so
+    // the counts stay valid
+    bool changed = false;
+    for (size_t i = 1; i < g_.rules_.size(); ++i) {
+        NonTerminal nt = g_.rules_[i].lhs;
+        if (nt == start || rule_counts[nt] != 1 || uses[nt] != 1 ||
+            g_.lists_.contains(nt)) {
+            continue;
+        }
+        auto user = std::find_if(
+            g_.rules_.begin(), g_.rules_.end(),
+            [&](const Rule &rule) {
+                return std::find(
+                           rule.prod.begin(), rule.prod.end(), Token{nt}
+                       ) != rule.prod.end();
+            }
+        );
+        if (user->lhs == nt) {
+            continue;
+        }
+
+        Production body = g_.rules_[i].prod;
+        if (body == Production{EPSILON}) {
+            body.clear();
+        }
+        Production &prod = user->prod;
+        auto pos = prod.erase(std::find(prod.begin(), prod.end(), Token{nt}));
+        prod.insert(pos, body.begin(), body.end());
+        if (prod.empty()) {
+            prod.push_back(EPSILON);
+        }
+        report_.push_back(
+            "Inlined <" + nt.name_ + "> into <" + user->lhs.name_ + ">"
+        );
+
+        g_.rules_.erase(g_.rules_.begin() + i);
+        Erase(nt);
+        --i;
+        changed = true;
+    }
+    if (changed) {
+        RemoveDuplicates();
+    }
+    return changed;
+}
+
+bool GrammarOptimizer::RewriteRightRecursion() {
+    // a rewrite may conflict, e.g. in S -> A | 'x' 'c', A -> 'x' A | 'b' the
+    // empty list has to be reduced on the 'x' that S shifts; a grammar that
+    // conflicts already is left to the table builder to report
+    std::optional<bool> checked;
+    std::vector<NonTerminal> order;
+    std::unordered_set<std::string> names;
+    for (size_t i = 1; i < g_.rules_.size(); ++i) {
+        if (names.insert(g_.rules_[i].lhs.name_).second) {
+            order.push_back(g_.rules_[i].lhs);
+        }
+    }
+
+    bool changed = false;
+    for (const NonTerminal &nt : order) {
+        if (g_.lists_.contains(nt) || conflicting_.contains(nt)) {
+            continue;
+        }
+        // A -> x A | y, where A occurs nowhere else in its productions
+        std::vector<Production> heads;
+        std::vector<Production> bases;
+        bool direct = true;
+        for (const Rule &rule : g_.rules_) {
+            if (rule.lhs != nt) {
+                continue;
+            }
+            auto count = std::count(rule.prod.begin(), rule.prod.end(), Token{nt});
+            if (count == 0) {
+                bases.push_back(rule.prod);
+            } else if (count == 1 && rule.prod.size() > 1 &&
+                       rule.prod.back() == Token{nt}) {
+                heads.emplace_back(rule.prod.begin(), rule.prod.end() - 1);
+            } else {
+                direct = false;
+            }
+        }
+        if (!direct || heads.empty() || bases.empty()) {
+            continue;
+        }
+
+        // A derives x* y: a repetition of the heads followed by a base; with
+        // the empty base alone, A itself becomes the repetition
+        if (!checked) {
+            checked = IsConflictFree();
+        }
+        Grammar saved = g_;
+        std::vector<std::string> saved_report = report_;
+        std::vector<Rule> rewritten;
+        NonTerminal list = nt;
+        if (bases != std::vector<Production>{{EPSILON}}) {
+            size_t n = 1;
+            while (names.contains(nt.name_ + ".list" + std::to_string(n))) {
+                ++n;
+            }
+            list = NonTerminal{nt.name_ + ".list" + std::to_string(n)};
+            names.insert(list.name_);
+            for (const Production &base : bases) {
+                Production prod{list};
+                if (base != Production{EPSILON}) {
+                    prod.insert(prod.end(), base.begin(), base.end());
+                }
+                rewritten.push_back(Rule{nt, prod});
+            }
+            g_.tokens_.insert(list);
+            report_.push_back(
+                "Made <" + nt.name_ + "> left-recursive through <" +
+                list.name_ + ">"
+            );
+        } else {
+            report_.push_back("Made <" + nt.name_ + "> left-recursive");
+        }
+        for (const Production &head : heads) {
+            Production prod{list};
+            prod.insert(prod.end(), head.begin(), head.end());
+            rewritten.push_back(Rule{list, prod});
+        }
+        rewritten.push_back(Rule{list, {EPSILON}});
+        g_.lists_.insert(list);
+
+        // the new rules take the place of the old ones
+        auto first = std::find_if(
+            g_.rules_.begin(), g_.rules_.end(),
+            [&](const Rule &rule) { return rule.lhs == nt; }
+        );
+        size_t at = first - g_.rules_.begin();
+        std::erase_if(g_.rules_, [&](const Rule &rule) {
+            return rule.lhs == nt;
+        });
+        g_.rules_.insert(
+            g_.rules_.begin() + at, rewritten.begin(), rewritten.end()
+        );
+        if (*checked && !IsConflictFree()) {
+            g_ = std::move(saved);
+            report_ = std::move(saved_report);
+            conflicting_.insert(nt);
+            report_.push_back(
+                "Kept <" + nt.name_ + "> right-recursive, as the rewrite conflicts"
+            );
+            continue;
+        }
+        changed = true;
+    }
+    return changed;
+}
+
+bool GrammarOptimizer::IsConflictFree() const {
+    GrammarAnalyzer ga(g_);
+    ParserTables tables(g_, ga);
+    try {
+        tables.Generate();
+    } catch (const TableGeneratorError &) {
+        return false;
+    }
+    return true;
+}
+
+void GrammarOptimizer::Replace(const NonTerminal &from, const NonTerminal &to) {
+    std::erase_if(g_.rules_, [&](const Rule &rule) {
+        return rule.lhs == from;
+    });
+    for (Rule &rule : g_.rules_) {
+        std::replace(rule.prod.begin(), rule.prod.end(), Token{from}, Token{to});
+    }
+    Erase(from);
+}
+
+void GrammarOptimizer::RemoveDuplicates() {
+    std::set<std::vector<std::string>> seen;
+    std::erase_if(g_.rules_, [&](const Rule &rule) {
+        return !seen.insert(RuleKey(rule)).second;
+    });
+}
+
+void GrammarOptimizer::Erase(const NonTerminal &nt) {
+    g_.tokens_.erase(nt);
+    g_.lists_.erase(nt);
+}
@@ -1,5 +1,9 @@
 #include "Helpers.h"
 
+#include <cctype>
+#include <set>
+#include <unordered_map>
+
 bool IsTerminal(const Token &token) {
     return std::holds_alternative<Terminal>(token);
 }
@@ -19,4 +23,122 @@ std::string QualName(Token token) {
     } else {
         return "NT_" + std::get<NonTerminal>(token).name_;
     }
-}
\ No newline at end of file
+}
+
+std::vector<std::string> RuleKey(const Rule &rule) {
+    std::vector<std::string> key{QualName(rule.lhs)};
+    for (const Token &token : rule.prod) {
+        key.push_back(QualName(token));
+    }
+    return key;
+}
+
+std::unordered_set<NonTerminal> ChangedNonTerminals(
+    const Grammar &before, const Grammar &after
+) {
+    auto productions = [](const Grammar &g) {
+        std::unordered_map<NonTerminal, std::multiset<std::vector<std::string>>>
+            result;
+        for (const Rule &rule : g.rules_) {
+            result[rule.lhs].insert(RuleKey(rule));
+        }
+        return result;
+    };
+    auto old_productions = productions(before);
+    auto new_productions = productions(after);
+    std::unordered_set<NonTerminal> changed;
+    for (const auto &[nt, prods] : old_productions) {
+        auto it = new_productions.find(nt);
+        if (it == new_productions.end() || it->second != prods) {
+            changed.insert(nt);
+        }
+    }
+    for (const auto &[nt, prods] : new_productions) {
+        if (!old_productions.contains(nt)) {
+            changed.insert(nt);
+        }
+    }
+    return changed;
+}
+
+std::string EscapeString(const std::string &s) {
+    std::string result;
+    for (char c : s) {
+        switch (c) {
+            case '"':
+                result += "\\\"";
+                break;
+            case '\\':
+                result += "\\\\";
+                break;
+            case '\n':
+                result += "\\n";
+                break;
+            case '\t':
+                result += "\\t";
+                break;
+            default: {
+                unsigned char byte = static_cast<unsigned char>(c);
+                if (byte < 0x20 || byte == 0x7f) {
+                    // always three digits, so a digit after it is not
+                    // taken as a part of the escape
+                    result += '\\';
+                    result += static_cast<char>('0' + (byte >> 6));
+                    result += static_cast<char>('0' + ((byte >> 3) & 7));
+                    result += static_cast<char>('0' + (byte & 7));
+                } else {
+                    result += c;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+bool IsNamespaceName(const std::string &s) {
+    bool part_start = true;
+    for (size_t i = 0; i < s.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        if (c == ':') {
+            if (part_start || i + 1 >= s.size() || s[i + 1] != ':') {
+                return false;
+            }
+            ++i;
+            part_start = true;
+        } else if (std::isalpha(c) || c == '_' ||
+                   (!part_start && std::isdigit(c))) {
+            part_start = false;
+        } else {
+            return false;
+        }
+    }
+    return !part_start;
+}
+
+std::string FitIntegerType(uint64_t max_value) {
+    if (max_value <= UINT8_MAX) {
+        return "uint8_t";
+    } else if (max_value <= UINT16_MAX) {
+        return "uint16_t";
+    } else if (max_value <= UINT32_MAX) {
+        return "uint32_t";
+    }
+    return "uint64_t";
+}
+
+void WriteIntegers(
+    std::ostream &out, const std::vector<uint64_t> &values, size_t indent
+) {
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (i % 16 == 0 && i != 0) {
+            out << ",\n" << std::string(indent, ' ');
+        } else if (i != 0) {
+            out << ", ";
+        }
+        if (values[i] > INT32_MAX) {
+            out << "0x" << std::hex << values[i] << std::dec;
+        } else {
+            out << values[i];
+        }
+    }
+}
@@ -0,0 +1,122 @@
+#include "KeywordTable.h"
+
+#include <algorithm>
+#include <bit>
+#include <numeric>
+
+namespace {
+// the number of displacements tried for a bucket before the table is grown
+constexpr uint32_t kMaxDisplacement = 1 << 16;
+}  // namespace
+
+KeywordTable::KeywordTable(const std::vector<std::string> &words)
+    : words_(words) {
+    size_t slot_count = std::bit_ceil(std::max<size_t>(2 * words_.size(), 1));
+    while (!Build(slot_count)) {
+        slot_count *= 2;
+    }
+}
+
+uint64_t KeywordTable::Hash(std::string_view word) {
+    // keywords are short, so the word is read in little-endian chunks of 8
+    // bytes rather than byte by byte
+    uint64_t hash = word.size();
+    for (size_t i = 0; i < word.size(); i += 8) {
+        uint64_t chunk = 0;
+        for (size_t k = 0; k < 8 && i + k < word.size(); ++k) {
+            chunk |= static_cast<uint64_t>(static_cast<unsigned char>(word[i + k]))
+                     << (8 * k);
+        }
+        hash = (hash ^ chunk) * 0x9e3779b97f4a7c15;
+        hash ^= hash >> 32;
+    }
+    return hash;
+}
+
+size_t KeywordTable::Slot(
+    uint64_t hash, uint32_t displacement, size_t slot_count
+) {
+    // the finalizer of splitmix64 is a bijection, so words with distinct
+    // hashes can always be separated by some displacement
+    uint64_t x = hash ^ displacement;
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111eb;
+    x ^= x >> 31;
+    return static_cast<size_t>(x & (slot_count - 1));
+}
+
+size_t KeywordTable::GetBucketCount() const {
+    return displacements_.size();
+}
+
+size_t KeywordTable::GetSlotCount() const {
+    return slots_.size();
+}
+
+const std::vector<uint32_t> &KeywordTable::GetDisplacements() const {
+    return displacements_;
+}
+
+const std::vector<int> &KeywordTable::GetSlots() const {
+    return slots_;
+}
+
+int KeywordTable::Find(std::string_view word) const {
+    uint64_t hash = Hash(word);
+    uint32_t displacement =
+        displacements_[(hash >> 32) & (displacements_.size() - 1)];
+    int index = slots_[Slot(hash, displacement, slots_.size())];
+    if (index == kEmptySlot || words_[index] != word) {
+        return kEmptySlot;
+    }
+    return index;
+}
+
+bool KeywordTable::Build(size_t slot_count) {
+    size_t bucket_count = std::max<size_t>(slot_count / 4, 1);
+    std::vector<uint64_t> hashes;
+    std::vector<std::vector<size_t>> buckets(bucket_count);
+    for (size_t i = 0; i < words_.size(); ++i) {
+        hashes.push_back(Hash(words_[i]));
+        buckets[(hashes[i] >> 32) & (bucket_count - 1)].push_back(i);
+    }
+    // the largest buckets are the hardest to place, so they go first
+    std::vector<size_t> order(bucket_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return buckets[a].size() > buckets[b].size();
+    });
+
+    displacements_.assign(bucket_count, 0);
+    slots_.assign(slot_count, kEmptySlot);
+    for (size_t b : order) {
+        if (buckets[b].empty()) {
+            break;
+        }
+        bool placed = false;
+        for (uint32_t d = 0; d < kMaxDisplacement && !placed; ++d) {
+            std::vector<size_t> taken;
+            for (size_t i : buckets[b]) {
+                size_t slot = Slot(hashes[i], d, slot_count);
+                if (slots_[slot] != kEmptySlot ||
+                    std::find(taken.begin(), taken.end(), slot) != taken.end()) {
+                    break;
+                }
+                taken.push_back(slot);
+            }
+            if (taken.size() == buckets[b].size()) {
+                for (size_t k = 0; k < taken.size(); ++k) {
+                    slots_[taken[k]] = static_cast<int>(buckets[b][k]);
+                }
+                displacements_[b] = d;
+                placed = true;
+            }
+        }
+        if (!placed) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,245 @@
+#include "LexerDFA.h"
+
+#include <algorithm>
+#include <map>
+
+LexerDFA::LexerDFA(const std::vector<LexerRule> &rules) {
+    NFA nfa;
+    size_t start = nfa.AddState();
+    for (size_t i = 0; i < rules.size(); ++i) {
+        RegexParser parser(rules[i].pattern_, rules[i].literal_);
+        size_t rule_start = parser.CompileTo(nfa, static_cast<int>(i));
+        nfa.states_[start].epsilon_.push_back(rule_start);
+    }
+    Determinize(nfa, start);
+    Minimize();
+    MergeClasses();
+}
+
+size_t LexerDFA::GetStart() const {
+    return start_;
+}
+
+size_t LexerDFA::GetStateCount() const {
+    return transitions_.size();
+}
+
+size_t LexerDFA::GetClassCount() const {
+    return class_count_;
+}
+
+size_t LexerDFA::GetClass(unsigned char c) const {
+    return classes_[c];
+}
+
+size_t LexerDFA::GetTransition(size_t state, size_t cls) const {
+    return transitions_[state][cls];
+}
+
+int LexerDFA::GetAccept(size_t state) const {
+    return accept_[state];
+}
+
+CharSet LexerDFA::GetLoopBytes(size_t state) const {
+    CharSet bytes;
+    for (size_t b = 0; b < 256; ++b) {
+        if (transitions_[state][classes_[b]] == state) {
+            bytes.set(b);
+        }
+    }
+    return bytes;
+}
+
+std::pair<size_t, int> LexerDFA::Match(std::string_view input) const {
+    std::pair<size_t, int> best = {0, -1};
+    size_t state = start_;
+    for (size_t i = 0; i < input.size(); ++i) {
+        state = transitions_[state][classes_[static_cast<unsigned char>(
+            input[i]
+        )]];
+        if (state == kDeadState) {
+            break;
+        }
+        if (accept_[state] != -1) {
+            best = {i + 1, accept_[state]};
+        }
+    }
+    return best;
+}
+
+void LexerDFA::Determinize(const NFA &nfa, size_t start) {
+    // bytes that belong to exactly the same transition sets of the NFA cannot
+    // be told apart by the DFA either
+    class_count_ = 1;
+    for (const NFA::State &state : nfa.states_) {
+        if (state.chars_.none()) {
+            continue;
+        }
+        std::map<std::pair<size_t, bool>, size_t> split;
+        for (size_t b = 0; b < 256; ++b) {
+            auto key = std::make_pair(classes_[b], state.chars_[b]);
+            auto it = split.try_emplace(key, split.size()).first;
+            classes_[b] = it->second;
+        }
+        class_count_ = split.size();
+    }
+    std::vector<unsigned char> representatives(class_count_);
+    for (size_t b = 256; b-- > 0;) {
+        representatives[classes_[b]] = static_cast<unsigned char>(b);
+    }
+
+    std::vector<size_t> visited(nfa.states_.size(), 0);
+    size_t stamp = 0;
+    auto closure = [&](std::vector<size_t> set) {
+        ++stamp;
+        std::vector<size_t> stack = set;
+        for (size_t s : set) {
+            visited[s] = stamp;
+        }
+        while (!stack.empty()) {
+            size_t s = stack.back();
+            stack.pop_back();
+            for (size_t next : nfa.states_[s].epsilon_) {
+                if (visited[next] != stamp) {
+                    visited[next] = stamp;
+                    set.push_back(next);
+                    stack.push_back(next);
+                }
+            }
+        }
+        std::sort(set.begin(), set.end());
+        return set;
+    };
+
+    std::map<std::vector<size_t>, size_t> ids;
+    std::vector<std::vector<size_t>> sets;
+    auto add = [&](std::vector<size_t> set) {
+        auto [it, inserted] = ids.try_emplace(set, sets.size());
+        if (inserted) {
+            int accept = -1;
+            for (size_t s : set) {
+                int rule = nfa.states_[s].accept_;
+                if (rule != -1 && (accept == -1 || rule < accept)) {
+                    accept = rule;
+                }
+            }
+            sets.push_back(std::move(set));
+            accept_.push_back(accept);
+            transitions_.emplace_back(class_count_, kDeadState);
+        }
+        return it->second;
+    };
+
+    add({});
+    start_ = add(closure({start}));
+    for (size_t i = 1; i < sets.size(); ++i) {
+        for (size_t cls = 0; cls < class_count_; ++cls) {
+            std::vector<size_t> moved;
+            for (size_t s : sets[i]) {
+                const NFA::State &state = nfa.states_[s];
+                if (state.chars_[representatives[cls]]) {
+                    moved.push_back(state.next_);
+                }
+            }
+            if (!moved.empty()) {
+                size_t target = add(closure(moved));
+                transitions_[i][cls] = target;
+            }
+        }
+    }
+}
+
+void LexerDFA::Minimize() {
+    size_t state_count = transitions_.size();
+    std::vector<size_t> block(state_count);
+    size_t block_count = 0;
+    {
+        std::map<int, size_t> initial;
+        for (size_t s = 0; s < state_count; ++s) {
+            auto it = initial.try_emplace(accept_[s], initial.size()).first;
+            block[s] = it->second;
+        }
+        block_count = initial.size();
+    }
+    while (true) {
+        std::map<std::vector<size_t>, size_t> refined;
+        std::vector<size_t> next_block(state_count);
+        for (size_t s = 0; s < state_count; ++s) {
+            std::vector<size_t> signature = {block[s]};
+            for (size_t target : transitions_[s]) {
+                signature.push_back(block[target]);
+            }
+            auto it = refined.try_emplace(signature, refined.size()).first;
+            next_block[s] = it->second;
+        }
+        block = std::move(next_block);
+        if (refined.size() == block_count) {
+            break;
+        }
+        block_count = refined.size();
+    }
+
+    // renumbers the blocks so that the dead state keeps index 0 and the rest
+    // are numbered in the order they are reached from the start state
+    std::vector<size_t> order(block_count, block_count);
+    std::vector<size_t> members(block_count);
+    for (size_t s = 0; s < state_count; ++s) {
+        members[block[s]] = s;
+    }
+    size_t next_id = 0;
+    order[block[kDeadState]] = next_id++;
+    std::vector<size_t> queue = {block[start_]};
+    if (order[block[start_]] == block_count) {
+        order[block[start_]] = next_id++;
+    }
+    for (size_t i = 0; i < queue.size(); ++i) {
+        for (size_t target : transitions_[members[queue[i]]]) {
+            if (order[block[target]] == block_count) {
+                order[block[target]] = next_id++;
+                queue.push_back(block[target]);
+            }
+        }
+    }
+
+    std::vector<std::vector<size_t>> transitions(next_id);
+    std::vector<int> accept(next_id);
+    for (size_t b = 0; b < block_count; ++b) {
+        if (order[b] == block_count) {
+            continue;
+        }
+        size_t id = order[b];
+        accept[id] = accept_[members[b]];
+        for (size_t target : transitions_[members[b]]) {
+            transitions[id].push_back(order[block[target]]);
+        }
+    }
+    start_ = order[block[start_]];
+    transitions_ = std::move(transitions);
+    accept_ = std::move(accept);
+}
+
+void LexerDFA::MergeClasses() {
+    std::map<std::vector<size_t>, size_t> columns;
+    std::vector<size_t> merged(class_count_);
+    for (size_t b = 0; b < 256; ++b) {
+        size_t cls = classes_[b];
+        std::vector<size_t> column;
+        for (const std::vector<size_t> &row : transitions_) {
+            column.push_back(row[cls]);
+        }
+        auto it = columns.try_emplace(column, columns.size()).first;
+        merged[cls] = it->second;
+        classes_[b] = it->second;
+    }
+
+    std::vector<std::vector<size_t>> transitions(
+        transitions_.size(), std::vector<size_t>(columns.size())
+    );
+    for (size_t s = 0; s < transitions_.size(); ++s) {
+        for (size_t cls = 0; cls < class_count_; ++cls) {
+            transitions[s][merged[cls]] = transitions_[s][cls];
+        }
+    }
+    class_count_ = columns.size();
+    transitions_ = std::move(transitions);
+}
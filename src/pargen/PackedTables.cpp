@@ -0,0 +1,67 @@
+#include "PackedTables.h"
+
+#include "Helpers.h"
+
+PackedTables::PackedTables(
+    const Grammar &g, const SymbolTable &symbols, const ActionTable &at,
+    const GotoTable &gt, const FollowSets &fs
+) {
+    size_t state_count = at.size();
+    size_t terminal_count = symbols.GetTerminals().size();
+    size_t nonterminal_count = symbols.GetNonTerminals().size();
+    size_t follow_words = (terminal_count + 63) / 64;
+
+    actions_.assign(state_count, std::vector<uint64_t>(terminal_count, 0));
+    for (size_t state = 0; state < state_count; ++state) {
+        for (const auto &[terminal, action] : at[state]) {
+            // the runtime numbers the types so that ERROR is 0
+            uint64_t type = 0;
+            switch (action.type_) {
+                case ActionType::ERROR:
+                    continue;
+                case ActionType::SHIFT:
+                    type = 1;
+                    break;
+                case ActionType::REDUCE:
+                    type = 2;
+                    break;
+                case ActionType::ACCEPT:
+                    type = 3;
+                    break;
+            }
+            actions_[state][symbols.GetTerminalId(terminal)] =
+                action.value_ << 2 | type;
+        }
+    }
+
+    gotos_.assign(state_count, std::vector<uint64_t>(nonterminal_count, 0));
+    for (const auto &[state, table] : gt) {
+        for (const auto &[nt, goto_value] : table) {
+            gotos_[state][symbols.GetNonTerminalId(nt)] = goto_value;
+        }
+    }
+
+    for (const Rule &rule : g.rules_) {
+        size_t length = 0;
+        for (const Token &token : rule.prod) {
+            if (IsNonTerminal(token) || std::get<Terminal>(token) != EPSILON) {
+                ++length;
+            }
+        }
+        rule_lhs_.push_back(symbols.GetNonTerminalId(rule.lhs));
+        rule_length_.push_back(length);
+        rule_flatten_.push_back(
+            g.lists_.contains(rule.lhs) && !rule.prod.empty() &&
+            rule.prod[0] == Token{rule.lhs}
+        );
+    }
+
+    follow_.assign(nonterminal_count, std::vector<uint64_t>(follow_words, 0));
+    for (const auto &[nt, follow_set] : fs) {
+        std::vector<uint64_t> &row = follow_[symbols.GetNonTerminalId(nt)];
+        for (const Terminal &t : follow_set) {
+            size_t id = symbols.GetTerminalId(t);
+            row[id / 64] |= uint64_t{1} << (id % 64);
+        }
+    }
+}
@@ -0,0 +1,629 @@
+#include "Regex.h"
+
+#include <algorithm>
+#include <cctype>
+
+RegexError::RegexError(const std::string &msg, const std::string &pattern)
+    : msg_("Invalid regex `" + pattern + "`: " + msg) {
+}
+
+const char *RegexError::what() const noexcept {
+    return msg_.c_str();
+}
+
+size_t NFA::AddState() {
+    states_.emplace_back();
+    return states_.size() - 1;
+}
+
+RegexParser::RegexParser(const std::string &pattern, bool literal)
+    : pattern_(pattern), literal_(literal) {
+}
+
+size_t RegexParser::CompileTo(NFA &nfa, int rule) {
+    nfa_ = &nfa;
+    pos_ = 0;
+    Fragment f;
+    if (literal_) {
+        f = ParseQuoted('\0');
+    } else {
+        f = ParseAlternation();
+        // as in flex, the pattern ends at the first unquoted whitespace
+        size_t end = pos_;
+        while (!AtEnd() && std::isspace(static_cast<unsigned char>(Peek()))) {
+            Get();
+        }
+        if (!AtEnd()) {
+            ThrowError("unexpected `" + std::string(1, Peek()) + "`");
+        }
+        pos_ = end;
+    }
+    if (pos_ == 0) {
+        ThrowError("empty pattern");
+    }
+    nfa.states_[f.end].accept_ = rule;
+    return f.start;
+}
+
+std::optional<std::string> RegexParser::GetLiteralString() {
+    if (!literal_) {
+        return std::nullopt;
+    }
+    pos_ = 0;
+    std::string result;
+    while (!AtEnd()) {
+        char c = Get();
+        if (c != '\\') {
+            result += c;
+            continue;
+        }
+        if (AtUnicodeEscape()) {
+            CodePointSet set = ParseUnicodeEscape();
+            const auto &ranges = set.GetRanges();
+            if (ranges.size() != 1 || ranges[0].first != ranges[0].second) {
+                return std::nullopt;
+            }
+            result += CodePointSet::EncodeUtf8(ranges[0].first);
+            continue;
+        }
+        CharSet chars = ParseEscape();
+        if (chars.count() != 1) {
+            return std::nullopt;
+        }
+        for (size_t b = 0; b < 256; ++b) {
+            if (chars[b]) {
+                result += static_cast<char>(b);
+            }
+        }
+    }
+    return result;
+}
+
+RegexParser::Fragment RegexParser::ParseAlternation() {
+    Fragment first = ParseConcatenation();
+    if (AtEnd() || Peek() != '|') {
+        return first;
+    }
+    size_t start = nfa_->AddState();
+    size_t end = nfa_->AddState();
+    nfa_->states_[start].epsilon_.push_back(first.start);
+    nfa_->states_[first.end].epsilon_.push_back(end);
+    while (!AtEnd() && Peek() == '|') {
+        Get();
+        Fragment next = ParseConcatenation();
+        nfa_->states_[start].epsilon_.push_back(next.start);
+        nfa_->states_[next.end].epsilon_.push_back(end);
+    }
+    return Fragment{start, end};
+}
+
+RegexParser::Fragment RegexParser::ParseConcatenation() {
+    Fragment result = Empty();
+    while (!AtEnd() && Peek() != '|' && Peek() != ')' &&
+           !std::isspace(static_cast<unsigned char>(Peek()))) {
+        result = Concatenate(result, ParseRepetition());
+    }
+    return result;
+}
+
+RegexParser::Fragment RegexParser::ParseRepetition() {
+    size_t begin = pos_;
+    Fragment f = ParseAtom();
+    while (!AtEnd() && (Peek() == '*' || Peek() == '+' || Peek() == '?' ||
+                        Peek() == '{')) {
+        f = ApplyOperator(f, begin);
+    }
+    return f;
+}
+
+RegexParser::Fragment RegexParser::ApplyOperator(Fragment f, size_t begin) {
+    size_t end = pos_;
+    char op = Get();
+    if (op == '*') {
+        return Star(f);
+    } else if (op == '+') {
+        return Plus(f);
+    } else if (op == '?') {
+        return Optional(f);
+    }
+
+    size_t min = ParseNumber();
+    size_t max = min;
+    bool unbounded = false;
+    if (!AtEnd() && Peek() == ',') {
+        Get();
+        if (!AtEnd() && Peek() == '}') {
+            unbounded = true;
+        } else {
+            max = ParseNumber();
+        }
+    }
+    if (AtEnd() || Get() != '}') {
+        ThrowError("unterminated `{`");
+    }
+    if (max < min) {
+        ThrowError("invalid repetition bounds");
+    }
+    // every copy of the repeated expression needs states of its own
+    bool first = true;
+    auto next_copy = [&]() {
+        if (first) {
+            first = false;
+            return f;
+        }
+        return CompileAgain(begin, end);
+    };
+    Fragment result = Empty();
+    for (size_t i = 0; i < min; ++i) {
+        result = Concatenate(result, next_copy());
+    }
+    if (unbounded) {
+        result = Concatenate(result, Star(next_copy()));
+    } else {
+        for (size_t i = min; i < max; ++i) {
+            result = Concatenate(result, Optional(next_copy()));
+        }
+    }
+    return result;
+}
+
+RegexParser::Fragment RegexParser::CompileAgain(size_t begin, size_t end) {
+    size_t saved = pos_;
+    pos_ = begin;
+    Fragment f = ParseAtom();
+    while (pos_ < end) {
+        f = ApplyOperator(f, begin);
+    }
+    pos_ = saved;
+    return f;
+}
+
+RegexParser::Fragment RegexParser::ParseAtom() {
+    char c = Get();
+    switch (c) {
+        case '(': {
+            Fragment f = ParseAlternation();
+            if (AtEnd() || Get() != ')') {
+                ThrowError("unterminated `(`");
+            }
+            return f;
+        }
+        case '"':
+            return ParseQuoted('"');
+        case '[':
+            return ParseBracket();
+        case '.': {
+            CharSet chars;
+            chars.set();
+            chars.reset('\n');
+            return Chars(chars);
+        }
+        case '\\':
+            if (AtUnicodeEscape()) {
+                return CodePoints(ParseUnicodeEscape());
+            }
+            return Chars(ParseEscape());
+        case '*':
+        case '+':
+        case '?':
+            ThrowError("nothing to repeat before `" + std::string(1, c) + "`");
+            break;
+        case '{':
+            ThrowError("named definitions are not supported");
+            break;
+        case '/':
+            ThrowError("trailing context is not supported");
+            break;
+        case '^':
+            if (pos_ == 1) {
+                ThrowError("anchors are not supported");
+            }
+            break;
+        case '$':
+            if (AtEnd()) {
+                ThrowError("anchors are not supported");
+            }
+            break;
+    }
+    // a non-ASCII character is repeated and grouped as a whole
+    size_t end = pos_ - 1;
+    std::optional<char32_t> decoded = CodePointSet::DecodeUtf8(pattern_, end);
+    if (decoded && *decoded > 0x7F) {
+        pos_ = end;
+        CodePointSet set;
+        set.Add(*decoded, *decoded);
+        return CodePoints(set);
+    }
+    CharSet chars;
+    chars.set(static_cast<unsigned char>(c));
+    return Chars(chars);
+}
+
+RegexParser::Fragment RegexParser::ParseQuoted(char terminator) {
+    Fragment result = Empty();
+    while (!AtEnd() && Peek() != terminator) {
+        char c = Get();
+        if (c == '\\' && AtUnicodeEscape()) {
+            result = Concatenate(result, CodePoints(ParseUnicodeEscape()));
+        } else if (c == '\\') {
+            result = Concatenate(result, Chars(ParseEscape()));
+        } else {
+            CharSet chars;
+            chars.set(static_cast<unsigned char>(c));
+            result = Concatenate(result, Chars(chars));
+        }
+    }
+    if (terminator != '\0') {
+        if (AtEnd()) {
+            ThrowError("unterminated `\"`");
+        }
+        Get();
+    }
+    return result;
+}
+
+RegexParser::Fragment RegexParser::ParseBracket() {
+    static const std::vector<std::pair<std::string, int (*)(int)>> classes = {
+        {"alnum", [](int c) { return std::isalnum(c); }},
+        {"alpha", [](int c) { return std::isalpha(c); }},
+        {"blank", [](int c) { return std::isblank(c); }},
+        {"cntrl", [](int c) { return std::iscntrl(c); }},
+        {"digit", [](int c) { return std::isdigit(c); }},
+        {"graph", [](int c) { return std::isgraph(c); }},
+        {"lower", [](int c) { return std::islower(c); }},
+        {"print", [](int c) { return std::isprint(c); }},
+        {"punct", [](int c) { return std::ispunct(c); }},
+        {"space", [](int c) { return std::isspace(c); }},
+        {"upper", [](int c) { return std::isupper(c); }},
+        {"xdigit", [](int c) { return std::isxdigit(c); }},
+    };
+
+    // an item is either a set of bytes or, for non-ASCII characters and
+    // Unicode escapes, a set of code points; returns whether it is the latter
+    auto parse_item = [this](CharSet &bytes, CodePointSet &code_points) {
+        char c = Get();
+        if (c == '\\') {
+            if (AtUnicodeEscape()) {
+                code_points = ParseUnicodeEscape();
+                return true;
+            }
+            bytes = ParseEscape();
+            return false;
+        }
+        size_t end = pos_ - 1;
+        std::optional<char32_t> decoded = CodePointSet::DecodeUtf8(pattern_, end);
+        if (decoded && *decoded > 0x7F) {
+            pos_ = end;
+            code_points.Add(*decoded, *decoded);
+            return true;
+        }
+        bytes.set(static_cast<unsigned char>(c));
+        return false;
+    };
+    // the only byte or code point of an item, if it has exactly one
+    auto single = [](const CharSet &bytes, const CodePointSet &code_points,
+                     bool unicode) -> std::optional<char32_t> {
+        if (unicode) {
+            const auto &ranges = code_points.GetRanges();
+            if (ranges.size() == 1 && ranges[0].first == ranges[0].second) {
+                return ranges[0].first;
+            }
+        } else if (bytes.count() == 1) {
+            char32_t b = 0;
+            while (!bytes[b]) {
+                ++b;
+            }
+            return b;
+        }
+        return std::nullopt;
+    };
+
+    CharSet chars;
+    CodePointSet code_points;
+    bool unicode = false;
+    bool negate = false;
+    if (!AtEnd() && Peek() == '^') {
+        Get();
+        negate = true;
+    }
+    bool first = true;
+    while (AtEnd() || Peek() != ']' || first) {
+        if (AtEnd()) {
+            ThrowError("unterminated `[`");
+        }
+        first = false;
+        if (pattern_.compare(pos_, 2, "[:") == 0) {
+            size_t close = pattern_.find(":]", pos_ + 2);
+            if (close == std::string::npos) {
+                ThrowError("unterminated character class");
+            }
+            std::string name = pattern_.substr(pos_ + 2, close - pos_ - 2);
+            pos_ = close + 2;
+            bool found = false;
+            for (const auto &[class_name, predicate] : classes) {
+                if (class_name == name) {
+                    for (int b = 0; b < 128; ++b) {
+                        if (predicate(b)) {
+                            chars.set(b);
+                        }
+                    }
+                    found = true;
+                }
+            }
+            if (!found) {
+                ThrowError("unknown character class `" + name + "`");
+            }
+            continue;
+        }
+
+        CharSet item;
+        CodePointSet item_code_points;
+        bool item_unicode = parse_item(item, item_code_points);
+        if (pos_ + 1 < pattern_.size() && Peek() == '-' &&
+            pattern_[pos_ + 1] != ']') {
+            Get();
+            CharSet upper;
+            CodePointSet upper_code_points;
+            bool upper_unicode = parse_item(upper, upper_code_points);
+            std::optional<char32_t> lo =
+                single(item, item_code_points, item_unicode);
+            std::optional<char32_t> hi =
+                single(upper, upper_code_points, upper_unicode);
+            if (!lo || !hi || *hi < *lo) {
+                ThrowError("invalid range in `[`");
+            }
+            if (item_unicode || upper_unicode) {
+                code_points.Add(*lo, *hi);
+                unicode = true;
+            } else {
+                for (size_t b = *lo; b <= *hi; ++b) {
+                    chars.set(b);
+                }
+            }
+        } else if (item_unicode) {
+            code_points.Add(item_code_points);
+            unicode = true;
+        } else {
+            chars |= item;
+        }
+    }
+    Get();
+    if (!unicode) {
+        if (negate) {
+            chars.flip();
+        }
+        return Chars(chars);
+    }
+    for (char32_t b = 0; b < 256; ++b) {
+        if (chars[b]) {
+            code_points.Add(b, b);
+        }
+    }
+    if (negate) {
+        code_points.Negate();
+    }
+    return CodePoints(code_points);
+}
+
+CharSet RegexParser::ParseEscape() {
+    if (AtEnd()) {
+        ThrowError("trailing `\\`");
+    }
+    CharSet chars;
+    char c = Get();
+    switch (c) {
+        case 'n':
+            chars.set('\n');
+            break;
+        case 't':
+            chars.set('\t');
+            break;
+        case 'r':
+            chars.set('\r');
+            break;
+        case 'f':
+            chars.set('\f');
+            break;
+        case 'v':
+            chars.set('\v');
+            break;
+        case 'a':
+            chars.set('\a');
+            break;
+        case 'b':
+            chars.set('\b');
+            break;
+        case 's':
+        case 'S':
+            for (int b : {' ', '\t', '\n', '\r', '\f', '\v'}) {
+                chars.set(b);
+            }
+            break;
+        case 'd':
+        case 'D':
+            for (int b = '0'; b <= '9'; ++b) {
+                chars.set(b);
+            }
+            break;
+        case 'w':
+        case 'W':
+            for (int b = 0; b < 128; ++b) {
+                if (std::isalnum(b) || b == '_') {
+                    chars.set(b);
+                }
+            }
+            break;
+        case 'x': {
+            size_t value = 0;
+            size_t digits = 0;
+            while (digits < 2 && !AtEnd() &&
+                   std::isxdigit(static_cast<unsigned char>(Peek()))) {
+                char d = Get();
+                value = value * 16 +
+                        (std::isdigit(static_cast<unsigned char>(d))
+                             ? d - '0'
+                             : std::tolower(static_cast<unsigned char>(d)) -
+                                   'a' + 10);
+                ++digits;
+            }
+            if (digits == 0) {
+                ThrowError("expected hexadecimal digits after `\\x`");
+            }
+            chars.set(value);
+            break;
+        }
+        default:
+            if (c >= '0' && c <= '7') {
+                size_t value = c - '0';
+                for (size_t digits = 1; digits < 3 && !AtEnd() &&
+                                        Peek() >= '0' && Peek() <= '7';
+                     ++digits) {
+                    value = value * 8 + (Get() - '0');
+                }
+                if (value > 255) {
+                    ThrowError("octal escape out of range");
+                }
+                chars.set(value);
+            } else {
+                chars.set(static_cast<unsigned char>(c));
+            }
+    }
+    if (c == 'S' || c == 'D' || c == 'W') {
+        chars.flip();
+    }
+    return chars;
+}
+
+bool RegexParser::AtUnicodeEscape() const {
+    return !AtEnd() && (Peek() == 'u' || Peek() == 'p' || Peek() == 'P');
+}
+
+CodePointSet RegexParser::ParseUnicodeEscape() {
+    char kind = Get();
+    std::string escape = "`\\" + std::string(1, kind) + "`";
+    if (AtEnd() || Get() != '{') {
+        ThrowError("expected `{` after " + escape);
+    }
+    size_t close = pattern_.find('}', pos_);
+    if (close == std::string::npos) {
+        ThrowError("unterminated " + escape);
+    }
+    std::string name = pattern_.substr(pos_, close - pos_);
+    pos_ = close + 1;
+    if (kind != 'u') {
+        std::optional<CodePointSet> property = CodePointSet::FromProperty(name);
+        if (!property) {
+            ThrowError("unknown Unicode property `" + name + "`");
+        }
+        if (kind == 'P') {
+            property->Negate();
+        }
+        return *property;
+    }
+    if (name.empty() || name.size() > 6 ||
+        !std::all_of(name.begin(), name.end(), [](char d) {
+            return std::isxdigit(static_cast<unsigned char>(d));
+        })) {
+        ThrowError("expected hexadecimal digits in " + escape);
+    }
+    char32_t c = static_cast<char32_t>(std::stoul(name, nullptr, 16));
+    if (c > CodePointSet::kMaxCodePoint || (c >= 0xD800 && c <= 0xDFFF)) {
+        ThrowError("U+" + name + " is not a Unicode scalar value");
+    }
+    CodePointSet set;
+    set.Add(c, c);
+    return set;
+}
+
+size_t RegexParser::ParseNumber() {
+    if (AtEnd() || !std::isdigit(static_cast<unsigned char>(Peek()))) {
+        ThrowError("expected a number in `{`");
+    }
+    size_t value = 0;
+    while (!AtEnd() && std::isdigit(static_cast<unsigned char>(Peek()))) {
+        value = value * 10 + (Get() - '0');
+        if (value > 1000) {
+            ThrowError("repetition count is too large");
+        }
+    }
+    return value;
+}
+
+RegexParser::Fragment RegexParser::Chars(const CharSet &chars) {
+    size_t start = nfa_->AddState();
+    size_t end = nfa_->AddState();
+    nfa_->states_[start].chars_ = chars;
+    nfa_->states_[start].next_ = end;
+    return Fragment{start, end};
+}
+
+RegexParser::Fragment RegexParser::CodePoints(const CodePointSet &set) {
+    size_t start = nfa_->AddState();
+    size_t end = nfa_->AddState();
+    for (const CodePointSet::ByteSequence &sequence : set.ToUtf8Sequences()) {
+        Fragment f = Empty();
+        for (const auto &[lo, hi] : sequence) {
+            CharSet chars;
+            for (size_t b = lo; b <= hi; ++b) {
+                chars.set(b);
+            }
+            f = Concatenate(f, Chars(chars));
+        }
+        nfa_->states_[start].epsilon_.push_back(f.start);
+        nfa_->states_[f.end].epsilon_.push_back(end);
+    }
+    return Fragment{start, end};
+}
+
+RegexParser::Fragment RegexParser::Empty() {
+    size_t state = nfa_->AddState();
+    return Fragment{state, state};
+}
+
+RegexParser::Fragment RegexParser::Concatenate(Fragment a, Fragment b) {
+    nfa_->states_[a.end].epsilon_.push_back(b.start);
+    return Fragment{a.start, b.end};
+}
+
+RegexParser::Fragment RegexParser::Star(Fragment f) {
+    size_t start = nfa_->AddState();
+    size_t end = nfa_->AddState();
+    nfa_->states_[start].epsilon_ = {f.start, end};
+    nfa_->states_[f.end].epsilon_.push_back(f.start);
+    nfa_->states_[f.end].epsilon_.push_back(end);
+    return Fragment{start, end};
+}
+
+RegexParser::Fragment RegexParser::Plus(Fragment f) {
+    size_t end = nfa_->AddState();
+    nfa_->states_[f.end].epsilon_.push_back(f.start);
+    nfa_->states_[f.end].epsilon_.push_back(end);
+    return Fragment{f.start, end};
+}
+
+RegexParser::Fragment RegexParser::Optional(Fragment f) {
+    size_t start = nfa_->AddState();
+    size_t end = nfa_->AddState();
+    nfa_->states_[start].epsilon_ = {f.start, end};
+    nfa_->states_[f.end].epsilon_.push_back(end);
+    return Fragment{start, end};
+}
+
+bool RegexParser::AtEnd() const {
+    return pos_ >= pattern_.size();
+}
+
+char RegexParser::Peek() const {
+    return pattern_[pos_];
+}
+
+char RegexParser::Get() {
+    if (AtEnd()) {
+        ThrowError("unexpected end of pattern");
+    }
+    return pattern_[pos_++];
+}
+
+void RegexParser::ThrowError(const std::string &msg) const {
+    throw RegexError(msg, pattern_);
+}
@@ -0,0 +1,53 @@
+#include "SymbolTable.h"
+
+#include "Helpers.h"
+
+SymbolTable::SymbolTable(const Grammar &g) {
+    AddTerminal(T_EOF);
+    for (const Token &token : g.tokens_) {
+        if (IsTerminal(token)) {
+            AddTerminal(std::get<Terminal>(token));
+        }
+    }
+    for (const Rule &rule : g.rules_) {
+        if (!nonterminal_ids_.contains(rule.lhs)) {
+            nonterminal_ids_[rule.lhs] = nonterminals_.size();
+            nonterminals_.push_back(rule.lhs);
+        }
+    }
+}
+
+size_t SymbolTable::GetTerminalId(const Terminal &t) const {
+    return GetTerminalId(QualName(t));
+}
+
+size_t SymbolTable::GetTerminalId(const std::string &qual_name) const {
+    return terminal_ids_.at(qual_name);
+}
+
+size_t SymbolTable::GetNonTerminalId(const NonTerminal &nt) const {
+    return nonterminal_ids_.at(nt);
+}
+
+const std::vector<Terminal> &SymbolTable::GetTerminals() const {
+    return terminals_;
+}
+
+const std::vector<NonTerminal> &SymbolTable::GetNonTerminals() const {
+    return nonterminals_;
+}
+
+void SymbolTable::AddTerminal(const Terminal &t) {
+    if (t == EPSILON) {
+        return;
+    }
+    std::string key = QualName(t);
+    auto it = terminal_ids_.find(key);
+    if (it == terminal_ids_.end()) {
+        terminal_ids_[key] = terminals_.size();
+        terminals_.push_back(t);
+    } else if (t.repr_ != " ") {
+        // prefer the definition of a regex terminal over a reference to it
+        terminals_[it->second] = t;
+    }
+}
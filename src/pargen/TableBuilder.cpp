@@ -12,7 +12,13 @@ const char *TableGeneratorError::what() const noexcept {
 }
 
 ParserTables::ParserTables(const Grammar &g, const GrammarAnalyzer &ga)
-    : g_(g), automaton_(g, ga), states_(automaton_.GetStates()) {
+    : g_(g), automaton_(g, ga) {
+}
+
+ParserTables::ParserTables(
+    const Grammar &g, const GrammarAnalyzer &ga, const ParserTables &previous
+)
+    : g_(g), automaton_(g, ga, previous.automaton_) {
 }
 
 void ParserTables::Generate() {
@@ -20,28 +26,33 @@ void ParserTables::Generate() {
     BuildGotoTable();
 }
 
-ActionTable ParserTables::GetActionTable() const {
+void ParserTables::ReleaseAutomaton() {
+    automaton_.Release();
+}
+
+const ActionTable &ParserTables::GetActionTable() const {
     return action_;
 }
 
-GotoTable ParserTables::GetGotoTable() const {
+const GotoTable &ParserTables::GetGotoTable() const {
     return goto_;
 }
 
+const Automaton &ParserTables::GetAutomaton() const {
+    return automaton_;
+}
+
 void ParserTables::BuildActionTable() {
-    action_.resize(states_.size());
-    for (size_t i = 0; i < states_.size(); ++i) {
-        for (const Automaton::Item &item : states_.left.at(i)) {
+    const Automaton::StateMap &states = automaton_.GetStates();
+    action_.resize(states.size());
+    for (size_t i = 0; i < states.size(); ++i) {
+        for (const Automaton::Item &item : states.left.at(i)) {
             std::optional<Token> next_token_opt = automaton_.NextToken(item);
             if (next_token_opt.has_value()) {
                 Token next_token = next_token_opt.value();
                 if (IsTerminal(next_token)) {
-                    Automaton::State next_state =
-                        automaton_.Goto(states_.left.at(i), next_token);
-                    size_t next_state_j = 0;
-                    if (states_.right.find(next_state) != states_.right.end()) {
-                        next_state_j = states_.right.at(next_state);
-                    }
+                    size_t next_state_j =
+                        automaton_.GetTransition(i, next_token).value_or(0);
                     if (std::get<Terminal>(next_token) != EPSILON) {
                         std::string key =
                             QualName(std::get<Terminal>(next_token));
@@ -120,15 +131,15 @@ void ParserTables::BuildActionTable() {
 }
 
 void ParserTables::BuildGotoTable() {
-    for (size_t i = 0; i < states_.size(); ++i) {
+    for (size_t i = 0; i < automaton_.GetStates().size(); ++i) {
         for (const Token &token : g_.tokens_) {
             if (IsTerminal(token)) {
                 continue;
             }
             NonTerminal nt = std::get<NonTerminal>(token);
-            Automaton::State state = automaton_.Goto(states_.left.at(i), nt);
-            if (states_.right.find(state) != states_.right.end()) {
-                goto_[i][nt] = states_.right.at(state);
+            std::optional<size_t> next_state = automaton_.GetTransition(i, nt);
+            if (next_state.has_value()) {
+                goto_[i][nt] = next_state.value();
             }
         }
     }
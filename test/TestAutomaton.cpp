@@ -145,3 +145,52 @@ TEST_CASE("Automaton correctly computes goto", "[Automaton]") {
     );
     REQUIRE(goto_state.size() == 0);  // nonexistent transition
 }
+
+TEST_CASE("Automaton is rebuilt incrementally after an edit", "[Automaton]") {
+    std::string before = R"(
+        id = [a-z]+
+        num = [0-9]+
+        <program> = <stmts>
+        <stmts> = <stmt> <stmts> | EPSILON
+        <stmt> = <decl> ';' | <expr> ';' | '{' <stmts> '}'
+        <decl> = <type> id | <type> id '=' <expr>
+        <type> = 'int' | 'bool'
+        <expr> = <expr> '+' <term> | <term>
+        <term> = <term> '*' <factor> | <factor>
+        <factor> = '(' <expr> ')' | id | num
+    )";
+    auto edit = [&](const std::string &from, const std::string &to) {
+        std::string result = before;
+        result.replace(result.find(from), from.size(), to);
+        return result;
+    };
+    std::vector<std::string> edits = {
+        edit("'int' | 'bool'", "'bool' | 'char' | 'int'"),
+        edit("| id | num", "| num | id | '-' <factor>"),
+        edit("<stmt> <stmts> | EPSILON", "<stmt> <stmts> | <stmt>"),
+    };
+
+    GrammarParser gp(MakeStream(before));
+    gp.Parse();
+    Grammar g = gp.Get();
+    GrammarAnalyzer ga(g);
+    Automaton a(g, ga);
+    REQUIRE(a.GetReusedClosureCount() == 0);
+    for (const std::string &input : edits) {
+        GrammarParser edited_gp(MakeStream(input));
+        edited_gp.Parse();
+        Grammar edited = edited_gp.Get();
+        GrammarAnalyzer edited_ga(edited);
+        Automaton incremental(edited, edited_ga, a);
+        Automaton scratch(edited, edited_ga);
+        // rules that moved are renumbered, so the states are the same
+        REQUIRE(incremental.GetStates().size() == scratch.GetStates().size());
+        for (size_t i = 0; i < scratch.GetStates().size(); ++i) {
+            REQUIRE(
+                incremental.GetStates().left.at(i) ==
+                scratch.GetStates().left.at(i)
+            );
+        }
+        REQUIRE(incremental.GetReusedClosureCount() > 0);
+    }
+}
@@ -5,6 +5,7 @@
 #include <catch2/matchers/catch_matchers_string.hpp>
 
 #include "BNFParser.h"
+#include "Helpers.h"
 #include "TestHelpers.h"
 
 TEST_CASE("Correct parsing of a simple grammar", "[BNFParser]") {
@@ -35,6 +36,73 @@ TEST_CASE("IGNORE directive gets parsed correctly", "[BNFParser]") {
     REQUIRE(g.ignored_ == std::vector<std::string>({"\\t+", "\\s+"}));
 }
 
+TEST_CASE("GrammarParser collects warnings", "[BNFParser]") {
+    std::string input = R"(
+        EPSILON = [a-z]+
+        <S> = 'a'
+    )";
+    GrammarParser gp(MakeStream(input));
+    REQUIRE_NOTHROW(gp.Parse());
+    REQUIRE(gp.GetWarnings().size() == 1);
+    REQUIRE_THAT(
+        gp.GetWarnings()[0],
+        Catch::Matchers::ContainsSubstring("changing EPSILON is not allowed")
+    );
+}
+
+TEST_CASE("GrammarParser desugars EBNF operators", "[BNFParser]") {
+    std::string input = R"(
+        id = [a-z]+
+        <S> = '[' (id (',' id)*)? ']'
+        <T> = ('a' | 'b')+ 'c'?
+    )";
+    GrammarParser gp(MakeStream(input));
+    REQUIRE_NOTHROW(gp.Parse());
+    const Grammar &g = gp.Get();
+    NonTerminal list{"S.list1"};
+    NonTerminal opt{"S.opt2"};
+
+    // the start symbol is still that of the first rule
+    REQUIRE(g.rules_[1].lhs == NonTerminal{"S"});
+    REQUIRE(g.rules_[1].prod == Production{Terminal{"["}, opt, Terminal{"]"}});
+    // helper rules follow the rule they were made for, repetitions are
+    // left-recursive
+    REQUIRE(g.rules_[2].lhs == list);
+    REQUIRE(
+        g.rules_[2].prod ==
+        Production{list, Terminal{","}, Terminal{"id", " "}}
+    );
+    REQUIRE(g.rules_[3].prod == Production{EPSILON});
+    REQUIRE(g.rules_[4].prod == Production{Terminal{"id", " "}, list});
+    REQUIRE(g.rules_[5].prod == Production{EPSILON});
+    REQUIRE(g.rules_[6].lhs == NonTerminal{"T"});
+    // `+` has a base case of one element
+    REQUIRE(g.rules_.size() == 13);
+    REQUIRE(
+        g.rules_[8].prod == Production{NonTerminal{"T.list1"}, Terminal{"b"}}
+    );
+    REQUIRE(g.rules_[9].prod == Production{Terminal{"a"}});
+    REQUIRE(
+        g.lists_ ==
+        std::unordered_set<NonTerminal>{list, NonTerminal{"T.list1"}}
+    );
+}
+
+TEST_CASE("GrammarParser parses large grammars", "[BNFParser]") {
+    // every rule refers to one defined later, so each reference is resolved
+    // only once all of them are read
+    std::string input = "id = [a-z]+\n";
+    const size_t count = 20000;
+    for (size_t i = 0; i < count; ++i) {
+        input += "<n" + std::to_string(i) + "> = '(' <n" +
+                 std::to_string(i + 1) + "> ')' | id\n";
+    }
+    input += "<n" + std::to_string(count) + "> = EPSILON";
+    GrammarParser gp(MakeStream(input));
+    REQUIRE_NOTHROW(gp.Parse());
+    REQUIRE(gp.Get().rules_.size() == 2 * count + 2);
+}
+
 TEST_CASE("GrammarParser throws on empty grammar", "[BNFParserErrors]") {
     std::string input = R"()";
     GrammarParser gp(MakeStream(input));
@@ -153,6 +221,39 @@ TEST_CASE("GrammarParser throws on unterminated tokens", "[BNFParserErrors]") {
     }
 }
 
+TEST_CASE("GrammarParser throws on malformed EBNF", "[BNFParserErrors]") {
+    SECTION("Unterminated group") {
+        std::string input = R"(
+            <S> = ('a' 'b'
+        )";
+        GrammarParser gp(MakeStream(input));
+        REQUIRE_THROWS_WITH(
+            gp.Parse(), Catch::Matchers::ContainsSubstring("Unterminated `(`")
+        );
+    }
+
+    SECTION("Empty alternative") {
+        std::string input = R"(
+            <S> = ('a' | )*
+        )";
+        GrammarParser gp(MakeStream(input));
+        REQUIRE_THROWS_WITH(
+            gp.Parse(), Catch::Matchers::ContainsSubstring("Empty alternative")
+        );
+    }
+
+    SECTION("Repeated epsilon") {
+        std::string input = R"(
+            <S> = ('a' | EPSILON)+
+        )";
+        GrammarParser gp(MakeStream(input));
+        REQUIRE_THROWS_WITH(
+            gp.Parse(),
+            Catch::Matchers::ContainsSubstring("Can't repeat an empty")
+        );
+    }
+}
+
 TEST_CASE(
     "GrammarParser throws an error on unexpected EOL/EOF", "[BNFParserErrors]"
 ) {
@@ -0,0 +1,119 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "CodePointSet.h"
+
+namespace {
+// whether the bytes match one of the sequences
+bool MatchesSequences(
+    const std::vector<CodePointSet::ByteSequence> &sequences,
+    const std::string &bytes
+) {
+    size_t matches = 0;
+    for (const CodePointSet::ByteSequence &sequence : sequences) {
+        if (sequence.size() != bytes.size()) {
+            continue;
+        }
+        bool match = true;
+        for (size_t i = 0; i < bytes.size(); ++i) {
+            auto b = static_cast<uint8_t>(bytes[i]);
+            match = match && sequence[i].first <= b && b <= sequence[i].second;
+        }
+        matches += match;
+    }
+    // the sequences are disjoint
+    REQUIRE(matches <= 1);
+    return matches == 1;
+}
+}  // namespace
+
+TEST_CASE("CodePointSet encodes and decodes UTF-8", "[CodePointSet]") {
+    SECTION("Round trip") {
+        for (char32_t c : {0x0u, 0x41u, 0x7Fu, 0x80u, 0x416u, 0x7FFu, 0x800u,
+                           0x2192u, 0xD7FFu, 0xE000u, 0xFFFFu, 0x10000u,
+                           0x1F600u, 0x10FFFFu}) {
+            std::string bytes = CodePointSet::EncodeUtf8(c);
+            size_t pos = 0;
+            REQUIRE(CodePointSet::DecodeUtf8(bytes, pos) == c);
+            REQUIRE(pos == bytes.size());
+        }
+        REQUIRE(CodePointSet::EncodeUtf8(0x416) == "\xD0\x96");
+        REQUIRE(CodePointSet::EncodeUtf8(0x1F600) == "\xF0\x9F\x98\x80");
+    }
+
+    SECTION("Invalid encodings are rejected") {
+        for (std::string bytes :
+             {"\x80", "\xC0\x80", "\xC1\xBF", "\xD0", "\xE0\x80\x80",
+              "\xED\xA0\x80", "\xF0\x8F\xBF\xBF", "\xF4\x90\x80\x80",
+              "\xF5\x80\x80\x80", "\xFF", "\xE2\x86"}) {
+            size_t pos = 0;
+            REQUIRE_FALSE(CodePointSet::DecodeUtf8(bytes, pos));
+            REQUIRE(pos == 0);
+        }
+    }
+}
+
+TEST_CASE("CodePointSet keeps sorted disjoint ranges", "[CodePointSet]") {
+    CodePointSet set;
+    set.Add(0x30, 0x39);
+    set.Add(0x41, 0x5A);
+    set.Add(0x3A, 0x40);
+    set.Add(0xD000, 0xE000);
+    REQUIRE(
+        set.GetRanges() == std::vector<CodePointSet::Range>{
+                               {0x30, 0x5A}, {0xD000, 0xD7FF}, {0xE000, 0xE000}}
+    );
+    REQUIRE(set.Contains(0x40));
+    REQUIRE_FALSE(set.Contains(0xD800));
+
+    set.Negate();
+    REQUIRE(set.Contains(0x2F));
+    REQUIRE_FALSE(set.Contains(0x30));
+    REQUIRE_FALSE(set.Contains(0xD800));
+    REQUIRE(set.Contains(0x10FFFF));
+    set.Negate();
+    REQUIRE(set.GetRanges().size() == 3);
+
+    SECTION("Properties") {
+        CodePointSet letters = *CodePointSet::FromProperty("L");
+        REQUIRE(letters.Contains(U'a'));
+        REQUIRE(letters.Contains(U'Ж'));
+        REQUIRE(letters.Contains(U'ё'));
+        REQUIRE_FALSE(letters.Contains(U'1'));
+        REQUIRE_FALSE(letters.Contains(U'→'));
+        REQUIRE(CodePointSet::FromProperty("Lu")->Contains(U'Ж'));
+        REQUIRE_FALSE(CodePointSet::FromProperty("Lu")->Contains(U'ж'));
+        REQUIRE(CodePointSet::FromProperty("Nd")->Contains(U'٣'));
+        REQUIRE(CodePointSet::FromProperty("Z")->Contains(0x3000));
+        REQUIRE_FALSE(CodePointSet::FromProperty("ASCII")->Contains(0x80));
+        REQUIRE_FALSE(CodePointSet::FromProperty("Greek"));
+    }
+}
+
+TEST_CASE("CodePointSet splits into UTF-8 byte sequences", "[CodePointSet]") {
+    std::vector<CodePointSet> sets(4);
+    sets[0].Add(0x0, CodePointSet::kMaxCodePoint);
+    sets[1].Add(0x430, 0x44F);
+    sets[1].Add(0x451, 0x451);
+    sets[2].Add(0x7F, 0x801);
+    sets[2].Add(0xFFF0, 0x10010);
+    sets[3] = *CodePointSet::FromProperty("L");
+
+    for (const CodePointSet &set : sets) {
+        std::vector<CodePointSet::ByteSequence> sequences = set.ToUtf8Sequences();
+        for (char32_t c = 0; c <= CodePointSet::kMaxCodePoint; ++c) {
+            if (c >= 0xD800 && c <= 0xDFFF) {
+                continue;
+            }
+            if (MatchesSequences(sequences, CodePointSet::EncodeUtf8(c)) !=
+                set.Contains(c)) {
+                FAIL("U+" << std::hex << static_cast<uint32_t>(c));
+            }
+        }
+        // surrogates and overlong forms are never matched
+        REQUIRE_FALSE(MatchesSequences(sequences, "\xED\xA0\x80"));
+        REQUIRE_FALSE(MatchesSequences(sequences, "\xC0\x80"));
+        REQUIRE_FALSE(MatchesSequences(sequences, "\xE0\x80\x80"));
+    }
+}
@@ -0,0 +1,305 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "Automaton.h"
+#include "BNFParser.h"
+#include "CompiledGrammar.h"
+#include "GrammarEngine.h"
+#include "TableBuilder.h"
+#include "TestHelpers.h"
+
+namespace {
+constexpr std::string_view kExpressions = R"(
+    id = [a-z]+
+    <E> = <E> '+' <T> | <T>
+    <T> = <T> '*' <F> | <F>
+    <F> = '(' <E> ')' | id
+)";
+
+constexpr auto kGrammar = pargen::compile(kExpressions);
+using Tables = pargen::CompiledTables<kGrammar>;
+using Parser = pargen::LRParser<Tables>;
+
+static_assert(kGrammar.terminal_count == 6);
+static_assert(kGrammar.nonterminal_count == 4);
+static_assert(kGrammar.rule_count == 7);
+static_assert(kGrammar.TerminalKind("id") == 1);
+static_assert(kGrammar.NonTerminalKind("F") == 3);
+
+// Every letter is an `id`, anything else a quote terminal.
+Tables::TokenStream Lex(std::string_view source) {
+    std::vector<Tables::Terminal> tokens;
+    for (size_t i = 0; i < source.size(); ++i) {
+        std::string_view lexeme = source.substr(i, 1);
+        if (lexeme == " ") {
+            continue;
+        }
+        bool id = lexeme[0] >= 'a' && lexeme[0] <= 'z';
+        tokens.push_back(
+            Tables::Terminal{kGrammar.TerminalKind(id ? "id" : lexeme), lexeme}
+        );
+    }
+    return Tables::TokenStream(std::move(tokens), source);
+}
+
+// Whether the generator accepts the grammar, and how many states it builds.
+std::pair<bool, size_t> Generate(const std::string &input) {
+    GrammarParser gp(MakeStream(input));
+    gp.Parse();
+    Grammar g = gp.Get();
+    GrammarAnalyzer ga(g);
+    size_t states = Automaton(g, ga).GetStates().size();
+    ParserTables tables(g, ga);
+    try {
+        tables.Generate();
+    } catch (const TableGeneratorError &) {
+        return {false, states};
+    }
+    return {true, states};
+}
+
+// Copies of example grammars in plain BNF, which compile takes; the test
+// checks they are up to date.
+constexpr std::string_view kMath = R"(id = [0-9]+
+IGNORE = \s+
+<S> = <E>
+<F> = '(' <E> ')' | id
+<E> = <E> '+' <T> | <T>
+<T> = <T> '*' <F> | <F>)";
+
+constexpr std::string_view kSql = R"(id = [a-zA-Z_][a-zA-Z0-9_]*
+num = [0-9]+
+string = \"[^\"]*\"
+IGNORE = \s+
+
+<S> = <query>
+<query> = 'SELECT' <columns> 'FROM' id <where_clause>
+<columns> = '*' | id <column_list>
+<column_list> = ',' id <column_list> | EPSILON
+<where_clause> = 'WHERE' <condition> | EPSILON
+<condition> = id '=' <value>
+<value> = num | string
+)";
+
+constexpr std::string_view kJsLike = R"(number = [0-9]+
+identifier = [a-zA-Z][a-zA-Z0-9]*
+IGNORE = \s+
+
+<Program> = <FunctionDecl> <Program> | <StatementList>
+<StatementList> = <Statement> <StatementList> | EPSILON
+<Statement> = <Assignment> | <FunctionCall> | <IfStatement> | <WhileStatement>
+<Assignment> = 'let' identifier '=' <Expression> ';'
+<FunctionCall> = identifier '(' <Expression> ')' ';'
+<IfStatement> = 'if' '(' <Expression> ')' '{' <StatementList> '}' 'else' '{' <StatementList> '}'
+<WhileStatement> = 'while' '(' <Expression> ')' '{' <StatementList> '}'
+<Expression> = <Term> <ExpressionTail>
+<ExpressionTail> = '+' <Term> <ExpressionTail> | '-' <Term> <ExpressionTail> | EPSILON
+<Term> = <Factor> <TermTail>
+<TermTail> = '*' <Factor> <TermTail> | '/' <Factor> <TermTail> | EPSILON
+<Factor> = '(' <Expression> ')' | number | identifier
+<FunctionDecl> = 'function' identifier '(' ')' '{' <FunctionBody> '}'
+<FunctionBody> = <StatementList> | <StatementList> 'return' <Expression> ';')";
+
+constexpr auto kMathGrammar = pargen::compile(kMath);
+constexpr auto kSqlGrammar = pargen::compile(kSql);
+constexpr auto kJsLikeGrammar = pargen::compile<256>(kJsLike);
+
+std::string ReadExample(const std::string &name) {
+    std::ifstream in(SOURCE_DIR "/example_grammars/" + name);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// A tree in preorder, by the names of the symbols.
+template <class Node, class Names>
+void DumpNode(const Node &node, const Names &names, std::string &out) {
+    if (std::holds_alternative<typename Node::Terminal>(node.value)) {
+        const auto &t = std::get<typename Node::Terminal>(node.value);
+        out += names.Terminal(t.kind) + "`" + std::string(t.repr) + "` ";
+        return;
+    }
+    out += "<" + names.NonTerminal(std::get<typename Node::NonTerminal>(node.value).kind) + "> ";
+    for (const auto &child : node.children) {
+        DumpNode(*child, names, out);
+    }
+    out += "; ";
+}
+
+// Lexes `source` with GrammarEngine, parses it with the engine and with the
+// parser of the compiled tables, and requires the same status and tree.
+template <const auto &Compiled>
+void RequireSameParse(const GrammarEngine &engine, std::string_view source) {
+    using Tables = pargen::CompiledTables<Compiled>;
+    struct EngineNames {
+        const GrammarEngine &engine;
+        std::string Terminal(uint32_t kind) const {
+            return engine.GetTerminalName(kind);
+        }
+        std::string NonTerminal(uint32_t kind) const {
+            return engine.GetNonTerminalName(kind);
+        }
+    };
+    struct CompiledNames {
+        std::string Terminal(uint32_t kind) const {
+            return std::string(Compiled.terminal_names[kind]);
+        }
+        std::string NonTerminal(uint32_t kind) const {
+            return std::string(Compiled.nonterminal_names[kind]);
+        }
+    };
+
+    INFO(std::string(source));
+    std::vector<GrammarEngine::Terminal> tokens = engine.Lex(source);
+    std::vector<typename Tables::Terminal> compiled_tokens;
+    for (const GrammarEngine::Terminal &token : tokens) {
+        compiled_tokens.push_back(typename Tables::Terminal{
+            Compiled.TerminalKind(engine.GetTerminalName(token.kind)), token.repr
+        });
+    }
+    GrammarEngine::Parser engine_parser = engine.CreateParser();
+    pargen::LRParser<Tables> compiled_parser;
+    int status = engine_parser.Parse(tokens);
+    REQUIRE(compiled_parser.Parse(compiled_tokens) == status);
+    std::string expected;
+    std::string actual;
+    if (auto root = engine_parser.GetParseTree().GetRoot()) {
+        DumpNode(*root, EngineNames{engine}, expected);
+    }
+    if (auto root = compiled_parser.GetParseTree().GetRoot()) {
+        DumpNode(*root, CompiledNames{}, actual);
+    }
+    REQUIRE(actual == expected);
+}
+}  // namespace
+
+TEST_CASE("Compiled tables drive LRParser", "[CompiledGrammar]") {
+    Parser parser;
+    REQUIRE(parser.Parse(Lex("a + b * (c + d)")) == 0);
+    pargen::ParseTree<Tables> tree = parser.GetParseTree();
+    REQUIRE(tree.GetRoot()->width == 9);
+    const auto &root = std::get<Tables::NonTerminal>(tree.GetRoot()->value);
+    REQUIRE(root.Name() == "E");
+    // E -> E '+' T
+    const auto &plus = std::get<Tables::Terminal>(tree.GetRoot()->children[1]->value);
+    REQUIRE(plus.Name() == "+");
+    REQUIRE(plus.IsQuote());
+
+    REQUIRE(parser.Parse(Lex("a + * b")) != 0);
+    REQUIRE(parser.Parse(Lex("(a")) < 0);
+}
+
+TEST_CASE("Compiled tables match the generator", "[CompiledGrammar]") {
+    std::vector<std::string> grammars = {
+        std::string(kExpressions),
+        R"(
+            int = [0-9]+
+            <S> = <T> <E>
+            <E> = '+' <T> <E> | EPSILON
+            <T> = int
+        )",
+        R"(
+            str = "[^"]*"
+            <value> = <object> | <array> | str
+            <object> = '{' '}' | '{' <members> '}'
+            <members> = <pair> | <pair> ',' <members>
+            <pair> = str ':' <value>
+            <array> = '[' ']' | '[' <elements> ']'
+            <elements> = <value> | <value> ',' <elements>
+        )",
+        R"(
+            <S> = <L> '=' <R> | <R>
+            <L> = '*' <R> | 'x'
+            <R> = <L>
+        )",
+        R"(
+            a = 'a'
+            <S> = <A> | <B>
+            <A> = a | EPSILON
+            <B> = a | EPSILON
+        )",
+        R"(
+            <E> = <E> '+' <E> | 'x'
+        )",
+    };
+    for (const std::string &input : grammars) {
+        auto [accepted, states] = Generate(input);
+        if (accepted) {
+            auto g = pargen::compile(input);
+            REQUIRE(g.state_count == states);
+        } else {
+            REQUIRE_THROWS_AS(pargen::compile(input), pargen::CompileError);
+        }
+    }
+}
+
+TEST_CASE("compile reports malformed grammars", "[CompiledGrammar]") {
+    for (std::string_view input : {
+             "",
+             "<S> = <A>",
+             "<S> = x",
+             "<S> = 'a' EPSILON",
+             "<S> = 'a",
+             "<S = 'a'",
+             "'a' = 'b'",
+         }) {
+        REQUIRE_THROWS_AS(pargen::compile(input), pargen::CompileError);
+    }
+    REQUIRE_THROWS_AS(pargen::compile<4>(kExpressions), pargen::CompileError);
+    REQUIRE_THROWS_AS(kGrammar.TerminalKind("-"), pargen::CompileError);
+}
+
+TEST_CASE("compile builds the parser GrammarEngine does on the examples", "[CompiledGrammar]") {
+    REQUIRE(ReadExample("simple_math_expressions.bnf") == kMath);
+    REQUIRE(ReadExample("sql_subset.bnf") == kSql);
+    REQUIRE(ReadExample("js_like.bnf") == kJsLike);
+
+    GrammarEngine math(std::string{kMath});
+    for (std::string_view source : {"1", "1 + 2 * (3 + 4) * 5", "((1))", "1 + * 2", "(1 + 2"}) {
+        RequireSameParse<kMathGrammar>(math, source);
+    }
+
+    GrammarEngine sql(std::string{kSql});
+    for (std::string_view source : {
+             "SELECT * FROM t",
+             "SELECT a, b, c FROM t WHERE a = 1",
+             "SELECT a FROM t WHERE b = \"x\"",
+             "SELECT a, FROM t",
+             "SELECT a FROM WHERE a = 1",
+         }) {
+        RequireSameParse<kSqlGrammar>(sql, source);
+    }
+
+    GrammarEngine js_like(std::string{kJsLike});
+    for (std::string_view source : {
+             "",
+             "let x = 1 + 2 * (y - 3) / z;",
+             "function f() { let a = 1; return a + 1; } f(2);",
+             "function g() { } if (x) { print(x); } else { while (y) { y(1); } }",
+             "let = 1; let y = 2;",
+             "if (x) { f(1); }",
+         }) {
+        RequireSameParse<kJsLikeGrammar>(js_like, source);
+    }
+}
+
+TEST_CASE("compile rejects grammars outside its subset", "[CompiledGrammar]") {
+    std::string json = ReadExample("json_subset.bnf");
+    REQUIRE_THROWS_WITH(
+        pargen::compile(json),
+        "EBNF operators are not supported by compile; write repetitions as "
+        "recursive rules"
+    );
+    REQUIRE_THROWS_WITH(
+        pargen::compile(kJsLike), "The grammar has more states than MaxStates"
+    );
+    REQUIRE_THROWS_WITH(
+        (pargen::compile<256, 8>(kJsLike)), "The grammar has more terminals than MaxTerminals"
+    );
+}
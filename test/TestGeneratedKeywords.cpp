@@ -0,0 +1,119 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "GrammarEngine.h"
+#include "keywords/Parser.hpp"
+
+// The parser of test/grammars/keywords.bnf, generated at build time. It has
+// enough keywords for its DFA to outgrow the limit on which the generated lexer
+// lexes them as identifiers and tells them apart by a hash table.
+namespace keywords = generated::keywords;
+
+namespace {
+class KeywordsFixture {
+public:
+    KeywordsFixture() : engine_(ReadGrammar()) {
+        // the quote terminals of the <keyword> rules
+        std::istringstream grammar(ReadGrammar());
+        std::string line;
+        while (std::getline(grammar, line)) {
+            if (!line.starts_with("<keyword> =")) {
+                continue;
+            }
+            for (size_t end = 0;;) {
+                size_t begin = line.find('\'', end);
+                if (begin == std::string::npos) {
+                    break;
+                }
+                end = line.find('\'', begin + 1) + 1;
+                words_.push_back(line.substr(begin + 1, end - begin - 2));
+            }
+        }
+    }
+
+    // Lexes `source` with the generated lexer and with GrammarEngine, whose DFA
+    // has all the keywords in it, and requires the same tokens.
+    void RequireSameTokens(std::string_view source) const {
+        std::vector<keywords::Terminal> tokens = keywords::Lex(source);
+        std::vector<GrammarEngine::Terminal> expected = engine_.Lex(source);
+        REQUIRE(tokens.size() == expected.size());
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            INFO(std::string(expected[i].repr));
+            REQUIRE(tokens[i].kind == expected[i].kind);
+            REQUIRE(tokens[i].repr.data() == expected[i].repr.data());
+            REQUIRE(tokens[i].repr.size() == expected[i].repr.size());
+        }
+    }
+
+    const std::vector<std::string> &GetWords() const {
+        return words_;
+    }
+
+private:
+    static std::string ReadGrammar() {
+        std::ifstream in(SOURCE_DIR "/test/grammars/keywords.bnf");
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    GrammarEngine engine_;
+    std::vector<std::string> words_;
+};
+}  // namespace
+
+TEST_CASE_METHOD(KeywordsFixture, "Generated lexer tells keywords from identifiers", "[GeneratedKeywords]") {
+    REQUIRE(GetWords().size() > 400);
+    for (const std::string &word : GetWords()) {
+        // at the end of input, hashed byte by byte, and followed by more input,
+        // hashed by 8-byte loads
+        RequireSameTokens(word);
+        RequireSameTokens(word + " " + std::string(16, 'x'));
+        RequireSameTokens("(" + word + ");");
+        // words one byte off a keyword, longer keywords included
+        RequireSameTokens(word + "D " + word + "S " + word + "_1");
+        RequireSameTokens(word.substr(0, word.size() - 1) + " " + word.substr(1));
+        std::string other_case = word;
+        other_case[0] += 'a' - 'A';
+        RequireSameTokens(other_case + ";");
+        std::string last_changed = word;
+        last_changed.back() = last_changed.back() == 'Z' ? 'A' : last_changed.back() + 1;
+        RequireSameTokens(last_changed + " " + word);
+    }
+    RequireSameTokens("SELECT SELECTED SELEC AUTHORIZATION AUTHORIZATIONS CHARACTERISTICS");
+}
+
+TEST_CASE_METHOD(KeywordsFixture, "Generated lexer lexes random words like GrammarEngine", "[GeneratedKeywords]") {
+    std::mt19937 rng(36);
+    const std::vector<std::string> &words = GetWords();
+    for (int i = 0; i < 200; ++i) {
+        std::string source;
+        for (size_t k = rng() % 200; k > 0; --k) {
+            std::string word = words[rng() % words.size()];
+            switch (rng() % 5) {
+                case 0:
+                    word.pop_back();
+                    break;
+                case 1:
+                    word += static_cast<char>('A' + rng() % 26);
+                    break;
+                case 2:
+                    word = std::to_string(rng() % 1000);
+                    break;
+            }
+            source += word;
+            source += rng() % 3 == 0 ? ";" : rng() % 2 ? " ; " : "\n\t;";
+        }
+        RequireSameTokens(source);
+
+        keywords::Parser parser;
+        REQUIRE(parser.Parse(keywords::Lex(source)) == 0);
+    }
+}
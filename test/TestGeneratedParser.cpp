@@ -0,0 +1,490 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "GrammarEngine.h"
+#include "json/Parser.hpp"
+
+// The parser of example_grammars/json_subset.bnf, generated at build time with
+// --parallel-lexer and --utf8.
+namespace json = generated::json;
+
+namespace {
+std::string ReadGrammar() {
+    std::ifstream in(SOURCE_DIR "/example_grammars/json_subset.bnf");
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// A random document of about `size` bytes. It has long runs of whitespace and
+// long strings, so that the vectorized scans cross their blocks, multi-line
+// strings, so that the parallel lexer sometimes guesses wrong, and non-ASCII
+// text.
+class DocumentMaker {
+public:
+    explicit DocumentMaker(unsigned seed) : rng_(seed) {}
+
+    std::string Make(size_t size) {
+        std::string document = "[";
+        Value(document, 0);
+        while (document.size() < size) {
+            document += ",";
+            Space(document);
+            Value(document, 0);
+        }
+        document += "]\n";
+        return document;
+    }
+
+private:
+    void Space(std::string &out) {
+        switch (rng_() % 6) {
+            case 0:
+                out += "\n";
+                break;
+            case 1:
+                out += std::string(20 + rng_() % 50, ' ');
+                break;
+            case 2:
+                out += "\t\n  ";
+                break;
+            default:
+                out += " ";
+        }
+    }
+
+    void String(std::string &out) {
+        static const char *kPieces[] = {"a", "key", " ", "\n", "ё", "→", "{[,:]}", "0"};
+        out += "\"";
+        size_t count = rng_() % 4 == 0 ? 40 + rng_() % 60 : rng_() % 6;
+        for (size_t i = 0; i < count; ++i) {
+            out += kPieces[rng_() % std::size(kPieces)];
+        }
+        out += "\"";
+    }
+
+    void Value(std::string &out, size_t depth) {
+        size_t kind = depth > 4 ? rng_() % 2 : rng_() % 4;
+        if (kind == 0) {
+            out += (rng_() % 3 == 0 ? "-" : "") + std::to_string(rng_() % 100000);
+            if (rng_() % 2 == 0) {
+                out += "." + std::to_string(rng_() % 1000);
+            }
+        } else if (kind == 1) {
+            String(out);
+        } else {
+            bool object = kind == 2;
+            out += object ? "{" : "[";
+            size_t count = 1 + rng_() % 4;
+            for (size_t i = 0; i < count; ++i) {
+                if (i > 0) {
+                    out += ",";
+                }
+                Space(out);
+                if (object) {
+                    String(out);
+                    out += ":";
+                    Space(out);
+                }
+                Value(out, depth + 1);
+            }
+            out += object ? "}" : "]";
+        }
+    }
+
+    std::mt19937 rng_;
+};
+
+// The symbols of a tree in preorder, with the positions of the lexemes in
+// `source`.
+class DumpVisitor : public json::ParseTreePreorderVisitor {
+public:
+    explicit DumpVisitor(std::string_view source) : source_(source) {}
+
+    void VisitTerminal(const json::Terminal &t) override {
+        dump += "t" + std::to_string(t.kind) + "@" +
+                std::to_string(t.repr.data() - source_.data()) + "+" +
+                std::to_string(t.repr.size()) + " ";
+    }
+    void VisitNonTerminal(const json::NonTerminal &nt) override {
+        dump += "n" + std::to_string(nt.kind) + " ";
+    }
+
+    std::string dump;
+
+private:
+    std::string_view source_;
+};
+
+std::string Dump(const json::ParseTree &tree, std::string_view source) {
+    DumpVisitor visitor(source);
+    tree.Accept(visitor);
+    return visitor.dump;
+}
+
+std::string Parse(std::string_view source) {
+    json::Parser parser;
+    REQUIRE(parser.Parse(json::Lex(source)) == 0);
+    return Dump(parser.GetParseTree(), source);
+}
+
+template <class Tokens>
+void RequireSameTokens(const Tokens &actual, const std::vector<json::Terminal> &expected) {
+    REQUIRE(actual.size() == expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        json::Terminal token = actual[i];
+        REQUIRE(token.kind == expected[i].kind);
+        REQUIRE(token.repr.data() == expected[i].repr.data());
+        REQUIRE(token.repr.size() == expected[i].repr.size());
+    }
+}
+
+// Whether `source` is valid UTF-8, decoding code points one at a time.
+size_t FindInvalidUtf8Reference(std::string_view source) {
+    const auto *bytes = reinterpret_cast<const unsigned char *>(source.data());
+    size_t i = 0;
+    while (i < source.size()) {
+        unsigned char c = bytes[i];
+        size_t length = c < 0x80 ? 1 : c >> 5 == 0x6 ? 2 : c >> 4 == 0xE ? 3 : c >> 3 == 0x1E ? 4 : 0;
+        if (length == 0 || source.size() - i < length) {
+            return i;
+        }
+        uint32_t code_point = length == 1 ? c : c & (0x7F >> length);
+        for (size_t k = 1; k < length; ++k) {
+            if ((bytes[i + k] & 0xC0) != 0x80) {
+                return i;
+            }
+            code_point = code_point << 6 | (bytes[i + k] & 0x3F);
+        }
+        static constexpr uint32_t kMinCodePoint[] = {0, 0, 0x80, 0x800, 0x10000};
+        if (code_point < kMinCodePoint[length] || code_point > 0x10FFFF ||
+            (code_point >= 0xD800 && code_point <= 0xDFFF)) {
+            return i;
+        }
+        i += length;
+    }
+    return std::string_view::npos;
+}
+}  // namespace
+
+TEST_CASE("Generated lexer lexes like GrammarEngine", "[GeneratedParser]") {
+    GrammarEngine engine(ReadGrammar());
+    for (unsigned seed = 0; seed < 20; ++seed) {
+        std::string source = DocumentMaker(seed).Make(20000);
+        std::vector<json::Terminal> tokens = json::Lex(source);
+        std::vector<GrammarEngine::Terminal> expected = engine.Lex(source);
+        REQUIRE(tokens.size() == expected.size());
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            REQUIRE(tokens[i].kind == expected[i].kind);
+            REQUIRE(tokens[i].repr.data() == expected[i].repr.data());
+            REQUIRE(tokens[i].repr.size() == expected[i].repr.size());
+        }
+
+        // the same tokens through every entry point
+        json::Lexer lexer(source);
+        std::vector<json::Terminal> pulled;
+        json::Terminal token;
+        while (lexer.Next(token)) {
+            pulled.push_back(token);
+        }
+        REQUIRE(lexer.GetPosition() == source.size());
+        RequireSameTokens(pulled, tokens);
+        RequireSameTokens(json::Lex(source.data(), source.size()), tokens);
+
+        json::TokenStream packed = json::LexPacked(source);
+        RequireSameTokens(packed, tokens);
+    }
+}
+
+TEST_CASE("Generated parallel lexer lexes like Lex", "[GeneratedParser]") {
+    for (unsigned seed = 0; seed < 3; ++seed) {
+        std::string source = DocumentMaker(seed).Make(1 << 20);
+        std::vector<json::Terminal> tokens = json::Lex(source);
+        for (size_t threads : {1, 2, 3, 8}) {
+            RequireSameTokens(json::LexParallel(source, threads), tokens);
+            RequireSameTokens(json::LexPackedParallel(source, threads), tokens);
+        }
+    }
+}
+
+TEST_CASE("Generated lexer reports bytes no rule matches", "[GeneratedParser]") {
+    REQUIRE_THROWS_WITH(json::Lex("{\"a\": 1.}"), "No token matches the input at 1:8");
+    REQUIRE_THROWS_WITH(json::LexPacked("[1,\n @]"), "No token matches the input at 2:2");
+
+    json::Parser parser;
+    json::Lexer lexer("[1, 2, \"x]");
+    REQUIRE_THROWS_AS(parser.Parse(lexer), json::LexerError);
+
+    // an error deep in a chunk is reported just like by Lex
+    std::string source = DocumentMaker(1).Make(1 << 20);
+    source[source.size() / 2] = '@';
+    source[source.size() / 2 + 1000] = '@';
+    std::string error;
+    try {
+        json::Lex(source);
+    } catch (const json::LexerError &e) {
+        error = e.what();
+    }
+    REQUIRE_FALSE(error.empty());
+    REQUIRE_THROWS_WITH(json::LexParallel(source, 8), error);
+}
+
+TEST_CASE("Generated parser parses from every source alike", "[GeneratedParser]") {
+    // one parser, reused with its stacks warm, for all the inputs
+    json::Parser parser;
+    std::vector<std::string> sources;
+    std::vector<json::ParseTree> trees;
+    for (unsigned seed = 0; seed < 10; ++seed) {
+        sources.push_back(DocumentMaker(seed).Make(5000 + seed * 3000));
+    }
+    for (const std::string &source : sources) {
+        std::string expected = Parse(source);
+
+        REQUIRE(parser.Parse(json::Lex(source)) == 0);
+        trees.push_back(parser.GetParseTree());
+        REQUIRE(Dump(trees.back(), source) == expected);
+
+        REQUIRE(parser.Parse(json::LexPacked(source)) == 0);
+        REQUIRE(Dump(parser.GetParseTree(), source) == expected);
+
+        json::Lexer lexer(source);
+        REQUIRE(parser.Parse(lexer) == 0);
+        REQUIRE(Dump(parser.GetParseTree(), source) == expected);
+    }
+    // the trees stay valid after later parses
+    for (size_t i = 0; i < sources.size(); ++i) {
+        REQUIRE(Dump(trees[i], sources[i]) == Parse(sources[i]));
+    }
+    // and so does the parser after an error
+    REQUIRE(parser.Parse(json::Lex("[1, , 2]")) != 0);
+    REQUIRE(parser.Parse(json::Lex(sources[0])) == 0);
+    REQUIRE(Dump(parser.GetParseTree(), sources[0]) == Parse(sources[0]));
+}
+
+TEST_CASE("Generated lexer and parser handle edits", "[GeneratedParser]") {
+    static const char *kPieces[] = {" ", "\n", "7", "\"x y\"", ", 1", "[", "]", "{\"k\": 2}"};
+    std::mt19937 rng(7);
+    std::string source = DocumentMaker(7).Make(3000);
+    std::vector<json::Terminal> tokens = json::Lex(source);
+    json::TokenStream packed = json::LexPacked(source);
+    json::Parser parser;
+    REQUIRE(parser.Parse(tokens) == 0);
+    json::ParseTree tree = parser.GetParseTree();
+    size_t applied = 0;
+    for (int step = 0; step < 400; ++step) {
+        size_t start = rng() % (source.size() + 1);
+        size_t removed = std::min<size_t>(rng() % 4, source.size() - start);
+        std::string inserted = kPieces[rng() % std::size(kPieces)];
+        std::string edited = source;
+        edited.replace(start, removed, inserted);
+        json::TextEdit edit{start, removed, inserted.size()};
+
+        std::vector<json::Terminal> expected;
+        std::vector<json::Terminal> next_tokens = tokens;
+        json::TokenStream next_packed = packed;
+        try {
+            expected = json::Lex(edited);
+        } catch (const json::LexerError &) {
+            // e.g. a quote was removed; the tokens are left as they were
+            REQUIRE_THROWS_AS(json::Relex(next_tokens, source, edited, edit), json::LexerError);
+            REQUIRE_THROWS_AS(json::Relex(next_packed, edited, edit), json::LexerError);
+            RequireSameTokens(next_tokens, tokens);
+            RequireSameTokens(next_packed, tokens);
+            continue;
+        }
+        json::TokenEdit token_edit = json::Relex(next_tokens, source, edited, edit);
+        json::TokenEdit packed_edit = json::Relex(next_packed, edited, edit);
+        REQUIRE(packed_edit.start == token_edit.start);
+        REQUIRE(packed_edit.removed == token_edit.removed);
+        REQUIRE(packed_edit.inserted == token_edit.inserted);
+        RequireSameTokens(next_tokens, expected);
+        RequireSameTokens(next_packed, expected);
+
+        json::Parser fresh;
+        if (fresh.Parse(expected) != 0) {
+            continue;
+        }
+        REQUIRE(parser.Reparse(next_tokens, tree, token_edit) == 0);
+        REQUIRE(Dump(parser.GetParseTree(), edited) == Dump(fresh.GetParseTree(), edited));
+        REQUIRE(parser.Reparse(next_packed, tree, token_edit) == 0);
+        REQUIRE(Dump(parser.GetParseTree(), edited) == Dump(fresh.GetParseTree(), edited));
+
+        // the edit is kept; the buffer of a moved string stays in place, so the
+        // tokens and the tree still point into it
+        tree = parser.GetParseTree();
+        tokens = std::move(next_tokens);
+        packed = std::move(next_packed);
+        source = std::move(edited);
+        ++applied;
+    }
+    REQUIRE(applied > 50);
+
+    // the records after the last edit are kept apart; the rest of the stream
+    // works on them like on the others
+    json::TokenStream appended(source);
+    appended.Append(packed, 0);
+    RequireSameTokens(appended, tokens);
+    appended.push_back(tokens.front());
+    REQUIRE(appended.size() == tokens.size() + 1);
+    REQUIRE(appended[tokens.size()].repr.data() == tokens.front().repr.data());
+    packed.SetSource(source);
+    RequireSameTokens(packed, tokens);
+}
+
+TEST_CASE("Generated parser rebuilds a list spanning an edit from its elements", "[GeneratedParser]") {
+    std::string source = "[";
+    for (int i = 0; i < 100; ++i) {
+        source += (i > 0 ? ", " : "") + std::string("{\"k\": ") + std::to_string(i) + "}";
+    }
+    source += "]";
+    json::TokenStream tokens = json::LexPacked(source);
+    json::Parser parser;
+    REQUIRE(parser.Parse(tokens) == 0);
+    json::ParseTree tree = parser.GetParseTree();
+
+    // <array> = '[' <value> <array.list1> ']', the list being ',' <value> ...
+    auto list_of = [](const json::ParseTree &tree) {
+        return tree.GetRoot()->children[0]->children[0]->children[2];
+    };
+    std::shared_ptr<json::ParseTreeNode> list = list_of(tree);
+    REQUIRE(list->children.size() == 2 * 99);
+
+    std::string edited = source;
+    size_t at = edited.find(": 50}") + 4;
+    edited.insert(at, "0");
+    json::TokenEdit edit = json::Relex(tokens, edited, json::TextEdit{at, 0, 1});
+    REQUIRE(parser.Reparse(tokens, tree, edit) == 0);
+    std::shared_ptr<json::ParseTreeNode> reparsed = list_of(parser.GetParseTree());
+    REQUIRE(Dump(parser.GetParseTree(), edited) == Parse(edited));
+
+    // the list is a new node, built of the elements of the previous one but
+    // the edited one; those are moved into the new buffer by copies of their
+    // nodes only, sharing the nodes below
+    REQUIRE(reparsed != list);
+    REQUIRE(reparsed->children.size() == list->children.size());
+    for (size_t i = 1; i < list->children.size(); i += 2) {
+        const auto &before = list->children[i];
+        const auto &after = reparsed->children[i];
+        if ((i + 1) / 2 == 50) {
+            REQUIRE(after->children != before->children);
+        } else {
+            REQUIRE(after->children == before->children);
+        }
+    }
+}
+
+TEST_CASE("Generated BatchParser parses buffers and files", "[GeneratedParser]") {
+    std::vector<std::string> sources;
+    for (unsigned seed = 0; seed < 16; ++seed) {
+        sources.push_back(DocumentMaker(seed).Make(2000));
+    }
+    sources[5] = "[1, 2.]";
+    json::BatchParser batch(4);
+
+    std::vector<std::string_view> buffers(sources.begin(), sources.end());
+    std::vector<json::BatchResult> results = batch.Parse(buffers);
+    REQUIRE(results.size() == sources.size());
+    for (size_t i = 0; i < sources.size(); ++i) {
+        if (i == 5) {
+            REQUIRE(results[i].status == -1);
+            REQUIRE_THROWS_AS(std::rethrow_exception(results[i].error), json::LexerError);
+            continue;
+        }
+        REQUIRE(results[i].status == 0);
+        REQUIRE_FALSE(results[i].error);
+        REQUIRE(Dump(*results[i].tree, sources[i]) == Parse(sources[i]));
+    }
+
+    std::filesystem::path file = std::filesystem::temp_directory_path() / "pargen_batch.json";
+    std::ofstream(file, std::ios::binary) << sources[0];
+    std::vector<std::string> filenames = {file.string(), (file / "missing").string()};
+    results = batch.ParseFiles(filenames);
+    std::filesystem::remove(file);
+    REQUIRE(results[0].status == 0);
+    REQUIRE(results[0].source->Data() == sources[0]);
+    REQUIRE(Dump(*results[0].tree, results[0].source->Data()) ==
+            Dump(*batch.Parse(std::vector<std::string_view>{results[0].source->Data()})[0].tree,
+                 results[0].source->Data()));
+    REQUIRE(results[1].status == -1);
+    REQUIRE_FALSE(results[1].tree);
+    REQUIRE_THROWS_AS(std::rethrow_exception(results[1].error), json::LexerError);
+}
+
+TEST_CASE("LineIndex locates the tokens of a generated lexer", "[GeneratedParser]") {
+    std::string source = DocumentMaker(3).Make(20000);
+    json::TokenStream tokens = json::LexPacked(source);
+    json::LineIndex lines(source);
+    size_t line = 1;
+    size_t column = 1;
+    size_t pos = 0;
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        json::Terminal token = tokens[i];
+        for (; source.data() + pos < token.repr.data(); ++pos) {
+            if (source[pos] == '\n') {
+                ++line;
+                column = 1;
+            } else {
+                ++column;
+            }
+        }
+        json::Position position = lines.Locate(token);
+        REQUIRE(position.line == line);
+        REQUIRE(position.column == column);
+    }
+    REQUIRE(lines.GetLineCount() == line + 1);
+    REQUIRE(lines.Locate(json::Terminal{}).line == lines.GetLineCount());
+}
+
+TEST_CASE("Generated UTF-8 validation agrees with a scalar decoder", "[GeneratedParser]") {
+    // malformed sequences, and valid ones at the edges of the ranges
+    static const std::string kSequences[] = {
+        "\xC0\x80", "\xC1\xBF", "\xE0\x80\x80", "\xE0\x9F\xBF", "\xF0\x80\x80\x80",
+        "\xF0\x8F\xBF\xBF", "\xED\xA0\x80", "\xED\xBF\xBF", "\xF4\x90\x80\x80",
+        "\xF5\x80\x80\x80", "\xFF", "\x80", "\xBF", "\xC3", "\xE2\x82", "\xF0\x9F\x98",
+        "\xC2\x80", "\xDF\xBF", "\xE0\xA0\x80", "\xED\x9F\xBF", "\xEE\x80\x80",
+        "\xEF\xBF\xBF", "\xF0\x90\x80\x80", "\xF4\x8F\xBF\xBF", "\xC3\xA9\xE2\x82\xAC",
+    };
+    // ASCII and multi-byte backgrounds, so that a sequence may follow a cut off
+    // character too
+    static const std::string kBackgrounds[] = {std::string(128, 'a'), "ё→😀a"};
+    for (const std::string &background : kBackgrounds) {
+        std::string text;
+        while (text.size() < 128) {
+            text += background;
+        }
+        for (const std::string &sequence : kSequences) {
+            // every offset around the 16- and 32-byte blocks, and the end
+            for (size_t offset = 0; offset <= 100; ++offset) {
+                for (size_t end : {offset + sequence.size(), text.size()}) {
+                    std::string input = text.substr(0, offset) + sequence + text.substr(offset);
+                    input.resize(std::max(end, offset + sequence.size()));
+                    REQUIRE(json::FindInvalidUtf8(input) == FindInvalidUtf8Reference(input));
+                }
+            }
+        }
+    }
+
+    std::mt19937 rng(40);
+    for (int i = 0; i < 2000; ++i) {
+        std::string input = kBackgrounds[1];
+        for (size_t k = rng() % 40; k > 0; --k) {
+            input += rng() % 4 == 0 ? kSequences[rng() % std::size(kSequences)] : kBackgrounds[1];
+        }
+        REQUIRE(json::FindInvalidUtf8(input) == FindInvalidUtf8Reference(input));
+    }
+
+    REQUIRE_THROWS_WITH(json::Lexer("[\"a\",\n \"\xED\xA0\x80\"]"), "Invalid UTF-8 at 2:3");
+    json::Lexer unchecked("\"\xFF\"", false);
+    json::Terminal token;
+    REQUIRE(unchecked.Next(token));
+}
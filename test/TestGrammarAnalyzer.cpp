@@ -162,3 +162,50 @@ TEST_CASE(
         REQUIRE(follow[NonTerminal{"S"}] == std::set<Terminal>({T_EOF}));
     }
 }
+
+TEST_CASE(
+    "GrammarAnalyzer recomputes only what an edit affects", "[GrammarAnalyzer]"
+) {
+    std::string before = R"(
+        id = [a-z]+
+        num = [0-9]+
+        <program> = <stmts>
+        <stmts> = <stmt> <stmts> | EPSILON
+        <stmt> = <decl> ';' | <expr> ';' | '{' <stmts> '}'
+        <decl> = <type> id | <type> id '=' <expr>
+        <type> = 'int' | 'bool'
+        <expr> = <expr> '+' <term> | <term>
+        <term> = <term> '*' <factor> | <factor>
+        <factor> = '(' <expr> ')' | id | num
+    )";
+    auto edit = [&](const std::string &from, const std::string &to) {
+        std::string result = before;
+        result.replace(result.find(from), from.size(), to);
+        return result;
+    };
+    std::vector<std::string> edits = {
+        before,
+        edit("'int' | 'bool'", "'int' | 'bool' | 'char'"),
+        edit("| id | num", "| id | num | '-' <factor>"),
+        edit("<stmt> <stmts> | EPSILON", "<stmt> <stmts> | <stmt>"),
+        edit("| '{' <stmts> '}'", ""),
+        edit(
+            "<type> id | <type> id '=' <expr>",
+            "<type> id <init>\n<init> = '=' <expr> | EPSILON"
+        ),
+    };
+
+    GrammarParser gp(MakeStream(before));
+    gp.Parse();
+    Grammar g = gp.Get();
+    GrammarAnalyzer ga(g);
+    for (const std::string &input : edits) {
+        GrammarParser edited_gp(MakeStream(input));
+        edited_gp.Parse();
+        Grammar edited = edited_gp.Get();
+        GrammarAnalyzer incremental(edited, ga);
+        GrammarAnalyzer scratch(edited);
+        REQUIRE(incremental.GetFirst() == scratch.GetFirst());
+        REQUIRE(incremental.GetFollow() == scratch.GetFollow());
+    }
+}
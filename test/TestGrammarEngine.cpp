@@ -0,0 +1,193 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <exception>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "GrammarEngine.h"
+
+namespace {
+const std::string kGrammar = R"(
+    IGNORE = [ \n]+
+    id = [a-z]+
+    num = [0-9]+
+    <stmt> = 'let' id '=' <expr> ';'
+    <expr> = <expr> '+' <term> | <term>
+    <term> = id | num | '(' <expr> ')'
+)";
+
+std::vector<std::string> Names(
+    const GrammarEngine &engine, const std::vector<GrammarEngine::Terminal> &tokens
+) {
+    std::vector<std::string> names;
+    for (const GrammarEngine::Terminal &token : tokens) {
+        names.push_back(engine.GetTerminalName(token.kind));
+    }
+    return names;
+}
+
+// Collects the lexemes of the terminals of a tree.
+class LexemeVisitor : public pargen::ParseTreePreorderVisitor<GrammarEngine::Tables> {
+public:
+    void VisitTerminal(const GrammarEngine::Terminal &t) override {
+        lexemes.push_back(t.repr);
+    }
+    void VisitNonTerminal(const GrammarEngine::NonTerminal &) override {
+    }
+
+    std::vector<std::string_view> lexemes;
+};
+}  // namespace
+
+TEST_CASE("GrammarEngine lexes like the generated lexer", "[GrammarEngine]") {
+    GrammarEngine engine(kGrammar);
+    std::vector<GrammarEngine::Terminal> tokens = engine.Lex("let lettuce = 12+(x) ;");
+    // quote terminals win ties, the longest match wins otherwise
+    REQUIRE(
+        Names(engine, tokens) ==
+        std::vector<std::string>{"let", "id", "=", "num", "+", "(", "id", ")", ";"}
+    );
+    REQUIRE(tokens[1].repr == "lettuce");
+    REQUIRE(engine.IsQuoteTerminal(tokens[0].kind));
+    REQUIRE_FALSE(engine.IsQuoteTerminal(tokens[1].kind));
+    // a byte no rule matches is an error, located like a parse error
+    REQUIRE_THROWS_WITH(engine.Lex("a\n #b"), "No token matches the input at 2:2");
+    REQUIRE(engine.GetTerminalName(0) == "$");
+}
+
+TEST_CASE("GrammarEngine parses with its tables", "[GrammarEngine]") {
+    GrammarEngine engine(kGrammar);
+    GrammarEngine::Parser parser = engine.CreateParser();
+
+    SECTION("From a lexer") {
+        std::string source = "let x = a + (1 + b);";
+        GrammarEngine::Lexer lexer(engine, source);
+        REQUIRE(parser.Parse(lexer) == 0);
+        GrammarEngine::ParseTree tree = parser.GetParseTree();
+        REQUIRE(tree.GetRoot()->width == 11);
+        const auto &root = std::get<GrammarEngine::NonTerminal>(tree.GetRoot()->value);
+        REQUIRE(engine.GetNonTerminalName(root.kind) == "stmt");
+    }
+
+    SECTION("Errors") {
+        REQUIRE(parser.Parse(engine.LexStream("let x = a + ;")) != 0);
+        REQUIRE(parser.Parse(engine.Lex("let = 1;")) < 0);
+        REQUIRE(parser.Parse(engine.Lex("let x = 1;")) == 0);
+    }
+
+    SECTION("Reparse") {
+        std::string before = "let x = a + b + c;";
+        std::string after = "let x = a + 7 + c;";
+        REQUIRE(parser.Parse(engine.Lex(before)) == 0);
+        GrammarEngine::ParseTree previous = parser.GetParseTree();
+        REQUIRE(parser.Reparse(engine.Lex(after), previous, pargen::TokenEdit{5, 1, 1}) == 0);
+        REQUIRE(parser.GetParseTree().GetRoot()->width == 9);
+        // reused subtrees no longer point into the previous buffer
+        LexemeVisitor visitor;
+        parser.GetParseTree().Accept(visitor);
+        REQUIRE(visitor.lexemes.size() == 9);
+        for (std::string_view lexeme : visitor.lexemes) {
+            REQUIRE(lexeme.data() >= after.data());
+            REQUIRE(lexeme.data() + lexeme.size() <= after.data() + after.size());
+        }
+    }
+}
+
+TEST_CASE("GrammarEngine flattens repetitions", "[GrammarEngine]") {
+    GrammarEngine engine(R"(
+        IGNORE = [ ]+
+        num = [0-9]+
+        <array> = '[' (num (',' num)*)? ']'
+    )");
+    GrammarEngine::Parser parser = engine.CreateParser();
+    std::string source = "[1";
+    for (int i = 0; i < 1000; ++i) {
+        source += ", 2";
+    }
+    source += "]";
+    REQUIRE(parser.Parse(engine.Lex(source)) == 0);
+
+    // array -> '[' opt ']', opt -> num list, list holds every ', num'
+    GrammarEngine::ParseTree tree = parser.GetParseTree();
+    const auto &opt = tree.GetRoot()->children[1];
+    REQUIRE(opt->children.size() == 2);
+    const auto &list = opt->children[1];
+    const auto &nt = std::get<GrammarEngine::NonTerminal>(list->value);
+    REQUIRE(engine.GetNonTerminalName(nt.kind) == "array.list1");
+    REQUIRE(list->children.size() == 2000);
+    REQUIRE(list->width == 2000);
+
+    SECTION("Reparse leaves the previous list as it was") {
+        std::string after = source;
+        after.insert(after.find(", 2"), ", 3");
+        REQUIRE(parser.Reparse(
+            engine.Lex(after), tree, pargen::TokenEdit{2, 0, 2}
+        ) == 0);
+        const auto &new_list = parser.GetParseTree().GetRoot()->children[1]->children[1];
+        REQUIRE(new_list->children.size() == 2002);
+        REQUIRE(list->children.size() == 2000);
+    }
+}
+
+TEST_CASE("GrammarEngine tables drive a BatchParser", "[GrammarEngine]") {
+    GrammarEngine engine(kGrammar);
+    GrammarEngine::BatchParser batch(engine.GetTables(), 4);
+    std::vector<std::string> sources;
+    for (int i = 0; i < 50; ++i) {
+        sources.push_back("let x = " + std::to_string(i) + (i % 7 == 3 ? " + ;" : ";"));
+    }
+
+    SECTION("Streams") {
+        std::vector<std::vector<GrammarEngine::Terminal>> streams;
+        for (const std::string &source : sources) {
+            streams.push_back(engine.Lex(source));
+        }
+        std::vector<GrammarEngine::BatchResult> results = batch.Parse(streams);
+        REQUIRE(results.size() == sources.size());
+        GrammarEngine::Parser parser = engine.CreateParser();
+        for (size_t i = 0; i < results.size(); ++i) {
+            REQUIRE(results[i].status == parser.Parse(streams[i]));
+            REQUIRE(results[i].tree.has_value() == (results[i].status >= 0));
+            REQUIRE_FALSE(results[i].error);
+        }
+        REQUIRE(results[0].tree->GetRoot()->width == 5);
+    }
+
+    SECTION("Buffers") {
+        sources[10] = "let x = #;";
+        std::vector<std::string_view> buffers(sources.begin(), sources.end());
+        std::vector<GrammarEngine::BatchResult> results = batch.Parse(buffers);
+        REQUIRE(results.size() == sources.size());
+        // the error of one input is kept in its result
+        REQUIRE(results[10].status == -1);
+        REQUIRE_FALSE(results[10].tree);
+        REQUIRE(results[10].error);
+        REQUIRE_THROWS_WITH(
+            std::rethrow_exception(results[10].error), "No token matches the input at 1:9"
+        );
+        REQUIRE(results[11].status == 0);
+        LexemeVisitor visitor;
+        results[11].tree->Accept(visitor);
+        REQUIRE(visitor.lexemes[3] == "11");
+        REQUIRE(visitor.lexemes[3].data() == sources[11].data() + 8);
+    }
+}
+
+TEST_CASE("GrammarEngine keeps the warnings of the grammar", "[GrammarEngine]") {
+    REQUIRE(GrammarEngine(kGrammar).GetWarnings().empty());
+    GrammarEngine engine(R"(
+        EPSILON = [a-z]+
+        <S> = 'a'
+    )");
+    REQUIRE(engine.GetWarnings().size() == 1);
+    REQUIRE(engine.GetWarnings()[0].find("changing EPSILON is not allowed") != std::string::npos);
+}
+
+TEST_CASE("GrammarEngine reports bad grammars", "[GrammarEngine]") {
+    REQUIRE_THROWS_AS(GrammarEngine("<S> = <A>"), GrammarEngineError);
+    REQUIRE_THROWS_AS(GrammarEngine("<E> = <E> '+' <E> | 'x'"), GrammarEngineError);
+    REQUIRE_THROWS_AS(GrammarEngine("x = [a-\n<S> = x"), GrammarEngineError);
+}
@@ -0,0 +1,172 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include <algorithm>
+
+#include "BNFParser.h"
+#include "Entities.h"
+#include "GrammarAnalyzer.h"
+#include "GrammarOptimizer.h"
+#include "Helpers.h"
+#include "TableBuilder.h"
+#include "TestHelpers.h"
+
+namespace {
+Grammar ParseGrammar(const std::string &input) {
+    GrammarParser gp(MakeStream(input));
+    gp.Parse();
+    return gp.Get();
+}
+
+bool Defines(const Grammar &g, const std::string &name) {
+    return std::any_of(g.rules_.begin(), g.rules_.end(), [&](const Rule &rule) {
+        return rule.lhs == NonTerminal{name};
+    });
+}
+}  // namespace
+
+TEST_CASE("GrammarOptimizer removes useless symbols", "[GrammarOptimizer]") {
+    Grammar g = ParseGrammar(R"(
+        <S> = 'a' <A> | 'b' <B>
+        <A> = 'x'
+        <B> = <B> 'y'
+        <C> = 'z'
+    )");
+    OptimizerOptions options;
+    options.inline_single_use = false;
+    GrammarOptimizer optimizer(g, options);
+    REQUIRE_NOTHROW(optimizer.Optimize());
+    const Grammar &optimized = optimizer.Get();
+
+    REQUIRE(optimized.rules_.size() == 3);
+    REQUIRE_FALSE(Defines(optimized, "B"));
+    REQUIRE_FALSE(Defines(optimized, "C"));
+    REQUIRE_FALSE(optimized.tokens_.contains(NonTerminal{"C"}));
+    // terminals still take part in lexing
+    REQUIRE(optimized.tokens_.contains(Terminal{"z"}));
+    REQUIRE(
+        optimizer.GetReport() == std::vector<std::string>{
+                                     "Removed unproductive <B>",
+                                     "Removed unreachable <C>"
+                                 }
+    );
+}
+
+TEST_CASE("GrammarOptimizer merges and inlines", "[GrammarOptimizer]") {
+    Grammar g = ParseGrammar(R"(
+        id = [a-z]+
+        <S> = <list> ';' <other>
+        <list> = <list> ',' <item> | <item>
+        <other> = <other> ',' <entry> | <entry>
+        <item> = id '=' id
+        <entry> = id '=' id
+    )");
+    GrammarOptimizer optimizer(g);
+    optimizer.Optimize();
+    const Grammar &optimized = optimizer.Get();
+
+    // <entry> is merged into <item>, then <other> into <list>
+    REQUIRE_FALSE(Defines(optimized, "entry"));
+    REQUIRE_FALSE(Defines(optimized, "other"));
+    REQUIRE(
+        optimized.rules_[1].prod ==
+        Production{NonTerminal{"list"}, Terminal{";"}, NonTerminal{"list"}}
+    );
+    // <item> is then used twice, so it stays
+    REQUIRE(Defines(optimized, "item"));
+    REQUIRE(optimized.rules_.size() == 5);
+
+    SECTION("Inlining") {
+        Grammar single = ParseGrammar(R"(
+            <S> = '(' <body> ')'
+            <body> = <head> 'b'
+            <head> = 'a'
+        )");
+        GrammarOptimizer inliner(single);
+        inliner.Optimize();
+        REQUIRE(inliner.Get().rules_.size() == 2);
+        REQUIRE(
+            inliner.Get().rules_[1].prod ==
+            Production{Terminal{"("}, Terminal{"a"}, Terminal{"b"}, Terminal{")"}}
+        );
+    }
+}
+
+TEST_CASE("GrammarOptimizer rewrites right recursion", "[GrammarOptimizer]") {
+    Grammar g = ParseGrammar(R"(
+        num = [0-9]+
+        <S> = '[' num <nums> ']' <tail>
+        <nums> = ',' num <nums> | EPSILON
+        <tail> = '+' <tail> | '.'
+    )");
+    OptimizerOptions options;
+    options.left_recursion = true;
+    GrammarOptimizer optimizer(g, options);
+    optimizer.Optimize();
+    const Grammar &optimized = optimizer.Get();
+
+    // with only the empty base, the non-terminal itself becomes a list
+    REQUIRE(optimized.lists_.contains(NonTerminal{"nums"}));
+    REQUIRE(
+        optimized.rules_[2].prod ==
+        Production{NonTerminal{"nums"}, Terminal{","}, Terminal{"num", " "}}
+    );
+    // otherwise a list of the heads precedes the base, and <tail> is left
+    // with a single rule to inline
+    NonTerminal list{"tail.list1"};
+    REQUIRE(optimized.lists_.contains(list));
+    REQUIRE_FALSE(Defines(optimized, "tail"));
+    REQUIRE(optimized.rules_[1].prod.back() == Token{Terminal{"."}});
+    REQUIRE(optimized.rules_[4].prod == Production{list, Terminal{"+"}});
+    REQUIRE(optimized.rules_[5].prod == Production{EPSILON});
+
+    // the grammar stays LR(1)
+    GrammarAnalyzer ga(optimized);
+    ParserTables tables(optimized, ga);
+    REQUIRE_NOTHROW(tables.Generate());
+}
+
+TEST_CASE(
+    "GrammarOptimizer keeps right recursion whose rewrite conflicts",
+    "[GrammarOptimizer]"
+) {
+    Grammar g = ParseGrammar(R"(
+        <s> = <a> | 'x' 'c'
+        <a> = 'x' <a> | 'b'
+    )");
+    OptimizerOptions options;
+    options.left_recursion = true;
+    GrammarOptimizer optimizer(g, options);
+    optimizer.Optimize();
+    const Grammar &optimized = optimizer.Get();
+
+    // the empty list would have to be reduced on the 'x' that <s> shifts
+    REQUIRE(optimized.lists_.empty());
+    REQUIRE(Defines(optimized, "a"));
+    REQUIRE(
+        std::count(
+            optimizer.GetReport().begin(), optimizer.GetReport().end(),
+            "Kept <a> right-recursive, as the rewrite conflicts"
+        ) == 1
+    );
+    GrammarAnalyzer ga(optimized);
+    ParserTables tables(optimized, ga);
+    REQUIRE_NOTHROW(tables.Generate());
+}
+
+TEST_CASE(
+    "GrammarOptimizer throws on an unproductive start symbol",
+    "[GrammarOptimizerErrors]"
+) {
+    Grammar g = ParseGrammar(R"(
+        <S> = <S> 'a'
+    )");
+    GrammarOptimizer optimizer(g);
+    REQUIRE_THROWS_WITH(
+        optimizer.Optimize(),
+        Catch::Matchers::ContainsSubstring("derives no string")
+    );
+}
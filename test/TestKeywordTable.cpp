@@ -0,0 +1,54 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "KeywordTable.h"
+
+TEST_CASE("KeywordTable finds exactly the stored words", "[KeywordTable]") {
+    std::vector<std::string> words = {
+        "SELECT", "FROM",   "WHERE", "AND",    "OR",     "NOT",
+        "INSERT", "INTO",   "VALUES", "UPDATE", "SET",    "DELETE",
+        "if",     "else",   "while", "for",    "return", "function",
+        "var",    "let",    "const", "true",   "false",  "null",
+    };
+    KeywordTable table(words);
+
+    for (size_t i = 0; i < words.size(); ++i) {
+        INFO(words[i]);
+        REQUIRE(table.Find(words[i]) == static_cast<int>(i));
+    }
+    for (std::string word :
+         {"", "S", "SELEC", "SELECTS", "select", "iff", "x", "functions"}) {
+        INFO(word);
+        REQUIRE(table.Find(word) == KeywordTable::kEmptySlot);
+    }
+
+    size_t slot_count = table.GetSlotCount();
+    REQUIRE(slot_count >= 2 * words.size());
+    REQUIRE((slot_count & (slot_count - 1)) == 0);
+    size_t used = 0;
+    for (int index : table.GetSlots()) {
+        used += index != KeywordTable::kEmptySlot;
+    }
+    REQUIRE(used == words.size());
+}
+
+TEST_CASE("KeywordTable handles edge cases", "[KeywordTable]") {
+    SECTION("No words") {
+        KeywordTable table({});
+        REQUIRE(table.Find("anything") == KeywordTable::kEmptySlot);
+        REQUIRE(table.Find("") == KeywordTable::kEmptySlot);
+    }
+
+    SECTION("Many similar words") {
+        std::vector<std::string> words;
+        for (size_t i = 0; i < 2000; ++i) {
+            words.push_back("kw" + std::to_string(i));
+        }
+        KeywordTable table(words);
+        for (size_t i = 0; i < words.size(); ++i) {
+            REQUIRE(table.Find(words[i]) == static_cast<int>(i));
+        }
+        REQUIRE(table.Find("kw2000") == KeywordTable::kEmptySlot);
+    }
+}
@@ -0,0 +1,181 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "LRParser.h"
+#include "LineIndex.h"
+
+namespace {
+// The tables of S' -> S, S -> a S | a, written out by hand in the layout the
+// generator emits. Terminal 2 is not used by the grammar.
+struct Terminal {
+    uint32_t kind = 0;
+    std::string_view repr;
+
+    std::string_view Name() const {
+        return kind == 0 ? "$" : kind == 1 ? "a" : "b";
+    }
+};
+
+struct NonTerminal {
+    uint32_t kind = 0;
+};
+
+struct TokenStream {
+    std::vector<Terminal> tokens;
+    std::string_view source;
+
+    size_t size() const {
+        return tokens.size();
+    }
+    const Terminal &operator[](size_t i) const {
+        return tokens[i];
+    }
+    std::string_view GetSource() const {
+        return source;
+    }
+};
+
+struct Tables {
+    using Terminal = ::Terminal;
+    using NonTerminal = ::NonTerminal;
+    using TokenStream = ::TokenStream;
+    using LineIndex = pargen::LineIndex;
+
+    // shift is `state << 2 | 1`, reduce is `rule << 2 | 2`, accept is 3
+    static constexpr uint8_t kActions[4][3] = {
+        {0, 9, 0}, {3, 0, 0}, {10, 9, 0}, {6, 0, 0}
+    };
+    static constexpr uint8_t kGoto[4][2] = {{1, 0}, {0, 0}, {3, 0}, {0, 0}};
+    static constexpr uint8_t kRuleLhs[3] = {1, 0, 0};
+    static constexpr uint8_t kRuleLength[3] = {1, 2, 1};
+    static constexpr uint64_t kFollow[2][1] = {{1}, {1}};
+};
+
+using Parser = pargen::LRParser<Tables>;
+using Node = pargen::ParseTreeNode<Tables>;
+
+// Yields the characters of a string as tokens.
+class CharLexer {
+public:
+    explicit CharLexer(std::string_view source) : source_(source) {}
+
+    bool Next(Terminal &token) {
+        if (pos_ == source_.size()) {
+            return false;
+        }
+        token = Terminal{source_[pos_] == 'a' ? 1u : 2u, source_.substr(pos_, 1)};
+        ++pos_;
+        return true;
+    }
+
+    std::string_view GetSource() const {
+        return source_;
+    }
+
+private:
+    std::string_view source_;
+    size_t pos_ = 0;
+};
+
+std::vector<Terminal> Tokens(size_t count) {
+    return std::vector<Terminal>(count, Terminal{1, "a"});
+}
+
+class CountingVisitor : public pargen::ParseTreePreorderVisitor<Tables> {
+public:
+    void VisitTerminal(const Terminal &) override {
+        ++terminals;
+    }
+    void VisitNonTerminal(const NonTerminal &) override {
+        ++non_terminals;
+    }
+
+    size_t terminals = 0;
+    size_t non_terminals = 0;
+};
+}  // namespace
+
+TEST_CASE("LRParser parses with the given tables", "[LRParser]") {
+    Parser parser;
+
+    SECTION("Vector of tokens") {
+        REQUIRE(parser.Parse(Tokens(3)) == 0);
+        pargen::ParseTree<Tables> tree = parser.GetParseTree();
+        REQUIRE_FALSE(tree.HasErrors());
+        REQUIRE(tree.GetRoot()->width == 3);
+
+        CountingVisitor visitor;
+        tree.Accept(visitor);
+        REQUIRE(visitor.terminals == 3);
+        REQUIRE(visitor.non_terminals == 3);
+    }
+
+    SECTION("Token stream") {
+        TokenStream stream{Tokens(2), "aa"};
+        REQUIRE(parser.Parse(stream) == 0);
+        REQUIRE(parser.GetParseTree().GetRoot()->width == 2);
+    }
+
+    SECTION("Pull lexer") {
+        CharLexer lexer("aaaa");
+        REQUIRE(parser.Parse(lexer) == 0);
+        REQUIRE(parser.GetParseTree().GetRoot()->width == 4);
+    }
+
+    SECTION("Errors") {
+        REQUIRE(parser.Parse(std::vector<Terminal>{}) < 0);
+        // nothing was shifted, so the tree has no root
+        pargen::ParseTree<Tables> empty = parser.GetParseTree();
+        REQUIRE(empty.GetRoot() == nullptr);
+        REQUIRE(empty.HasErrors());
+        CountingVisitor visitor;
+        empty.Accept(visitor);
+        REQUIRE(visitor.terminals == 0);
+        CharLexer lexer("ab");
+        REQUIRE(parser.Parse(lexer) < 0);
+        // the parser is reusable after an error
+        REQUIRE(parser.Parse(Tokens(1)) == 0);
+    }
+}
+
+TEST_CASE("LRParser reuses subtrees when reparsing", "[LRParser]") {
+    Parser parser;
+    REQUIRE(parser.Parse(Tokens(3)) == 0);
+    pargen::ParseTree<Tables> previous = parser.GetParseTree();
+
+    // a a a -> a a a a, the new token inserted in front
+    REQUIRE(parser.Reparse(Tokens(4), previous, pargen::TokenEdit{0, 0, 1}) == 0);
+    pargen::ParseTree<Tables> tree = parser.GetParseTree();
+    REQUIRE(tree.GetRoot()->width == 4);
+    // S(a, S(a, S(a, S(a)))) keeps the old S(a, S(a)) of tokens 1 and 2
+    const Node &inner = *tree.GetRoot()->children[1];
+    REQUIRE(inner.children[1] == previous.GetRoot()->children[1]);
+}
+
+TEST_CASE("LineIndex locates bytes and tokens", "[LRParser]") {
+    std::string source = "ab\n\ncd\ne";
+    pargen::LineIndex index(source);
+    REQUIRE(index.GetLineCount() == 4);
+    REQUIRE(index.GetLine(1) == "ab");
+    REQUIRE(index.GetLine(2).empty());
+    REQUIRE(index.GetLine(4) == "e");
+
+    pargen::Position position = index.Locate(5);
+    REQUIRE(position.line == 3);
+    REQUIRE(position.column == 2);
+    // a newline belongs to the line it ends
+    REQUIRE(index.Locate(2).line == 1);
+    position = index.Locate(Terminal{1, std::string_view(source).substr(7, 1)});
+    REQUIRE(position.line == 4);
+    REQUIRE(position.column == 1);
+    // the end of input is placed after the last byte
+    position = index.Locate(Terminal{});
+    REQUIRE(position.line == 4);
+    REQUIRE(position.column == 2);
+}
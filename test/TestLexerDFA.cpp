@@ -0,0 +1,169 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "LexerDFA.h"
+
+namespace {
+// the matched length and rule for a single regex
+std::pair<size_t, int> MatchOne(
+    const std::string &regex, const std::string &s
+) {
+    LexerDFA dfa({LexerRule{regex}});
+    return dfa.Match(s);
+}
+}  // namespace
+
+TEST_CASE("Regex syntax is compiled correctly", "[Regex]") {
+    using Result = std::pair<size_t, int>;
+    const Result none = {0, -1};
+
+    SECTION("Literals, concatenation and alternation") {
+        REQUIRE(MatchOne("abc", "abcd") == Result{3, 0});
+        REQUIRE(MatchOne("abc", "abd") == none);
+        REQUIRE(MatchOne("ab|cd", "cd") == Result{2, 0});
+        REQUIRE(MatchOne("a(b|c)d", "acd") == Result{3, 0});
+    }
+
+    SECTION("Repetitions") {
+        REQUIRE(MatchOne("a*", "aaab") == Result{3, 0});
+        REQUIRE(MatchOne("a*", "b") == none);
+        REQUIRE(MatchOne("ba+", "baa") == Result{3, 0});
+        REQUIRE(MatchOne("ba+", "b") == none);
+        REQUIRE(MatchOne("-?[0-9]+", "-42") == Result{3, 0});
+        REQUIRE(MatchOne("a{3}", "aaaa") == Result{3, 0});
+        REQUIRE(MatchOne("a{3}", "aa") == none);
+        REQUIRE(MatchOne("a{2,}", "aaaaa") == Result{5, 0});
+        REQUIRE(MatchOne("a{1,2}b", "aab") == Result{3, 0});
+        REQUIRE(MatchOne("a{1,2}b", "aaab") == none);
+        REQUIRE(MatchOne("(ab){2}", "ababab") == Result{4, 0});
+        REQUIRE(MatchOne("(a|bc)+{2}", "abca") == Result{4, 0});
+    }
+
+    SECTION("Character classes") {
+        REQUIRE(MatchOne("[a-c]+", "abcd") == Result{3, 0});
+        REQUIRE(MatchOne("[^\"]*x", "ab\"x") == none);
+        REQUIRE(MatchOne("[]]", "]") == Result{1, 0});
+        REQUIRE(MatchOne("[a-]+", "a-a") == Result{3, 0});
+        REQUIRE(MatchOne("[[:digit:]x]+", "1x2y") == Result{3, 0});
+        REQUIRE(MatchOne(".+", "ab\ncd") == Result{2, 0});
+        REQUIRE(MatchOne("\\s+", " \t\n x") == Result{4, 0});
+        REQUIRE(MatchOne("\\d\\w", "1_") == Result{2, 0});
+        REQUIRE(MatchOne("\\S+", "ab c") == Result{2, 0});
+    }
+
+    SECTION("Escapes and quotes") {
+        REQUIRE(MatchOne("\\\"[^\\\"]*\\\"", "\"str\" x") == Result{5, 0});
+        REQUIRE(MatchOne("\"a+\"", "a+") == Result{2, 0});
+        REQUIRE(MatchOne("\"a+\"", "aa") == none);
+        REQUIRE(MatchOne("\\.\\x41\\101\\n", ".AA\n") == Result{4, 0});
+        REQUIRE(MatchOne("a+   ", "aa") == Result{2, 0});
+    }
+
+    SECTION("Unicode") {
+        REQUIRE(MatchOne("[а-я]+", "привет мир") == Result{12, 0});
+        REQUIRE(MatchOne("[а-я]+", "Привет") == none);
+        REQUIRE(MatchOne("ё+", "ёёё") == Result{6, 0});
+        REQUIRE(MatchOne("\\p{L}+", "Grüße!") == Result{7, 0});
+        REQUIRE(MatchOne("\\P{L}", "1") == Result{1, 0});
+        REQUIRE(MatchOne("\\P{L}", "ж") == none);
+        REQUIRE(MatchOne("[^а-я]", "я") == none);
+        REQUIRE(MatchOne("[^а-я]", "\xE2\x86\x92") == Result{3, 0});
+        REQUIRE(MatchOne("[^а-я]", "\xD1") == none);
+        REQUIRE(MatchOne("\\u{2192}|\"\\u{2190}\"", "←") == Result{3, 0});
+        REQUIRE(MatchOne("[\\p{Lu}_][\\p{Ll}\\d]*", "Ωmega2") == Result{7, 0});
+    }
+
+    SECTION("Literal strings") {
+        REQUIRE(RegexParser("a+\\n", true).GetLiteralString() == "a+\n");
+        REQUIRE(RegexParser("\\x41\\\\", true).GetLiteralString() == "A\\");
+        REQUIRE_FALSE(RegexParser("\\d", true).GetLiteralString());
+        REQUIRE_FALSE(RegexParser("abc").GetLiteralString());
+        REQUIRE(RegexParser("\\u{451}", true).GetLiteralString() == "ё");
+    }
+
+    SECTION("Errors") {
+        for (std::string regex :
+             {"", "(a", "a)", "[a", "*a", "a{2", "a{3,1}", "{name}", "a/b",
+              "^a", "a$", "[z-a]", "\\", "\"a", "a b", "[[:nope:]]",
+              "\\p{Greek}", "\\pL", "\\u{D800}", "\\u{110000}", "\\u{}",
+              "[я-а]", "[\\p{L}-я]"}) {
+            INFO(regex);
+            REQUIRE_THROWS_AS(LexerDFA({LexerRule{regex}}), RegexError);
+        }
+    }
+}
+
+TEST_CASE("LexerDFA resolves conflicts between rules", "[LexerDFA]") {
+    LexerDFA dfa({
+        LexerRule{"if", true},
+        LexerRule{"+", true},
+        LexerRule{"++", true},
+        LexerRule{"\\n", true},
+        LexerRule{"[a-z]+"},
+        LexerRule{"[0-9]+"},
+        LexerRule{"[ \\t]+"},
+    });
+
+    SECTION("Longest match wins") {
+        REQUIRE(dfa.Match("iff") == std::pair<size_t, int>{3, 4});
+        REQUIRE(dfa.Match("+++") == std::pair<size_t, int>{2, 2});
+        REQUIRE(dfa.Match("123abc") == std::pair<size_t, int>{3, 5});
+    }
+
+    SECTION("Earlier rule wins on equal length") {
+        REQUIRE(dfa.Match("if") == std::pair<size_t, int>{2, 0});
+        REQUIRE(dfa.Match("if x") == std::pair<size_t, int>{2, 0});
+    }
+
+    SECTION("Literals interpret escapes only") {
+        REQUIRE(dfa.Match("\n") == std::pair<size_t, int>{1, 3});
+        REQUIRE(dfa.Match("?") == std::pair<size_t, int>{0, -1});
+    }
+
+    SECTION("Tables are minimal and compact") {
+        REQUIRE(dfa.GetAccept(LexerDFA::kDeadState) == -1);
+        for (size_t cls = 0; cls < dfa.GetClassCount(); ++cls) {
+            REQUIRE(
+                dfa.GetTransition(LexerDFA::kDeadState, cls) ==
+                LexerDFA::kDeadState
+            );
+        }
+        // letters other than `i` and `f` are indistinguishable, as are digits
+        REQUIRE(dfa.GetClass('a') == dfa.GetClass('z'));
+        REQUIRE(dfa.GetClass('a') != dfa.GetClass('i'));
+        REQUIRE(dfa.GetClass('0') == dfa.GetClass('9'));
+        REQUIRE(dfa.GetClass(' ') == dfa.GetClass('\t'));
+        // `i`, `f`, other letters, `+`, newline, digits, blanks, the rest
+        REQUIRE(dfa.GetClassCount() == 8);
+        // dead, start, `i`, `if`, identifier, `+`, `++`, newline, number,
+        // whitespace
+        REQUIRE(dfa.GetStateCount() == 10);
+    }
+}
+
+TEST_CASE("LexerDFA merges equivalent states", "[LexerDFA]") {
+    // both alternatives lead to the same language after the first byte
+    LexerDFA dfa({LexerRule{"(a|b)c*"}});
+    REQUIRE(dfa.GetClass('a') == dfa.GetClass('b'));
+    REQUIRE(dfa.GetStateCount() == 3);
+    REQUIRE(dfa.Match("bccc") == std::pair<size_t, int>{4, 0});
+}
+
+TEST_CASE("LexerDFA reports the bytes states loop on", "[LexerDFA]") {
+    LexerDFA dfa({LexerRule{"\\\"[^\\\"]*\\\""}, LexerRule{"[0-9]+"}});
+    size_t string_body = dfa.GetTransition(dfa.GetStart(), dfa.GetClass('"'));
+    size_t number = dfa.GetTransition(dfa.GetStart(), dfa.GetClass('7'));
+
+    CharSet body_loop = dfa.GetLoopBytes(string_body);
+    REQUIRE(body_loop.count() == 255);
+    REQUIRE_FALSE(body_loop['"']);
+
+    CharSet number_loop = dfa.GetLoopBytes(number);
+    REQUIRE(number_loop.count() == 10);
+    REQUIRE(number_loop['0']);
+    REQUIRE(number_loop['9']);
+
+    REQUIRE(dfa.GetLoopBytes(dfa.GetStart()).none());
+    REQUIRE(dfa.GetLoopBytes(LexerDFA::kDeadState).all());
+}
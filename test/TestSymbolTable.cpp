@@ -0,0 +1,46 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "BNFParser.h"
+#include "Helpers.h"
+#include "SymbolTable.h"
+#include "TestHelpers.h"
+
+TEST_CASE("SymbolTable numbers symbols of a grammar", "[SymbolTable]") {
+    std::string input = R"(
+        int = [0-9]+
+        <S> = <T> <E>
+        <E> = '+' <T> <E> | EPSILON
+        <T> = int
+    )";
+
+    GrammarParser gp(MakeStream(input));
+    REQUIRE_NOTHROW(gp.Parse());
+    SymbolTable symbols(gp.Get());
+
+    SECTION("Terminals") {
+        const std::vector<Terminal> &terminals = symbols.GetTerminals();
+        REQUIRE(terminals.size() == 3);  // $, '+', int
+        REQUIRE(terminals[0] == T_EOF);
+        REQUIRE(symbols.GetTerminalId(T_EOF) == 0);
+        size_t int_id = symbols.GetTerminalId(Terminal{"int", " "});
+        REQUIRE(terminals[int_id].repr_ == "[0-9]+");
+        REQUIRE(symbols.GetTerminalId("R_int") == int_id);
+        REQUIRE(terminals[symbols.GetTerminalId(Terminal{"+"})].IsQuote());
+        REQUIRE_THROWS_AS(
+            symbols.GetTerminalId(EPSILON), std::out_of_range
+        );
+    }
+
+    SECTION("Non-terminals") {
+        const std::vector<NonTerminal> &nonterminals = symbols.GetNonTerminals();
+        REQUIRE(nonterminals.size() == 4);  // S', S, E, T
+        REQUIRE(nonterminals[0] == NonTerminal{"S'"});
+        REQUIRE(symbols.GetNonTerminalId(NonTerminal{"S"}) == 1);
+        REQUIRE(symbols.GetNonTerminalId(NonTerminal{"T"}) == 3);
+        REQUIRE_THROWS_AS(
+            symbols.GetNonTerminalId(NonTerminal{"X"}), std::out_of_range
+        );
+    }
+}
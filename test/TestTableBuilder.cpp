@@ -49,3 +49,81 @@ TEST_CASE("TableBuilder detects ambiguous grammar", "[TableBuilder]") {
     ParserTables tables(g, ga);
     REQUIRE_THROWS_AS(tables.Generate(), TableGeneratorError);
 }
+
+TEST_CASE(
+    "TableBuilder builds the same tables incrementally", "[TableBuilder]"
+) {
+    std::string before = R"(
+        int = [0-9]+
+        <S> = <T> <E>
+        <E> = '+' <T> <E> | EPSILON
+        <T> = int
+    )";
+    std::string after = R"(
+        int = [0-9]+
+        <S> = <T> <E>
+        <E> = '+' <T> <E> | '-' <T> <E> | EPSILON
+        <T> = int | '(' <S> ')'
+    )";
+
+    GrammarParser gp(MakeStream(before));
+    gp.Parse();
+    Grammar g = gp.Get();
+    GrammarAnalyzer ga(g);
+    ParserTables tables(g, ga);
+    tables.Generate();
+
+    GrammarParser edited_gp(MakeStream(after));
+    edited_gp.Parse();
+    Grammar edited = edited_gp.Get();
+    GrammarAnalyzer edited_ga(edited, ga);
+    ParserTables incremental(edited, edited_ga, tables);
+    REQUIRE_NOTHROW(incremental.Generate());
+    ParserTables scratch(edited, edited_ga);
+    scratch.Generate();
+
+    ActionTable action = incremental.GetActionTable();
+    ActionTable expected = scratch.GetActionTable();
+    REQUIRE(action.size() == expected.size());
+    for (size_t i = 0; i < action.size(); ++i) {
+        REQUIRE(action[i].size() == expected[i].size());
+        for (const auto &[key, entry] : expected[i]) {
+            REQUIRE(action[i].at(key).type_ == entry.type_);
+            REQUIRE(action[i].at(key).value_ == entry.value_);
+        }
+    }
+    REQUIRE(incremental.GetGotoTable() == scratch.GetGotoTable());
+    REQUIRE(incremental.GetAutomaton().GetReusedClosureCount() > 0);
+}
+
+TEST_CASE(
+    "TableBuilder keeps the tables after releasing the automaton",
+    "[TableBuilder]"
+) {
+    std::string input = R"(
+        int = [0-9]+
+        <S> = <T> <E>
+        <E> = '+' <T> <E> | EPSILON
+        <T> = int
+    )";
+
+    GrammarParser gp(MakeStream(input));
+    gp.Parse();
+    Grammar g = gp.Take();
+    GrammarAnalyzer ga(g);
+    ParserTables tables(g, ga);
+    tables.Generate();
+    ActionTable action = tables.GetActionTable();
+    GotoTable gotoTable = tables.GetGotoTable();
+
+    tables.ReleaseAutomaton();
+    REQUIRE(tables.GetAutomaton().GetStates().empty());
+    REQUIRE(tables.GetActionTable().size() == action.size());
+    REQUIRE(tables.GetGotoTable() == gotoTable);
+
+    // tables built from released ones start from scratch
+    ParserTables rebuilt(g, ga, tables);
+    REQUIRE_NOTHROW(rebuilt.Generate());
+    REQUIRE(rebuilt.GetGotoTable() == gotoTable);
+    REQUIRE(rebuilt.GetAutomaton().GetReusedClosureCount() == 0);
+}